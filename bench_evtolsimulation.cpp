@@ -0,0 +1,132 @@
+/**
+ * File : bench_evtolsimulation.cpp
+ * Benchmarks for the eVTOL simulation library.
+ *
+ * Runs whole scenarios against a VirtualClock so the measurements reflect
+ * engine cost rather than simulated charging delays.
+ *
+ * Uses Google Benchmark.
+ */
+
+#include "evtolengine.h"
+#include "evtolrandom.h"
+#include "evtolsimulation.h"
+#include "evtolstepper.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+// Full default scenario: 20 vehicles, 3 chargers, 3 hours.
+static void BM_DefaultScenario(benchmark::State &state) {
+    for (auto _ : state) {
+        VirtualClock clock;
+        Scenario scenario;
+        scenario.seed = 1;
+        SimulationManager sim(scenario, clock);
+        sim.deployVehicles();
+        sim.startSimulation();
+        benchmark::DoNotOptimize(sim.results());
+    }
+}
+BENCHMARK(BM_DefaultScenario)->Unit(benchmark::kMicrosecond);
+
+// Same scenario on a warm discrete-event context, as an embedding caller would run it.
+static void BM_EngineDefaultScenario(benchmark::State &state) {
+    Scenario scenario;
+    scenario.seed = 1;
+    scenario.vehicle_count = static_cast<int>(state.range(0));
+    SimulationContext context;
+    for (auto _ : state) {
+        context.run(scenario);
+        benchmark::DoNotOptimize(context.vehicles().passenger_miles.data());
+    }
+    state.SetItemsProcessed(state.iterations() * context.eventsProcessed());
+}
+BENCHMARK(BM_EngineDefaultScenario)->Arg(20)->Arg(1000)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// Mission mode: one event per trip, trip lengths drawn in batches.
+static void BM_EngineMissions(benchmark::State &state) {
+    Scenario scenario;
+    scenario.seed = 1;
+    scenario.vehicle_count = static_cast<int>(state.range(0));
+    scenario.chargers = scenario.vehicle_count / 5;
+    scenario.horizon_hours = 24;
+    scenario.missions.enabled = true;
+    scenario.missions.mean_miles = 15;
+    SimulationContext context;
+    uint64_t trips = 0;
+    for (auto _ : state) {
+        context.run(scenario);
+        trips = 0;
+        for (int t : context.vehicles().trips) trips += t;
+    }
+    state.counters["trips"] = static_cast<double>(trips);
+    state.SetItemsProcessed(state.iterations() * context.eventsProcessed());
+}
+BENCHMARK(BM_EngineMissions)->Arg(1000)->Arg(50000)->Unit(benchmark::kMillisecond);
+
+// Demand mode: a day of requests over a 10x10 vertiport grid.
+static void BM_EngineDemand(benchmark::State &state) {
+    Scenario scenario;
+    scenario.seed = 1;
+    scenario.vehicle_count = static_cast<int>(state.range(0));
+    scenario.horizon_hours = 24;
+    scenario.demand.enabled = true;
+    for (int i = 0; i < 100; i++) {
+        scenario.demand.vertiports.push_back({(i % 10) * 8.0, (i / 10) * 8.0, scenario.vehicle_count / 200 + 1, 1.0});
+    }
+    scenario.demand.hourly_rate = {static_cast<double>(state.range(1)) / 24};
+    scenario.demand.max_deadhead_miles = 20;
+    SimulationContext context;
+    for (auto _ : state) {
+        context.run(scenario);
+    }
+    state.counters["requests"] = static_cast<double>(context.demandStats().requests);
+    state.counters["served"] = static_cast<double>(context.demandStats().served);
+    state.SetItemsProcessed(state.iterations() * context.eventsProcessed());
+}
+BENCHMARK(BM_EngineDemand)->Args({10000, 100000})->Args({100000, 1000000})->Unit(benchmark::kMillisecond);
+
+// Fixed-step engine on a huge homogeneous fleet, one kernel per argument (1 scalar, 2 AVX2, 3 AVX-512).
+static void BM_SteppedFleet(benchmark::State &state) {
+    Scenario scenario;
+    scenario.seed = 1;
+    scenario.fleet_mix = {static_cast<int>(state.range(0))};
+    scenario.chargers = static_cast<int>(state.range(0) / 5);
+    SteppedContext context(static_cast<SimdLevel>(state.range(1)));
+    std::string error;
+    for (auto _ : state) {
+        context.run(scenario, 0.01, error);
+        benchmark::DoNotOptimize(context.stats().passenger_miles);
+    }
+    state.SetLabel(context.kernel() == SimdLevel::Avx512 ? "avx512" : context.kernel() == SimdLevel::Avx2 ? "avx2"
+                                                                                                            : "scalar");
+    state.SetItemsProcessed(state.iterations() * context.stats().steps * context.stats().vehicles);
+    state.SetBytesProcessed(state.iterations() * context.stats().steps * context.stats().vehicles * 56);
+}
+BENCHMARK(BM_SteppedFleet)->Args({1000000, 1})->Args({1000000, 2})->Args({1000000, 3})->Unit(benchmark::kMillisecond);
+
+// Fault-check uniforms: range(0) = 0 for std::mt19937 with a distribution, else a BatchRandom kernel
+static void BM_FaultDraws(benchmark::State &state) {
+    const int draws = 1 << 16;
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> random_prob(0.0, 1.0);
+    BatchRandom batch(static_cast<SimdLevel>(std::max<int64_t>(state.range(0), 1)));
+    batch.seed(1);
+    for (auto _ : state) {
+        int faults = 0;
+        if (state.range(0) == 0) {
+            for (int i = 0; i < draws; i++) faults += random_prob(gen) < 0.01;
+        } else {
+            for (int i = 0; i < draws; i++) faults += batch.uniform() < 0.01;
+        }
+        benchmark::DoNotOptimize(faults);
+    }
+    state.SetItemsProcessed(state.iterations() * draws);
+}
+BENCHMARK(BM_FaultDraws)->Arg(0)->Arg(1)->Arg(2)->Arg(3);
+
+BENCHMARK_MAIN();
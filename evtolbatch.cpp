@@ -0,0 +1,278 @@
+/**
+ * File: evtolbatch.cpp
+ * Replica pool and statistics reduction.
+ */
+
+#include "evtolbatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Number of values in one row of ReplicaTotals
+const size_t kMetrics = 6;
+
+void addRow(MetricStats &stats, const double *row) {
+    stats.vehicles.add(row[0]);
+    stats.flight_time.add(row[1]);
+    stats.distance.add(row[2]);
+    stats.charge_time.add(row[3]);
+    stats.faults.add(row[4]);
+    stats.passenger_miles.add(row[5]);
+}
+
+} // namespace
+
+double RunningStat::stddev() const {
+    if (count < 2) return 0.0;
+    double variance = (sum_sq - sum * sum / count) / (count - 1);
+    return variance > 0 ? std::sqrt(variance) : 0.0;
+}
+
+void MetricStats::merge(const MetricStats &other) {
+    vehicles.merge(other.vehicles);
+    flight_time.merge(other.flight_time);
+    distance.merge(other.distance);
+    charge_time.merge(other.charge_time);
+    faults.merge(other.faults);
+    passenger_miles.merge(other.passenger_miles);
+}
+
+void OccupancyMetrics::merge(const OccupancyMetrics &other) {
+    utilization.merge(other.utilization);
+    all_busy.merge(other.all_busy);
+    idle_gaps.merge(other.idle_gaps);
+    longest_gap.merge(other.longest_gap);
+}
+
+void DemandMetrics::merge(const DemandMetrics &other) {
+    requests.merge(other.requests);
+    served.merge(other.served);
+    dropped.merge(other.dropped);
+    mean_wait.merge(other.mean_wait);
+    deadhead_miles.merge(other.deadhead_miles);
+}
+
+void MaintenanceMetrics::merge(const MaintenanceMetrics &other) {
+    repairs.merge(other.repairs);
+    wait_hours.merge(other.wait_hours);
+    bay_hours.merge(other.bay_hours);
+}
+
+void EnergyMetrics::merge(const EnergyMetrics &other) {
+    energy_kwh.merge(other.energy_kwh);
+    cost.merge(other.cost);
+    peak_kw.merge(other.peak_kw);
+    power_wait_hours.merge(other.power_wait_hours);
+}
+
+void ShiftMetrics::merge(const ShiftMetrics &other) {
+    passenger_miles.merge(other.passenger_miles);
+    min_passenger_miles.merge(other.min_passenger_miles);
+    last_passenger_miles.merge(other.last_passenger_miles);
+    mean_capacity.merge(other.mean_capacity);
+    min_capacity.merge(other.min_capacity);
+}
+
+void SensitivityMetrics::merge(const SensitivityMetrics &other) {
+    if (passenger_miles.size() < other.passenger_miles.size()) {
+        passenger_miles.resize(other.passenger_miles.size());
+        charge_time.resize(other.charge_time.size());
+    }
+    for (size_t k = 0; k < other.passenger_miles.size(); k++) {
+        passenger_miles[k].merge(other.passenger_miles[k]);
+        charge_time[k].merge(other.charge_time[k]);
+    }
+}
+
+void ScenarioStats::merge(const ScenarioStats &other) {
+    replicas += other.replicas;
+    events += other.events;
+    fleet.merge(other.fleet);
+    occupancy.merge(other.occupancy);
+    demand.merge(other.demand);
+    maintenance.merge(other.maintenance);
+    energy.merge(other.energy);
+    shifts.merge(other.shifts);
+    if (series.empty()) series = other.series;
+    sensitivities.merge(other.sensitivities);
+    if (companies.size() < other.companies.size()) companies.resize(other.companies.size());
+    for (size_t c = 0; c < other.companies.size(); c++) {
+        companies[c].merge(other.companies[c]);
+    }
+}
+
+ReplicaPool::ReplicaPool(int workers) {
+    if (workers <= 0) workers = static_cast<int>(std::thread::hardware_concurrency());
+    if (workers <= 0) workers = 1;
+
+    for (int w = 0; w < workers; w++) {
+        // Workers already fill the cores; route tables build inline
+        contexts.emplace_back(new SimulationContext(1));
+    }
+    for (int w = 0; w < workers; w++) {
+        threads.emplace_back(&ReplicaPool::workerLoop, this, w);
+    }
+}
+
+ReplicaPool::~ReplicaPool() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto &t : threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+ScenarioStats ReplicaPool::run(const Scenario &scenario, int replicas, int first_replica) {
+    if (replicas <= 0) return reduce(scenario, nullptr, 0);
+    runJob(&scenario, 1, replicas, first_replica);
+    return reduce(scenario, totals.data(), replicas);
+}
+
+std::vector<ScenarioStats> ReplicaPool::runEach(const std::vector<Scenario> &scenarios, int replicas) {
+    std::vector<ScenarioStats> stats;
+    stats.reserve(scenarios.size());
+    if (replicas > 0 && !scenarios.empty()) runJob(scenarios.data(), scenarios.size(), replicas, 0);
+    for (size_t s = 0; s < scenarios.size(); s++) {
+        stats.push_back(reduce(scenarios[s], replicas > 0 ? totals.data() + s * replicas : nullptr,
+                               std::max(replicas, 0)));
+    }
+    return stats;
+}
+
+void ReplicaPool::runJob(const Scenario *scenarios, size_t count, int replicas, int first_replica) {
+    totals.resize(count * static_cast<size_t>(replicas));
+    std::unique_lock<std::mutex> lock(pool_mutex);
+    job_scenarios = scenarios;
+    job_count = count;
+    job_first = first_replica;
+    job_replicas = replicas;
+    next_item = 0;
+    busy_workers = workers();
+    generation++;
+    work_cv.notify_all();
+    done_cv.wait(lock, [this] { return busy_workers == 0; });
+    job_scenarios = nullptr;
+}
+
+ScenarioStats ReplicaPool::reduce(const Scenario &scenario, const ReplicaTotals *replicas, int count) const {
+    ScenarioStats stats;
+    stats.companies.resize(scenario.specs.size());
+    if (count <= 0) return stats;
+
+    // Reduce in replica order so the result does not depend on scheduling
+    size_t companies = scenario.specs.size();
+    for (int r = 0; r < count; r++) {
+        const ReplicaTotals &replica = replicas[r];
+        addRow(stats.fleet, replica.values.data());
+        for (size_t c = 0; c < companies; c++) {
+            addRow(stats.companies[c], replica.values.data() + (c + 1) * kMetrics);
+        }
+        stats.events += replica.events;
+        if (replica.occupancy.chargers > 0) {
+            stats.occupancy.utilization.add(replica.occupancy.utilization());
+            stats.occupancy.all_busy.add(replica.occupancy.allBusyFraction());
+            stats.occupancy.idle_gaps.add(replica.occupancy.gapsPerCharger());
+            stats.occupancy.longest_gap.add(replica.occupancy.longest_gap_hours);
+        }
+        if (scenario.demand.enabled) {
+            stats.demand.requests.add(static_cast<double>(replica.demand.requests));
+            stats.demand.served.add(static_cast<double>(replica.demand.served));
+            stats.demand.dropped.add(static_cast<double>(replica.demand.dropped));
+            stats.demand.mean_wait.add(replica.demand.meanWait());
+            stats.demand.deadhead_miles.add(replica.demand.deadhead_miles);
+        }
+        if (scenario.maintenance.enabled) {
+            stats.maintenance.repairs.add(static_cast<double>(replica.maintenance.repairs));
+            stats.maintenance.wait_hours.add(replica.maintenance.total_wait_hours);
+            stats.maintenance.bay_hours.add(replica.maintenance.bay_hours);
+        }
+        if (scenario.energy.enabled) {
+            stats.energy.energy_kwh.add(replica.energy.energy_kwh);
+            stats.energy.cost.add(replica.energy.cost);
+            stats.energy.peak_kw.add(replica.energy.peak_kw);
+            stats.energy.power_wait_hours.add(replica.energy.power_wait_hours);
+        }
+        if (scenario.shifts.count > 1) {
+            stats.shifts.passenger_miles.add(replica.shifts.meanPassengerMiles());
+            stats.shifts.min_passenger_miles.add(replica.shifts.min_passenger_miles);
+            stats.shifts.last_passenger_miles.add(replica.shifts.last_passenger_miles);
+            stats.shifts.mean_capacity.add(replica.shifts.mean_capacity);
+            stats.shifts.min_capacity.add(replica.shifts.min_capacity);
+        }
+        const SensitivityStats &derivatives = replica.sensitivities;
+        if (derivatives.valid) {
+            SensitivityMetrics &metrics = stats.sensitivities;
+            metrics.passenger_miles.resize(derivatives.passenger_miles.size());
+            metrics.charge_time.resize(derivatives.charge_time.size());
+            for (size_t k = 0; k < derivatives.passenger_miles.size(); k++) {
+                metrics.passenger_miles[k].add(derivatives.passenger_miles[k]);
+                metrics.charge_time[k].add(derivatives.charge_time[k]);
+            }
+        }
+    }
+    stats.series = replicas[0].series;
+    stats.replicas = static_cast<uint64_t>(count);
+    return stats;
+}
+
+void ReplicaPool::workerLoop(int worker) {
+    SimulationContext &context = *contexts[worker];
+    uint64_t seen = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pool_mutex);
+            work_cv.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        // Items run replica by replica within each scenario; a worker copies a scenario only when it moves on
+        Scenario replica_scenario;
+        size_t current = job_count;
+        size_t per_scenario = static_cast<size_t>(job_replicas);
+        size_t items = job_count * per_scenario;
+        for (size_t item = next_item++; item < items; item = next_item++) {
+            size_t s = item / per_scenario;
+            int r = static_cast<int>(item % per_scenario);
+            if (s != current) {
+                replica_scenario = job_scenarios[s];
+                current = s;
+            }
+            unsigned int base_seed = job_scenarios[s].seed;
+            size_t companies = replica_scenario.specs.size();
+            replica_scenario.seed = base_seed != 0 ? base_seed + static_cast<unsigned int>(job_first + r) : 0;
+            context.run(replica_scenario);
+
+            ReplicaTotals &out = totals[item];
+            out.values.assign((companies + 1) * kMetrics, 0.0);
+            CompanyColumns rows = context.companies();
+            for (size_t c = 0; c < companies; c++) {
+                double row[kMetrics] = {static_cast<double>(rows.vehicle_count[c]), rows.flight_time[c], rows.distance[c], rows.charge_time[c],
+                                        static_cast<double>(rows.faults[c]), rows.passenger_miles[c]};
+                for (size_t m = 0; m < kMetrics; m++) {
+                    out.values[(c + 1) * kMetrics + m] = row[m];
+                    out.values[m] += row[m];
+                }
+            }
+            out.events = context.eventsProcessed();
+            out.occupancy = context.occupancyStats();
+            out.demand = context.demandStats();
+            out.maintenance = context.maintenanceStats();
+            out.energy = context.energyStats();
+            out.shifts = context.shiftStats();
+            if (r == 0) out.series = context.series();
+            out.sensitivities = context.sensitivities();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex);
+            if (--busy_workers == 0) done_cv.notify_all();
+        }
+    }
+}
@@ -0,0 +1,227 @@
+/**
+ * File: evtolbatch.h
+ * Replicated scenario runs on a persistent pool of worker threads.
+ *
+ * A ReplicaPool keeps its threads and their SimulationContexts alive between
+ * calls, so a batch of replicas pays neither thread creation nor storage
+ * allocation once the pool is warm. Results are reduced into ScenarioStats,
+ * which keep mergeable sums so batches can be combined later.
+ */
+
+#ifndef EVTOLBATCH_H
+#define EVTOLBATCH_H
+
+#include "evtolengine.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Struct RunningStat : Count, sum and sum of squares of a sample.
+ */
+struct RunningStat {
+    uint64_t count = 0;
+    double sum = 0;
+    double sum_sq = 0;
+
+    void add(double x) {
+        count++;
+        sum += x;
+        sum_sq += x * x;
+    }
+
+    void merge(const RunningStat &other) {
+        count += other.count;
+        sum += other.sum;
+        sum_sq += other.sum_sq;
+    }
+
+    double mean() const { return count ? sum / count : 0.0; }
+
+    // Sample standard deviation (0 for fewer than two samples).
+    double stddev() const;
+};
+
+/**
+ * Struct MetricStats : Replica statistics of the totals a run produces.
+ */
+struct MetricStats {
+    RunningStat vehicles;
+    RunningStat flight_time;  // hours
+    RunningStat distance;  // miles
+    RunningStat charge_time;  // hours
+    RunningStat faults;
+    RunningStat passenger_miles;
+
+    void merge(const MetricStats &other);
+};
+
+/**
+ * Struct OccupancyMetrics : Replica statistics of charger occupancy.
+ */
+struct OccupancyMetrics {
+    RunningStat utilization;  // Fraction of charger time spent charging
+    RunningStat all_busy;  // Fraction of time every charger of a site was charging
+    RunningStat idle_gaps;  // Idle stretches per charger
+    RunningStat longest_gap;  // hours
+
+    void merge(const OccupancyMetrics &other);
+};
+
+/**
+ * Struct DemandMetrics : Replica statistics of trip requests in demand mode.
+ */
+struct DemandMetrics {
+    RunningStat requests;
+    RunningStat served;
+    RunningStat dropped;
+    RunningStat mean_wait;  // hours until pickup, per served request
+    RunningStat deadhead_miles;  // Flown empty to reach requests
+
+    void merge(const DemandMetrics &other);
+};
+
+/**
+ * Struct MaintenanceMetrics : Replica statistics of repairs at the maintenance bays.
+ */
+struct MaintenanceMetrics {
+    RunningStat repairs;  // Repairs started
+    RunningStat wait_hours;  // Spent waiting for a free bay, summed over the repairs
+    RunningStat bay_hours;  // Bay time used within the horizon
+
+    void merge(const MaintenanceMetrics &other);
+};
+
+/**
+ * Struct EnergyMetrics : Replica statistics of metered charging.
+ */
+struct EnergyMetrics {
+    RunningStat energy_kwh;  // Delivered within the horizon
+    RunningStat cost;  // At the time-of-use price
+    RunningStat peak_kw;  // Highest bucket load of any site
+    RunningStat power_wait_hours;  // Plugged in, waiting for room under the site cap
+
+    void merge(const EnergyMetrics &other);
+};
+
+/**
+ * Struct ShiftMetrics : Replica statistics of the per-shift totals and battery wear.
+ */
+struct ShiftMetrics {
+    RunningStat passenger_miles;  // Mean fleet total per shift
+    RunningStat min_passenger_miles;  // Fleet total of the weakest shift
+    RunningStat last_passenger_miles;  // Fleet total of the final shift
+    RunningStat mean_capacity;  // Fleet mean battery capacity at the end, fraction of new
+    RunningStat min_capacity;  // Most faded battery at the end
+
+    void merge(const ShiftMetrics &other);
+};
+
+/**
+ * Struct SensitivityMetrics : Replica statistics of the pathwise derivatives.
+ *
+ * One entry per SensitivityStats parameter; the mean over replicas estimates
+ * the derivative of the expected total.
+ */
+struct SensitivityMetrics {
+    std::vector<RunningStat> passenger_miles;
+    std::vector<RunningStat> charge_time;
+
+    void merge(const SensitivityMetrics &other);
+};
+
+/**
+ * Struct ScenarioStats : Aggregated results of a batch of replicas.
+ *
+ * companies has one entry per spec of the scenario. Stats from two batches
+ * of the same scenario can be merged. series is the fleet time series of the
+ * batch's first replica, a representative run for dashboards; merging keeps
+ * that of the earlier batch.
+ */
+struct ScenarioStats {
+    uint64_t replicas = 0;
+    uint64_t events = 0;
+    MetricStats fleet;
+    std::vector<MetricStats> companies;
+    OccupancyMetrics occupancy;  // Empty when the scenario turns the timelines off
+    DemandMetrics demand;  // Empty unless the scenario is in demand mode
+    MaintenanceMetrics maintenance;  // Empty unless the scenario grounds faulted vehicles
+    EnergyMetrics energy;  // Empty unless the scenario meters charging
+    ShiftMetrics shifts;  // Empty unless the scenario runs more than one shift
+    FleetSeries series;  // Empty unless the scenario sets series_points
+    SensitivityMetrics sensitivities;  // Empty unless the scenario asks and the engine covers its policies
+
+    void merge(const ScenarioStats &other);
+};
+
+/**
+ * Class ReplicaPool : Runs replicas of a scenario on persistent worker threads.
+ *
+ * Replica r of a scenario with a non-zero seed runs with seed + r, so a batch
+ * is reproducible and the replicas [first, first + count) of a larger batch
+ * give exactly the same results when run on their own. run() and runEach()
+ * may be called from one thread at a time.
+ */
+class ReplicaPool {
+public:
+    // Starts the given number of workers (0 picks the hardware concurrency).
+    explicit ReplicaPool(int workers = 0);
+    ~ReplicaPool();
+
+    ReplicaPool(const ReplicaPool &) = delete;
+    ReplicaPool &operator=(const ReplicaPool &) = delete;
+
+    // Runs replicas [first_replica, first_replica + replicas) and aggregates them.
+    ScenarioStats run(const Scenario &scenario, int replicas, int first_replica = 0);
+
+    /**
+     * Runs replicas [0, replicas) of every scenario as one job, so many small
+     * scenarios keep all workers busy, and aggregates each scenario on its own.
+     */
+    std::vector<ScenarioStats> runEach(const std::vector<Scenario> &scenarios, int replicas);
+
+    int workers() const { return static_cast<int>(threads.size()); }
+
+private:
+    // Totals of one replica: the fleet row followed by one row per company.
+    struct ReplicaTotals {
+        std::vector<double> values;
+        uint64_t events = 0;
+        OccupancyStats occupancy;
+        DemandStats demand;
+        MaintenanceStats maintenance;
+        EnergyStats energy;
+        ShiftStats shifts;
+        FleetSeries series;  // First replica only
+        SensitivityStats sensitivities;
+    };
+
+    void runJob(const Scenario *scenarios, size_t count, int replicas, int first_replica);
+    ScenarioStats reduce(const Scenario &scenario, const ReplicaTotals *replicas, int count) const;
+    void workerLoop(int worker);
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<SimulationContext>> contexts;  // One warm context per worker
+
+    std::mutex pool_mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    uint64_t generation = 0;
+    int busy_workers = 0;
+    bool stopping = false;
+
+    // Current job: replicas of each scenario, scenario by scenario
+    const Scenario *job_scenarios = nullptr;
+    size_t job_count = 0;
+    int job_first = 0;
+    int job_replicas = 0;
+    std::atomic<size_t> next_item{0};
+    std::vector<ReplicaTotals> totals;
+};
+
+#endif // EVTOLBATCH_H
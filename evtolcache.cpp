@@ -0,0 +1,433 @@
+/**
+ * File: evtolcache.cpp
+ * Scenario canonicalization, hashing and the two-tier result cache.
+ */
+
+#include "evtolcache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Writes a double so that it reads back bit-for-bit.
+void writeExact(std::ostream &out, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%a", value);
+    out << buffer;
+}
+
+void writeStat(std::ostream &out, const RunningStat &stat) {
+    out << stat.count << ' ';
+    writeExact(out, stat.sum);
+    out << ' ';
+    writeExact(out, stat.sum_sq);
+    out << '\n';
+}
+
+bool readStat(std::istream &in, RunningStat &stat) {
+    std::string sum, sum_sq;
+    if (!(in >> stat.count >> sum >> sum_sq)) return false;
+    stat.sum = std::strtod(sum.c_str(), nullptr);
+    stat.sum_sq = std::strtod(sum_sq.c_str(), nullptr);
+    return true;
+}
+
+void writeMetrics(std::ostream &out, const MetricStats &stats) {
+    writeStat(out, stats.vehicles);
+    writeStat(out, stats.flight_time);
+    writeStat(out, stats.distance);
+    writeStat(out, stats.charge_time);
+    writeStat(out, stats.faults);
+    writeStat(out, stats.passenger_miles);
+}
+
+bool readMetrics(std::istream &in, MetricStats &stats) {
+    return readStat(in, stats.vehicles) && readStat(in, stats.flight_time) &&
+           readStat(in, stats.distance) && readStat(in, stats.charge_time) &&
+           readStat(in, stats.faults) && readStat(in, stats.passenger_miles);
+}
+
+void writeOccupancy(std::ostream &out, const OccupancyMetrics &stats) {
+    writeStat(out, stats.utilization);
+    writeStat(out, stats.all_busy);
+    writeStat(out, stats.idle_gaps);
+    writeStat(out, stats.longest_gap);
+}
+
+bool readOccupancy(std::istream &in, OccupancyMetrics &stats) {
+    return readStat(in, stats.utilization) && readStat(in, stats.all_busy) && readStat(in, stats.idle_gaps) &&
+           readStat(in, stats.longest_gap);
+}
+
+void writeDemand(std::ostream &out, const DemandMetrics &stats) {
+    writeStat(out, stats.requests);
+    writeStat(out, stats.served);
+    writeStat(out, stats.dropped);
+    writeStat(out, stats.mean_wait);
+    writeStat(out, stats.deadhead_miles);
+}
+
+bool readDemand(std::istream &in, DemandMetrics &stats) {
+    return readStat(in, stats.requests) && readStat(in, stats.served) && readStat(in, stats.dropped) &&
+           readStat(in, stats.mean_wait) && readStat(in, stats.deadhead_miles);
+}
+
+void writeMaintenance(std::ostream &out, const MaintenanceMetrics &stats) {
+    writeStat(out, stats.repairs);
+    writeStat(out, stats.wait_hours);
+    writeStat(out, stats.bay_hours);
+}
+
+bool readMaintenance(std::istream &in, MaintenanceMetrics &stats) {
+    return readStat(in, stats.repairs) && readStat(in, stats.wait_hours) && readStat(in, stats.bay_hours);
+}
+
+void writeEnergy(std::ostream &out, const EnergyMetrics &stats) {
+    writeStat(out, stats.energy_kwh);
+    writeStat(out, stats.cost);
+    writeStat(out, stats.peak_kw);
+    writeStat(out, stats.power_wait_hours);
+}
+
+bool readEnergy(std::istream &in, EnergyMetrics &stats) {
+    return readStat(in, stats.energy_kwh) && readStat(in, stats.cost) && readStat(in, stats.peak_kw) &&
+           readStat(in, stats.power_wait_hours);
+}
+
+void writeShifts(std::ostream &out, const ShiftMetrics &stats) {
+    writeStat(out, stats.passenger_miles);
+    writeStat(out, stats.min_passenger_miles);
+    writeStat(out, stats.last_passenger_miles);
+    writeStat(out, stats.mean_capacity);
+    writeStat(out, stats.min_capacity);
+}
+
+bool readShifts(std::istream &in, ShiftMetrics &stats) {
+    return readStat(in, stats.passenger_miles) && readStat(in, stats.min_passenger_miles) &&
+           readStat(in, stats.last_passenger_miles) && readStat(in, stats.mean_capacity) &&
+           readStat(in, stats.min_capacity);
+}
+
+void writeSeries(std::ostream &out, const FleetSeries &series) {
+    for (size_t m = 0; m < kSeriesMetrics; m++) {
+        const TimeSeries &metric = series.metric(m);
+        out << metric.size();
+        for (size_t i = 0; i < metric.size(); i++) {
+            out << ' ';
+            writeExact(out, metric.time[i]);
+            out << ' ';
+            writeExact(out, metric.value[i]);
+        }
+        out << '\n';
+    }
+}
+
+bool readSeries(std::istream &in, FleetSeries &series) {
+    for (size_t m = 0; m < kSeriesMetrics; m++) {
+        TimeSeries &metric = series.metric(m);
+        size_t points;
+        if (!(in >> points)) return false;
+        metric.clear();
+        std::string time, value;
+        for (size_t i = 0; i < points; i++) {
+            if (!(in >> time >> value)) return false;
+            metric.time.push_back(std::strtod(time.c_str(), nullptr));
+            metric.value.push_back(std::strtod(value.c_str(), nullptr));
+        }
+    }
+    return true;
+}
+
+void writeSensitivities(std::ostream &out, const SensitivityMetrics &stats) {
+    out << stats.passenger_miles.size() << '\n';
+    for (size_t k = 0; k < stats.passenger_miles.size(); k++) {
+        writeStat(out, stats.passenger_miles[k]);
+        writeStat(out, stats.charge_time[k]);
+    }
+}
+
+bool readSensitivities(std::istream &in, SensitivityMetrics &stats) {
+    size_t params;
+    if (!(in >> params)) return false;
+    stats.passenger_miles.resize(params);
+    stats.charge_time.resize(params);
+    for (size_t k = 0; k < params; k++) {
+        if (!readStat(in, stats.passenger_miles[k]) || !readStat(in, stats.charge_time[k])) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string canonicalScenarioKey(const Scenario &scenario) {
+    std::ostringstream out;
+    out << "engine=" << kEngineVersion << " seed=" << scenario.seed << " chargers=" << scenario.chargers
+        << " horizon=";
+    writeExact(out, scenario.horizon_hours);
+    out << " to_need=" << scenario.charge_to_need << " reserve=" << scenario.reservations
+        << " preempt=" << scenario.preemption;
+    if (scenario.preemption) {
+        out << ':';
+        writeExact(out, scenario.preempt_soc);
+    }
+    out << " occupancy=";
+    writeExact(out, std::max(scenario.occupancy_slot_hours, 0.0));
+    out << " sensitivities=" << scenario.sensitivities;
+    out << " series=" << (scenario.series_points > 0 ? std::max(scenario.series_points, 2) : 0);
+    for (const ChargerClass &charger : scenario.charger_classes) {
+        out << " class=" << charger.count << ',';
+        writeExact(out, charger.power);
+        for (int spec : charger.specs) out << ',' << spec;
+    }
+
+    const MissionProfile &mission = scenario.missions;
+    out << " missions=" << mission.enabled;
+    if (mission.enabled) {
+        out << ':' << static_cast<int>(mission.distribution);
+        for (double value : {mission.mean_miles, mission.spread, mission.turnaround_hours, mission.reserve_soc}) {
+            out << ',';
+            writeExact(out, value);
+        }
+    }
+
+    const MaintenanceProfile &maintenance = scenario.maintenance;
+    out << " maintenance=" << maintenance.enabled;
+    if (maintenance.enabled) {
+        out << ':' << maintenance.bays << ',';
+        writeExact(out, maintenance.repair_hours);
+    }
+
+    const EnergyProfile &energy = scenario.energy;
+    out << " energy=" << energy.enabled;
+    if (energy.enabled) {
+        for (double value : {energy.site_power_kw, energy.bucket_hours}) {
+            out << ',';
+            writeExact(out, value);
+        }
+        out << " prices=";
+        for (double price : energy.hourly_price) {
+            writeExact(out, price);
+            out << ',';
+        }
+    }
+
+    // One shift runs the same however the later ones would have been configured
+    const ShiftProfile &shifts = scenario.shifts;
+    out << " shifts=" << std::max(shifts.count, 1);
+    if (shifts.count > 1) {
+        out << ':' << shifts.overnight_charge;
+        for (double value : {shifts.fade_per_cycle, shifts.min_capacity}) {
+            out << ',';
+            writeExact(out, value);
+        }
+    }
+
+    const DemandProfile &profile = scenario.demand;
+    out << " demand=" << profile.enabled;
+    if (profile.enabled) {
+        for (double value : {profile.max_wait_hours, profile.turnaround_hours, profile.reserve_soc,
+                             profile.charge_below_soc, profile.max_deadhead_miles}) {
+            out << ',';
+            writeExact(out, value);
+        }
+        out << " rates=";
+        for (double rate : profile.hourly_rate) {
+            writeExact(out, rate);
+            out << ',';
+        }
+        for (const Vertiport &port : profile.vertiports) {
+            out << " port=" << port.chargers;
+            for (double value : {port.x, port.y, port.demand_weight}) {
+                out << ',';
+                writeExact(out, value);
+            }
+        }
+        for (const RouteLink &link : profile.links) {
+            out << " link=" << link.from << ',' << link.to << ',';
+            writeExact(out, link.miles);
+        }
+    }
+
+    // A fixed mix ignores vehicle_count, and trailing zero counts are implied
+    if (scenario.fleet_mix.empty()) {
+        out << " vehicles=" << scenario.vehicle_count;
+    } else {
+        size_t used = scenario.fleet_mix.size();
+        while (used > 0 && scenario.fleet_mix[used - 1] == 0) used--;
+        out << " mix=";
+        for (size_t i = 0; i < used; i++) out << (i ? "," : "") << scenario.fleet_mix[i];
+    }
+
+    for (const EVTOL_Spec &spec : scenario.specs) {
+        out << " spec=" << spec.company.size() << ':' << spec.company;
+        for (double value : {spec.cruise_speed, spec.battery_capacity, spec.charge_time, spec.energy_use,
+                             static_cast<double>(spec.passenger_count), spec.fault_probability, spec.cv_soc,
+                             spec.taper_power}) {
+            out << ',';
+            writeExact(out, value);
+        }
+    }
+    return out.str();
+}
+
+uint64_t hashKey(const std::string &key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+ResultCache::ResultCache(size_t max_entries, const std::string &disk_dir)
+    : max_entries(max_entries > 0 ? max_entries : 1), disk_dir(disk_dir) {}
+
+ScenarioStats ResultCache::run(ReplicaPool &pool, const Scenario &scenario, int replicas) {
+    if (scenario.seed == 0) return pool.run(scenario, replicas);
+
+    std::string key = canonicalScenarioKey(scenario);
+    uint64_t hash = hashKey(key);
+
+    ScenarioStats cached;
+    bool found = lookupKey(key, hash, cached);
+    int have = found ? static_cast<int>(cached.replicas) : 0;
+
+    if (have == replicas) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        hit_count++;
+        return cached;
+    }
+
+    // Aggregates cannot be split, so a larger cached batch does not help
+    if (have > replicas) {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        miss_count++;
+        return pool.run(scenario, replicas);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        if (found) {
+            partial_hit_count++;
+        } else {
+            miss_count++;
+        }
+    }
+
+    // Run only the missing replicas and merge them in
+    ScenarioStats stats = found ? cached : ScenarioStats();
+    stats.merge(pool.run(scenario, replicas - have, have));
+    insertMemory(key, hash, stats);
+    if (!disk_dir.empty()) writeDisk(key, hash, stats);
+    return stats;
+}
+
+bool ResultCache::lookup(const Scenario &scenario, ScenarioStats &stats) {
+    if (scenario.seed == 0) return false;
+    std::string key = canonicalScenarioKey(scenario);
+    return lookupKey(key, hashKey(key), stats);
+}
+
+void ResultCache::store(const Scenario &scenario, const ScenarioStats &stats) {
+    if (scenario.seed == 0) return;
+    std::string key = canonicalScenarioKey(scenario);
+    uint64_t hash = hashKey(key);
+
+    ScenarioStats existing;
+    if (lookupKey(key, hash, existing) && existing.replicas >= stats.replicas) return;
+    insertMemory(key, hash, stats);
+    if (!disk_dir.empty()) writeDisk(key, hash, stats);
+}
+
+size_t ResultCache::size() const {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return lru.size();
+}
+
+bool ResultCache::lookupKey(const std::string &key, uint64_t hash, ScenarioStats &stats) {
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = index.find(hash);
+        if (it != index.end() && it->second->key == key) {
+            lru.splice(lru.begin(), lru, it->second);
+            stats = it->second->stats;
+            return true;
+        }
+    }
+
+    // Fall back to the disk tier and promote the entry into memory
+    if (disk_dir.empty() || !readDisk(key, hash, stats)) return false;
+    insertMemory(key, hash, stats);
+    return true;
+}
+
+void ResultCache::insertMemory(const std::string &key, uint64_t hash, const ScenarioStats &stats) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = index.find(hash);
+    if (it != index.end()) {
+        lru.erase(it->second);
+        index.erase(it);
+    }
+
+    lru.push_front({key, stats});
+    index[hash] = lru.begin();
+
+    while (lru.size() > max_entries) {
+        index.erase(hashKey(lru.back().key));
+        lru.pop_back();
+    }
+}
+
+std::string ResultCache::diskPath(uint64_t hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.stats", static_cast<unsigned long long>(hash));
+    return disk_dir + "/" + name;
+}
+
+bool ResultCache::readDisk(const std::string &key, uint64_t hash, ScenarioStats &stats) const {
+    std::ifstream in(diskPath(hash));
+    std::string stored_key;
+    if (!in || !std::getline(in, stored_key) || stored_key != key) return false;
+
+    ScenarioStats loaded;
+    size_t companies;
+    if (!(in >> loaded.replicas >> loaded.events >> companies) || !readMetrics(in, loaded.fleet)) return false;
+    loaded.companies.resize(companies);
+    for (MetricStats &company : loaded.companies) {
+        if (!readMetrics(in, company)) return false;
+    }
+    if (!readOccupancy(in, loaded.occupancy) || !readSeries(in, loaded.series) ||
+        !readSensitivities(in, loaded.sensitivities) || !readDemand(in, loaded.demand) ||
+        !readMaintenance(in, loaded.maintenance) || !readEnergy(in, loaded.energy) ||
+        !readShifts(in, loaded.shifts)) {
+        return false;
+    }
+    stats = loaded;
+    return true;
+}
+
+void ResultCache::writeDisk(const std::string &key, uint64_t hash, const ScenarioStats &stats) const {
+    // Write to a temporary file and rename so readers never see a partial entry
+    std::string path = diskPath(hash);
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        if (!out) return;
+        out << key << '\n' << stats.replicas << ' ' << stats.events << ' ' << stats.companies.size() << '\n';
+        writeMetrics(out, stats.fleet);
+        for (const MetricStats &company : stats.companies) writeMetrics(out, company);
+        writeOccupancy(out, stats.occupancy);
+        writeSeries(out, stats.series);
+        writeSensitivities(out, stats.sensitivities);
+        writeDemand(out, stats.demand);
+        writeMaintenance(out, stats.maintenance);
+        writeEnergy(out, stats.energy);
+        writeShifts(out, stats.shifts);
+        if (!out) return;
+    }
+    std::rename(tmp.c_str(), path.c_str());
+}
@@ -0,0 +1,86 @@
+/**
+ * File: evtolcache.h
+ * Content-addressed cache of aggregated scenario results.
+ *
+ * Entries are keyed by a canonical text form of the scenario (every field
+ * that affects results, floats written exactly), the seed and the engine
+ * version, hashed with 64-bit FNV-1a. The replica count is stored in the
+ * entry rather than the key: because replica r always runs with seed + r, a
+ * request for more replicas than are cached only runs the missing ones and
+ * merges them in.
+ *
+ * Entries live in an in-memory LRU and, optionally, as one file per entry in
+ * a directory so they survive restarts. Scenarios with seed 0 (random) are
+ * never cached.
+ */
+
+#ifndef EVTOLCACHE_H
+#define EVTOLCACHE_H
+
+#include "evtolbatch.h"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Canonical text form of everything that determines a scenario's results.
+std::string canonicalScenarioKey(const Scenario &scenario);
+
+// 64-bit FNV-1a hash.
+uint64_t hashKey(const std::string &key);
+
+/**
+ * Class ResultCache : In-memory LRU of ScenarioStats with an optional disk tier.
+ */
+class ResultCache {
+public:
+    // disk_dir empty disables the disk tier.
+    explicit ResultCache(size_t max_entries = 1024, const std::string &disk_dir = "");
+
+    /**
+     * Returns the statistics of replicas [0, replicas) of the scenario, running
+     * only the replicas not already cached.
+     */
+    ScenarioStats run(ReplicaPool &pool, const Scenario &scenario, int replicas);
+
+    /**
+     * Looks up cached statistics for the scenario.
+     * returns True if an entry exists (with any replica count), false otherwise.
+     */
+    bool lookup(const Scenario &scenario, ScenarioStats &stats);
+
+    // Stores statistics for the scenario, keeping whichever entry has more replicas.
+    void store(const Scenario &scenario, const ScenarioStats &stats);
+
+    uint64_t hits() const { return hit_count; }
+    uint64_t partialHits() const { return partial_hit_count; }
+    uint64_t misses() const { return miss_count; }
+    size_t size() const;
+
+private:
+    struct Entry {
+        std::string key;
+        ScenarioStats stats;
+    };
+
+    bool lookupKey(const std::string &key, uint64_t hash, ScenarioStats &stats);
+    void insertMemory(const std::string &key, uint64_t hash, const ScenarioStats &stats);
+    std::string diskPath(uint64_t hash) const;
+    bool readDisk(const std::string &key, uint64_t hash, ScenarioStats &stats) const;
+    void writeDisk(const std::string &key, uint64_t hash, const ScenarioStats &stats) const;
+
+    size_t max_entries;
+    std::string disk_dir;
+
+    mutable std::mutex cache_mutex;
+    std::list<Entry> lru;  // Most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+
+    uint64_t hit_count = 0;
+    uint64_t partial_hit_count = 0;
+    uint64_t miss_count = 0;
+};
+
+#endif // EVTOLCACHE_H
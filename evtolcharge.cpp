@@ -0,0 +1,84 @@
+/**
+ * File: evtolcharge.cpp
+ * Charge curve integration and table lookups.
+ */
+
+#include "evtolcharge.h"
+
+#include <algorithm>
+
+namespace {
+
+// Integration steps per table entry when building the tables
+const int kStepsPerEntry = 16;
+
+// Relative charging power at a state of charge (1 at peak).
+double relativePower(const EVTOL_Spec &spec, double soc) {
+    if (soc <= spec.cv_soc || spec.cv_soc >= 1.0) return 1.0;
+    double progress = (soc - spec.cv_soc) / (1.0 - spec.cv_soc);
+    return 1.0 - progress * (1.0 - spec.taper_power);
+}
+
+// Linear interpolation in a table sampled uniformly over [0, 1].
+double interpolate(const std::vector<double> &table, double x) {
+    double position = std::min(std::max(x, 0.0), 1.0) * (table.size() - 1);
+    size_t i = std::min(static_cast<size_t>(position), table.size() - 2);
+    double frac = position - i;
+    return table[i] + frac * (table[i + 1] - table[i]);
+}
+
+} // namespace
+
+ChargeCurve::ChargeCurve(const EVTOL_Spec &spec, int table_size) {
+    int n = std::max(table_size, 2);
+    int steps = n * kStepsPerEntry;
+
+    // Integrate dt = dSoC / power with the midpoint rule, in units of peak-power hours
+    std::vector<double> cumulative(steps + 1, 0.0);
+    for (int k = 0; k < steps; k++) {
+        double mid = (k + 0.5) / steps;
+        cumulative[k + 1] = cumulative[k] + (1.0 / steps) / relativePower(spec, mid);
+    }
+    double scale = spec.charge_time / cumulative[steps]; // Calibrate to spec.charge_time
+    full_time = spec.charge_time;
+    peak_rate = scale > 0 ? 1.0 / scale : 0.0;
+
+    time_at_soc.resize(n + 1);
+    for (int i = 0; i <= n; i++) {
+        time_at_soc[i] = cumulative[i * kStepsPerEntry] * scale;
+    }
+
+    // Invert the fine cumulative table at uniformly spaced times
+    soc_at_time.resize(n + 1);
+    int k = 0;
+    for (int i = 0; i <= n; i++) {
+        double target = (full_time > 0 ? static_cast<double>(i) / n * full_time : 0.0) / scale;
+        while (k < steps && cumulative[k + 1] < target) k++;
+        double span = cumulative[std::min(k + 1, steps)] - cumulative[k];
+        double frac = span > 0 ? (target - cumulative[k]) / span : 0.0;
+        soc_at_time[i] = std::min(1.0, (k + std::min(std::max(frac, 0.0), 1.0)) / steps);
+    }
+    soc_at_time[n] = 1.0;
+}
+
+double ChargeCurve::timeToCharge(double from_soc, double to_soc) const {
+    if (to_soc <= from_soc) return 0.0;
+    return timeAt(to_soc) - timeAt(from_soc);
+}
+
+double ChargeCurve::socAfter(double from_soc, double hours) const {
+    if (hours <= 0) return from_soc;
+    double reached = timeAt(from_soc) + hours;
+    if (reached >= full_time) return 1.0;
+    return socAt(reached);
+}
+
+double ChargeCurve::timeAt(double soc) const {
+    if (time_at_soc.empty()) return 0.0;
+    return interpolate(time_at_soc, soc);
+}
+
+double ChargeCurve::socAt(double hours) const {
+    if (soc_at_time.empty() || full_time <= 0) return 1.0;
+    return interpolate(soc_at_time, hours / full_time);
+}
@@ -0,0 +1,59 @@
+/**
+ * File: evtolcharge.h
+ * Constant-current / constant-voltage battery charging curves.
+ *
+ * Charging runs at peak power up to EVTOL_Spec::cv_soc, then the power tapers
+ * linearly down to EVTOL_Spec::taper_power times peak at full charge. Peak
+ * power is calibrated so that a charge from empty to full takes exactly
+ * spec.charge_time, which keeps full-charge results identical to the
+ * constant-rate model.
+ *
+ * The curve is integrated once, at construction, into two tables: time to
+ * reach each state of charge, and state of charge reached after each time.
+ * Queries interpolate in the tables, so the event engine can compute charge
+ * completion or a preempted partial charge in O(1).
+ */
+
+#ifndef EVTOLCHARGE_H
+#define EVTOLCHARGE_H
+
+#include "evtolsimulation.h"
+
+#include <vector>
+
+/**
+ * Class ChargeCurve : Precomputed forward (SoC to time) and inverse (time to SoC) tables.
+ */
+class ChargeCurve {
+public:
+    // An empty curve; build from a spec before use.
+    ChargeCurve() = default;
+
+    explicit ChargeCurve(const EVTOL_Spec &spec, int table_size = 256);
+
+    // Hours to charge from one state of charge to a higher one.
+    double timeToCharge(double from_soc, double to_soc) const;
+
+    // State of charge reached after charging for the given hours.
+    double socAfter(double from_soc, double hours) const;
+
+    // Hours to charge from empty to full (equals spec.charge_time).
+    double fullChargeTime() const { return full_time; }
+
+    // State of charge gained per hour at peak power.
+    double peakRate() const { return peak_rate; }
+
+private:
+    // Hours from empty to the given state of charge.
+    double timeAt(double soc) const;
+
+    // State of charge after charging from empty for the given hours.
+    double socAt(double hours) const;
+
+    std::vector<double> time_at_soc;  // time_at_soc[i]: hours to reach SoC i / n
+    std::vector<double> soc_at_time;  // soc_at_time[i]: SoC after i / n * full_time hours
+    double full_time = 0;
+    double peak_rate = 0;
+};
+
+#endif // EVTOLCHARGE_H
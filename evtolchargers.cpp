@@ -0,0 +1,86 @@
+/**
+ * File: evtolchargers.cpp
+ * Free lists and wait queues of ChargerPool.
+ */
+
+#include "evtolchargers.h"
+
+#include <algorithm>
+
+void ChargerPool::reset(const std::vector<ChargerClass> &classes, size_t specs, const std::vector<int> &counts) {
+    class_count = classes.size();
+    spec_count = specs;
+    size_t sites = class_count ? counts.size() / class_count : 0;
+
+    class_power.resize(class_count);
+    compatible.assign(class_count * spec_count, 0);
+    for (size_t c = 0; c < class_count; c++) {
+        class_power[c] = classes[c].power;
+        for (size_t s = 0; s < spec_count; s++) {
+            const std::vector<int> &fit = classes[c].specs;
+            compatible[c * spec_count + s] =
+                fit.empty() || std::find(fit.begin(), fit.end(), static_cast<int>(s)) != fit.end();
+        }
+    }
+
+    free_count = counts;
+    open.resize(sites * spec_count);
+    queued.resize(sites * spec_count);
+    for (size_t site = 0; site < sites; site++) {
+        for (size_t s = 0; s < spec_count; s++) {
+            auto &classes_open = open[site * spec_count + s];
+            classes_open.clear();
+            queued[site * spec_count + s].clear();
+            for (size_t c = 0; c < class_count; c++) {
+                if (free_count[site * class_count + c] > 0 && compatible[c * spec_count + s]) {
+                    classes_open.insert({-class_power[c], static_cast<int>(c)});
+                }
+            }
+        }
+    }
+    arrivals = 0;
+}
+
+int ChargerPool::acquire(int site, int spec) {
+    auto &classes_open = open[site * spec_count + spec];
+    if (classes_open.empty()) return -1;
+
+    int c = classes_open.begin()->second;
+    if (--free_count[site * class_count + c] == 0) {
+        // The class is no longer open to any manufacturer
+        for (size_t s = 0; s < spec_count; s++) {
+            if (compatible[c * spec_count + s]) open[site * spec_count + s].erase({-class_power[c], c});
+        }
+    }
+    return c;
+}
+
+void ChargerPool::wait(int site, int spec, int vehicle) {
+    queued[site * spec_count + spec].push_back({arrivals++, vehicle});
+}
+
+int ChargerPool::release(int site, int charger_class) {
+    // Longest-waiting vehicle among the manufacturers the charger fits
+    std::deque<std::pair<uint64_t, int>> *first = nullptr;
+    for (size_t s = 0; s < spec_count; s++) {
+        auto &queue = queued[site * spec_count + s];
+        if (!queue.empty() && compatible[charger_class * spec_count + s] &&
+            (!first || queue.front().first < first->front().first)) {
+            first = &queue;
+        }
+    }
+    if (first) {
+        int vehicle = first->front().second;
+        first->pop_front();
+        return vehicle;
+    }
+
+    if (free_count[site * class_count + charger_class]++ == 0) {
+        for (size_t s = 0; s < spec_count; s++) {
+            if (compatible[charger_class * spec_count + s]) {
+                open[site * spec_count + s].insert({-class_power[charger_class], charger_class});
+            }
+        }
+    }
+    return -1;
+}
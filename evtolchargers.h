@@ -0,0 +1,66 @@
+/**
+ * File: evtolchargers.h
+ * Charger assignment over heterogeneous charger classes.
+ *
+ * Chargers of one class are interchangeable, so each site keeps a free count
+ * per class rather than a list of units. For every manufacturer a site also
+ * keeps the compatible classes that have a free charger, ordered by power, so
+ * the best charger for a vehicle is found in O(log classes) however many
+ * chargers there are. Vehicles without a charger wait per manufacturer, and a
+ * released charger goes to the longest-waiting compatible vehicle.
+ */
+
+#ifndef EVTOLCHARGERS_H
+#define EVTOLCHARGERS_H
+
+#include "evtolsimulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <set>
+#include <utility>
+#include <vector>
+
+/**
+ * Class ChargerPool : Free chargers and waiting vehicles per site, by charger class.
+ */
+class ChargerPool {
+public:
+    /**
+     * Sets up the sites with every charger free and nobody waiting.
+     * counts holds the chargers of each class per site (sites x classes, row-major).
+     */
+    void reset(const std::vector<ChargerClass> &classes, size_t specs, const std::vector<int> &counts);
+
+    /**
+     * Takes the most powerful free charger that fits the spec.
+     * returns Its class, or -1 if none is free.
+     */
+    int acquire(int site, int spec);
+
+    // Queues a vehicle for the next compatible charger at the site.
+    void wait(int site, int spec, int vehicle);
+
+    /**
+     * Releases a charger, handing it straight to the longest-waiting compatible vehicle.
+     * returns That vehicle, or -1 if the charger was freed.
+     */
+    int release(int site, int charger_class);
+
+    bool fits(int charger_class, int spec) const { return compatible[charger_class * spec_count + spec] != 0; }
+    double power(int charger_class) const { return class_power[charger_class]; }
+    int freeChargers(int site, int charger_class) const { return free_count[site * class_count + charger_class]; }
+
+private:
+    size_t class_count = 0;
+    size_t spec_count = 0;
+    std::vector<double> class_power;
+    std::vector<uint8_t> compatible;  // classes x specs
+    std::vector<int> free_count;  // sites x classes
+    std::vector<std::set<std::pair<double, int>>> open;  // sites x specs: (-power, class) with a free charger
+    std::vector<std::deque<std::pair<uint64_t, int>>> queued;  // sites x specs: (arrival, vehicle)
+    uint64_t arrivals = 0;
+};
+
+#endif // EVTOLCHARGERS_H
@@ -0,0 +1,83 @@
+/**
+ * File: evtold.cpp
+ * Long-running what-if query daemon.
+ *
+ * Usage: evtold [--socket PATH] [--workers N] [--cache-entries N] [--cache-dir DIR]
+ *               [--surrogate FILE]
+ *
+ * Keeps a warm worker pool and answers scenario queries on a Unix domain
+ * socket until interrupted (see evtolserver.h for the protocol). Results are
+ * cached in memory (--cache-entries 0 disables the cache) and, with
+ * --cache-dir, on disk. --surrogate loads a model written by evtolsweep --fit
+ * to answer estimate= queries.
+ */
+
+#include "evtolserver.h"
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+QueryServer *active_server = nullptr;
+
+void onSignal(int) {
+    if (active_server) active_server->stop();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string socket_path = "/tmp/evtold.sock";
+    int workers = 0;
+    int cache_entries = 1024;
+    std::string cache_dir;
+    std::string surrogate_path;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            workers = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cache-entries") == 0 && i + 1 < argc) {
+            cache_entries = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--surrogate") == 0 && i + 1 < argc) {
+            surrogate_path = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--socket PATH] [--workers N] [--cache-entries N] [--cache-dir DIR] [--surrogate FILE]\n";
+            return 1;
+        }
+    }
+
+    std::string error;
+    SurrogateModel surrogate;
+    if (!surrogate_path.empty()) {
+        std::ifstream in(surrogate_path);
+        if (!in || !readSurrogate(in, surrogate, error)) {
+            std::cerr << "evtold: " << surrogate_path << ": " << (in ? error : "cannot open") << "\n";
+            return 1;
+        }
+    }
+
+    ReplicaPool pool(workers);
+    ResultCache cache(static_cast<size_t>(cache_entries > 0 ? cache_entries : 1), cache_dir);
+    QueryServer server(pool, cache_entries > 0 ? &cache : nullptr, surrogate_path.empty() ? nullptr : &surrogate);
+    if (!server.listen(socket_path, error)) {
+        std::cerr << "evtold: " << error << "\n";
+        return 1;
+    }
+
+    active_server = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::cout << "evtold: listening on " << socket_path << " with " << pool.workers() << " workers\n";
+    server.serve();
+    return 0;
+}
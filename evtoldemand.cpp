@@ -0,0 +1,82 @@
+/**
+ * File: evtoldemand.cpp
+ * Demand generation and idle-vehicle matching.
+ */
+
+#include "evtoldemand.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DemandGenerator::reset(const DemandProfile &profile) {
+    hourly_rate = profile.hourly_rate;
+    sites = 0;
+    clock = 0;
+
+    std::vector<double> weights;
+    for (const Vertiport &port : profile.vertiports) {
+        weights.push_back(std::max(port.demand_weight, 0.0));
+        if (port.demand_weight > 0) sites++;
+    }
+    pick_site = std::discrete_distribution<int>(weights.begin(), weights.end());
+}
+
+bool DemandGenerator::next(std::mt19937 &gen, double horizon, TripRequest &request) {
+    if (hourly_rate.empty() || sites < 2) return false;
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    while (clock < horizon) {
+        double hour_end = std::floor(clock) + 1.0;
+        double rate = hourly_rate[static_cast<size_t>(clock) % hourly_rate.size()];
+        double arrival = rate > 0 ? clock - std::log(1.0 - unit(gen)) / rate : hour_end;
+
+        // Memoryless: an arrival past the hour restarts at the next hour's rate
+        if (arrival >= hour_end) {
+            clock = hour_end;
+            continue;
+        }
+        clock = arrival;
+        if (clock >= horizon) break;
+
+        request.time = clock;
+        request.origin = pick_site(gen);
+        do {
+            request.destination = pick_site(gen);
+        } while (request.destination == request.origin);
+        return true;
+    }
+    return false;
+}
+
+void IdleVehicleIndex::reset(size_t sites, size_t vehicles, VertiportGrid *spatial) {
+    grid = spatial;
+    by_site.resize(sites);
+    for (auto &site : by_site) site.clear();
+    site_of.assign(vehicles, -1);
+    range_of.assign(vehicles, 0.0);
+}
+
+void IdleVehicleIndex::insert(int site, double range_miles, int vehicle) {
+    by_site[site].insert({range_miles, vehicle});
+    site_of[vehicle] = site;
+    range_of[vehicle] = range_miles;
+    if (grid) grid->addIdle(site, 1);
+}
+
+void IdleVehicleIndex::erase(int vehicle) {
+    if (site_of[vehicle] < 0) return;
+    by_site[site_of[vehicle]].erase({range_of[vehicle], vehicle});
+    if (grid) grid->addIdle(site_of[vehicle], -1);
+    site_of[vehicle] = -1;
+}
+
+bool IdleVehicleIndex::take(int site, double miles, int &vehicle) {
+    auto &idle = by_site[site];
+    auto it = idle.lower_bound({miles, -1});
+    if (it == idle.end()) return false;
+    vehicle = it->second;
+    idle.erase(it);
+    site_of[vehicle] = -1;
+    if (grid) grid->addIdle(site, -1);
+    return true;
+}
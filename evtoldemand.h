@@ -0,0 +1,85 @@
+/**
+ * File: evtoldemand.h
+ * Passenger demand generation and the idle-vehicle dispatch index.
+ *
+ * DemandGenerator produces trip requests in time order from a DemandProfile.
+ * IdleVehicleIndex keeps, per vertiport, the idle vehicles ordered by the
+ * range they can fly above their reserve, so matching a request to the
+ * vehicle with the least sufficient range is O(log n) in the vehicles idle
+ * at that vertiport, independent of fleet size.
+ */
+
+#ifndef EVTOLDEMAND_H
+#define EVTOLDEMAND_H
+
+#include "evtolsimulation.h"
+#include "evtolspatial.h"
+
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+/**
+ * Struct TripRequest : A passenger trip request between two vertiports.
+ */
+struct TripRequest {
+    double time;  // hours
+    int origin;
+    int destination;
+};
+
+/**
+ * Class DemandGenerator : Time-varying Poisson arrivals of trip requests.
+ *
+ * The rate is piecewise constant per hour, so arrivals are drawn exactly by
+ * restarting the exponential clock at every hour boundary.
+ */
+class DemandGenerator {
+public:
+    void reset(const DemandProfile &profile);
+
+    /**
+     * Draws the next request after the previous one.
+     * returns True if a request arrives before the horizon, false otherwise.
+     */
+    bool next(std::mt19937 &gen, double horizon, TripRequest &request);
+
+private:
+    std::vector<double> hourly_rate;
+    std::discrete_distribution<int> pick_site;
+    int sites = 0;  // Sites with a positive demand weight
+    double clock = 0;
+};
+
+/**
+ * Class IdleVehicleIndex : Idle vehicles per vertiport, ordered by available range.
+ */
+class IdleVehicleIndex {
+public:
+    // Clears the index; a grid, if given, has its idle counts kept in step.
+    void reset(size_t sites, size_t vehicles, VertiportGrid *grid = nullptr);
+
+    void insert(int site, double range_miles, int vehicle);
+    void erase(int vehicle);
+    bool contains(int vehicle) const { return site_of[vehicle] >= 0; }
+
+    /**
+     * Removes the idle vehicle at the site with the least range of at least the given miles.
+     * returns True if one was found, false otherwise.
+     */
+    bool take(int site, double miles, int &vehicle);
+
+    size_t idleAt(int site) const { return by_site[site].size(); }
+
+    // Largest available range among the site's idle vehicles (0 if none).
+    double maxRange(int site) const { return by_site[site].empty() ? 0.0 : by_site[site].rbegin()->first; }
+
+private:
+    VertiportGrid *grid = nullptr;
+    std::vector<std::set<std::pair<double, int>>> by_site;
+    std::vector<int> site_of;  // Site of each idle vehicle, -1 when not idle
+    std::vector<double> range_of;
+};
+
+#endif // EVTOLDEMAND_H
@@ -0,0 +1,86 @@
+/**
+ * File: evtolenergy.cpp
+ * Price integrals and difference-array load profiles.
+ */
+
+#include "evtolenergy.h"
+
+#include <algorithm>
+#include <cmath>
+
+void PriceSchedule::reset(const std::vector<double> &hourly_price) {
+    hourly = hourly_price;
+    cumulative.assign(1, 0.0);
+    for (double price : hourly) cumulative.push_back(cumulative.back() + price);
+}
+
+double PriceSchedule::price(double t) const {
+    if (hourly.empty()) return 0.0;
+    double period = static_cast<double>(hourly.size());
+    double offset = t - std::floor(t / period) * period;
+    size_t hour = std::min(static_cast<size_t>(offset), hourly.size() - 1);
+    return hourly[hour];
+}
+
+double PriceSchedule::integralTo(double t) const {
+    if (hourly.empty()) return 0.0;
+    // Whole periods, whole hours of the last period, then the part of the current hour
+    double period = static_cast<double>(hourly.size());
+    double periods = std::floor(t / period);
+    double offset = t - periods * period;
+    size_t hour = std::min(static_cast<size_t>(offset), hourly.size() - 1);
+    return periods * cumulative.back() + cumulative[hour] + hourly[hour] * (offset - static_cast<double>(hour));
+}
+
+double PriceSchedule::integral(double from, double to) const {
+    return to > from ? integralTo(to) - integralTo(from) : 0.0;
+}
+
+double PriceSchedule::averagePrice(double from, double to) const {
+    return to > from ? integral(from, to) / (to - from) : price(from);
+}
+
+void LoadProfile::reset(double horizon, double bucket_hours) {
+    span = std::max(horizon, 0.0);
+    bucket = bucket_hours > 0 ? bucket_hours : 1.0;
+    size_t buckets = std::max<size_t>(static_cast<size_t>(std::ceil(span / bucket)), 1);
+    rate_change.assign(buckets + 1, 0.0);
+    partial.assign(buckets, 0.0);
+    bucket_kw.assign(buckets, 0.0);
+}
+
+size_t LoadProfile::bucketOf(double t) const {
+    if (t <= 0) return 0;
+    return std::min(static_cast<size_t>(t / bucket), partial.size() - 1);
+}
+
+void LoadProfile::add(double start, double end, double kw) {
+    start = std::max(start, 0.0);
+    end = std::min(end, span);
+    if (end <= start || kw == 0) return;
+
+    // The ends go to their buckets directly; the buckets in between through the rate change
+    size_t first = bucketOf(start);
+    size_t last = bucketOf(end);
+    if (first == last) {
+        partial[first] += kw * (end - start);
+        return;
+    }
+    partial[first] += kw * ((first + 1) * bucket - start);
+    partial[last] += kw * (end - last * bucket);
+    rate_change[first + 1] += kw;
+    rate_change[last] -= kw;
+}
+
+void LoadProfile::finish() {
+    double rate = 0;
+    for (size_t i = 0; i < partial.size(); i++) {
+        rate += rate_change[i];
+        double length = std::min(bucket, span - i * bucket);
+        bucket_kw[i] = length > 0 ? (rate * bucket + partial[i]) / length : 0.0;
+    }
+}
+
+double LoadProfile::peak() const {
+    return bucket_kw.empty() ? 0.0 : *std::max_element(bucket_kw.begin(), bucket_kw.end());
+}
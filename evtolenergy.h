@@ -0,0 +1,80 @@
+/**
+ * File: evtolenergy.h
+ * Time-of-use electricity prices and charger load profiles.
+ *
+ * PriceSchedule keeps the running integral of an hourly price table, so the
+ * price at any time, its average over any window and the cost of a constant
+ * draw over a window are all O(1), which lets charging policies look ahead.
+ *
+ * LoadProfile aggregates constant draws over [start, end) into fixed-width
+ * time buckets. Each draw touches a difference array at its two ends only;
+ * the bucket loads are recovered with one prefix sum when the profile is
+ * finished, so a run costs O(1) per charging session plus O(buckets).
+ */
+
+#ifndef EVTOLENERGY_H
+#define EVTOLENERGY_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Class PriceSchedule : Hourly energy prices, repeating, with O(1) window queries.
+ */
+class PriceSchedule {
+public:
+    // hourly_price[i] applies from hour i, repeating every hourly_price.size() hours; empty is free.
+    void reset(const std::vector<double> &hourly_price);
+
+    // Price per kWh at time t (hours).
+    double price(double t) const;
+
+    // Integral of the price over [from, to), in price x hours.
+    double integral(double from, double to) const;
+
+    // Mean price over [from, to); the price at from for an empty window.
+    double averagePrice(double from, double to) const;
+
+    // Cost of drawing kw over [from, to).
+    double cost(double from, double to, double kw) const { return kw * integral(from, to); }
+
+private:
+    double integralTo(double t) const;
+
+    std::vector<double> hourly;
+    std::vector<double> cumulative;  // Integral over the first i hours of one period
+};
+
+/**
+ * Class LoadProfile : Mean power per time bucket over a window.
+ */
+class LoadProfile {
+public:
+    // Covers [0, horizon) with buckets of bucket_hours; the last bucket may be shorter.
+    void reset(double horizon, double bucket_hours);
+
+    // Adds a constant draw of kw over [start, end); a negative kw takes one back.
+    void add(double start, double end, double kw);
+
+    // Folds the added draws into load(); later adds need another finish().
+    void finish();
+
+    // Mean kW of each bucket, as of the last finish().
+    const std::vector<double> &load() const { return bucket_kw; }
+
+    double bucketHours() const { return bucket; }
+
+    // Highest bucket load, as of the last finish().
+    double peak() const;
+
+private:
+    size_t bucketOf(double t) const;
+
+    double span = 0;
+    double bucket = 1;
+    std::vector<double> rate_change;  // Draw starting to cover whole buckets from each bucket on
+    std::vector<double> partial;  // Energy of draws covering part of each bucket
+    std::vector<double> bucket_kw;
+};
+
+#endif // EVTOLENERGY_H
@@ -0,0 +1,938 @@
+/**
+ * File: evtolengine.cpp
+ * Discrete-event simulation engine behind SimulationContext.
+ */
+
+#include "evtolengine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace {
+
+// True if two specs produce the same charge curve.
+bool sameCurve(const EVTOL_Spec &a, const EVTOL_Spec &b) {
+    return a.charge_time == b.charge_time && a.cv_soc == b.cv_soc && a.taper_power == b.taper_power;
+}
+
+// Flight legs ending this close to the horizon are treated as reaching it
+const double kTimeEpsilon = 1e-9;
+
+// Bisection steps when solving for a partial charge's end time
+const int kTargetIterations = 48;
+
+// True if two specs produce the same route times and energy.
+bool sameRouteSpec(const EVTOL_Spec &a, const EVTOL_Spec &b) {
+    return a.cruise_speed == b.cruise_speed && a.energy_use == b.energy_use;
+}
+
+} // namespace
+
+void SimulationContext::run(const Scenario &scenario) {
+    reset(scenario);
+    int shifts = std::max(scenario.shifts.count, 1);
+    for (int shift = 0; shift < shifts; shift++) {
+        startShift(scenario, shift);
+        while (!events.empty()) {
+            Event event = events.pop();
+            events_processed++;
+            if (recorder.enabled()) landUntil(event.time);
+            if (sense_params && event.vehicle >= 0) {
+                auto grad = event_grad.begin() + event.vehicle * sense_params;
+                std::copy(grad, grad + sense_params, clock_grad.begin());
+            }
+
+            switch (event.type) {
+            case EventType::Depleted:
+                landed(scenario, event.vehicle, event.time, true);
+                break;
+            case EventType::TripDone:
+                landed(scenario, event.vehicle, event.time, false);
+                break;
+            case EventType::ChargeDone:
+                finishCharge(scenario, event.vehicle, event.time);
+                break;
+            case EventType::Request:
+                requestArrived(scenario, next_request);
+                break;
+            case EventType::RepairDone:
+                finishRepair(scenario, event.vehicle, event.time);
+                break;
+            case EventType::SlotStart:
+                startCharge(scenario, event.vehicle, unit_class[booked_unit[event.vehicle]], event.time);
+                break;
+            }
+            if (recorder.enabled()) sample(event.time);
+        }
+
+        // Requests still waiting at the horizon were never served
+        for (const auto &queue : pending) demand_stats.dropped += queue.size();
+        endShift(scenario);
+    }
+
+    aggregateCompanies(scenario);
+}
+
+VehicleColumns SimulationContext::vehicles() const {
+    return {ColumnView<int>(vehicle_id), ColumnView<int>(spec_index),
+            ColumnView<double>(flight_time), ColumnView<double>(distance),
+            ColumnView<double>(charge_time), ColumnView<int>(faults),
+            ColumnView<double>(passenger_miles), ColumnView<int>(trips),
+            ColumnView<double>(capacity)};
+}
+
+CompanyColumns SimulationContext::companies() const {
+    return {ColumnView<int>(company_vehicle_count), ColumnView<double>(company_flight_time),
+            ColumnView<double>(company_distance), ColumnView<double>(company_charge_time),
+            ColumnView<int>(company_faults), ColumnView<double>(company_passenger_miles)};
+}
+
+void SimulationContext::reset(const Scenario &scenario) {
+    size_t n = static_cast<size_t>(scenario.fleetSize());
+    unsigned int seed = scenario.seed != 0 ? scenario.seed : std::random_device{}();
+    gen.seed(seed);
+    draws.seed(seed);
+
+    // Deploy the fixed fleet mix, otherwise vehicles drawn at random from the spec table
+    int specs = static_cast<int>(scenario.specs.size());
+    vehicle_id.resize(n);
+    spec_index.resize(n);
+    size_t v = 0;
+    for (size_t s = 0; s < scenario.fleet_mix.size(); s++) {
+        for (int k = 0; k < scenario.fleet_mix[s]; k++, v++) {
+            spec_index[v] = static_cast<int>(s);
+        }
+    }
+    for (v = 0; v < n; v++) {
+        vehicle_id[v] = static_cast<int>(v) + 1;
+        if (scenario.fleet_mix.empty()) spec_index[v] = draws.index(specs);
+    }
+
+    flight_time.assign(n, 0.0);
+    distance.assign(n, 0.0);
+    charge_time.assign(n, 0.0);
+    faults.assign(n, 0);
+    passenger_miles.assign(n, 0.0);
+    trips.assign(n, 0);
+    battery_soc.assign(n, 1.0);
+    capacity.assign(n, 1.0);
+    cycle_soc.assign(n, 0.0);
+    shift_stats = ShiftStats();
+    recorder.reset(static_cast<size_t>(std::max(scenario.series_points, 0)));
+    sense_params = sensing(scenario) ? 2 * scenario.specs.size() + 1 : 0;
+    event_grad.assign(n * sense_params, 0.0);
+    clock_grad.assign(sense_params, 0.0);
+    sensitivity_stats.valid = sense_params > 0;
+    sensitivity_stats.passenger_miles.assign(sense_params, 0.0);
+    sensitivity_stats.charge_time.assign(sense_params, 0.0);
+    fleet_passenger_miles = 0;
+    buildCurves(scenario);
+
+    charge_start.assign(n, 0.0);
+    charge_start_soc.assign(n, 0.0);
+    charge_end.assign(n, 0.0);
+    charge_class.assign(n, -1);
+    charge_kw.assign(n, 0.0);
+    plug_time.assign(n, 0.0);
+    events_processed = 0;
+    preemption_count = 0;
+
+    // One charger site per vertiport in demand mode, otherwise a single site
+    const DemandProfile &profile = scenario.demand;
+    size_t sites = profile.enabled ? profile.vertiports.size() : 1;
+    if (scenario.charger_classes.empty()) {
+        site_classes.assign(1, ChargerClass{scenario.chargers, 1.0, {}});
+    } else {
+        site_classes = scenario.charger_classes;
+    }
+    size_t classes = site_classes.size();
+    site_chargers.resize(sites * classes);
+    for (size_t s = 0; s < sites; s++) {
+        for (size_t c = 0; c < classes; c++) {
+            bool plain = scenario.charger_classes.empty() && profile.enabled;
+            site_chargers[s * classes + c] = plain ? profile.vertiports[s].chargers : site_classes[c].count;
+        }
+    }
+
+    // Reservations and occupancy timelines follow individual chargers, so expand the classes into units
+    unit_class.clear();
+    site_units.assign(1, 0);
+    for (size_t s = 0; s < sites; s++) {
+        for (size_t c = 0; c < classes; c++) {
+            unit_class.insert(unit_class.end(), site_chargers[s * classes + c], static_cast<int>(c));
+        }
+        site_units.push_back(static_cast<int>(unit_class.size()));
+    }
+    free_units.resize(sites * classes);
+    charge_unit.assign(n, -1);
+    occupancy_stats = OccupancyStats();
+    calendars.resize(reserving(scenario) ? unit_class.size() : 0);
+    booked_start.assign(n, 0.0);
+    active_charges.resize(sites);
+    vehicle_site.assign(n, 0);
+
+    prices.reset(scenario.energy.hourly_price);
+    site_load.resize(scenario.energy.enabled ? sites : 0);
+    power_waiting.resize(sites);
+    energy_stats = EnergyStats();
+
+    needs_repair.assign(n, 0);
+    bay_request.assign(n, 0.0);
+    bay_waiting.resize(sites);
+    maintenance_stats = MaintenanceStats();
+
+    trip_sampler.reset(scenario.missions);
+    next_trip.assign(scenario.missions.enabled ? n : 0, -1.0);
+
+    demand_stats = DemandStats();
+    pending.resize(profile.enabled ? sites : 0);
+    if (profile.enabled) {
+        // Spread the fleet round-robin over the vertiports
+        grid.build(profile.vertiports);
+        buildRoutes(scenario);
+        for (size_t v = 0; v < n; v++) vehicle_site[v] = static_cast<int>(v % sites);
+    }
+}
+
+void SimulationContext::startShift(const Scenario &scenario, int shift) {
+    // Queues, calendars and bays start every shift empty; vehicles keep their state
+    size_t n = vehicle_id.size();
+    size_t sites = active_charges.size();
+    charge_event.assign(n, kNoEvent);
+    events.clear();
+    events.reserve(n);
+    chargers.reset(site_classes, scenario.specs.size(), site_chargers);
+    for (auto &calendar : calendars) calendar.clear();
+    booked_unit.assign(n, -1);
+    for (auto &units : free_units) units.clear();
+    for (size_t s = 0; s < sites; s++) {
+        for (int unit = site_units[s + 1] - 1; unit >= site_units[s]; unit--) {
+            free_units[s * site_classes.size() + unit_class[unit]].push_back(unit);
+        }
+    }
+    timeline.reset(scenario.occupancy_slot_hours > 0 ? unit_class.size() : 0, scenario.horizon_hours,
+                   scenario.occupancy_slot_hours);
+    for (auto &active : active_charges) active.clear();
+    free_bays.assign(sites, scenario.maintenance.enabled ? scenario.maintenance.bays : 0);
+    for (auto &queue : bay_waiting) queue.clear();
+    for (auto &queue : pending) queue.clear();
+    site_draw.assign(sites, 0.0);
+    for (auto &queue : power_waiting) queue.clear();
+    for (auto &load : site_load) load.reset(scenario.horizon_hours, scenario.energy.bucket_hours);
+    landings.clear();
+    charge_waiting.assign(n, 0);
+    airborne_count = 0;
+    waiting_count = 0;
+    charging_count = 0;
+
+    const DemandProfile &profile = scenario.demand;
+    if (profile.enabled) {
+        // Schedule the shift's first request
+        idle.reset(sites, n, &grid);
+        demand.reset(profile);
+        if (demand.next(gen, scenario.horizon_hours, next_request)) {
+            events.push(next_request.time, -1, EventType::Request);
+        }
+    }
+
+    for (int v = 0; v < static_cast<int>(n); v++) {
+        if (shift == 0) {
+            takeOff(scenario, v, 0.0);
+            continue;
+        }
+        if (scenario.shifts.overnight_charge) {
+            cycle_soc[v] += 1.0 - battery_soc[v];
+            battery_soc[v] = 1.0;
+        }
+        landed(scenario, v, 0.0, battery_soc[v] <= 0);
+    }
+    if (recorder.enabled()) sample(0.0);
+}
+
+void SimulationContext::endShift(const Scenario &scenario) {
+    const ShiftProfile &profile = scenario.shifts;
+    if (recorder.enabled()) {
+        // Flights still in the air at the horizon stay airborne in the last sample
+        landUntil(scenario.horizon_hours);
+        sample(scenario.horizon_hours);
+        recorder.finishShift(shift_stats.shifts * scenario.horizon_hours);
+    }
+
+    double miles = 0;
+    for (double m : passenger_miles) miles += m;
+    double shift_miles = miles - shift_stats.total_passenger_miles;
+    bool first = shift_stats.shifts == 0;
+    shift_stats.shifts++;
+    shift_stats.total_passenger_miles = miles;
+    shift_stats.last_passenger_miles = shift_miles;
+    shift_stats.min_passenger_miles = first ? shift_miles : std::min(shift_stats.min_passenger_miles, shift_miles);
+    shift_stats.max_passenger_miles = first ? shift_miles : std::max(shift_stats.max_passenger_miles, shift_miles);
+
+    // Fade each battery by the full cycles it charged this shift
+    double total = 0;
+    shift_stats.min_capacity = 1.0;
+    for (size_t v = 0; v < capacity.size(); v++) {
+        double faded = capacity[v] - profile.fade_per_cycle * cycle_soc[v];
+        capacity[v] = std::max(faded, std::min(profile.min_capacity, capacity[v]));
+        cycle_soc[v] = 0;
+        total += capacity[v];
+        shift_stats.min_capacity = std::min(shift_stats.min_capacity, capacity[v]);
+    }
+    shift_stats.mean_capacity = capacity.empty() ? 1.0 : total / capacity.size();
+
+    for (auto &load : site_load) {
+        load.finish();
+        energy_stats.peak_kw = std::max(energy_stats.peak_kw, load.peak());
+    }
+
+    // Sum the shift's occupancy; sites without chargers are never all busy
+    if (timeline.chargers() == 0) return;
+    double window = timeline.slots() * timeline.slotHours();
+    OccupancyStats &occupancy = occupancy_stats;
+    occupancy.chargers = timeline.chargers();
+    occupancy.charger_hours += timeline.chargers() * window;
+    for (size_t unit = 0; unit < timeline.chargers(); unit++) {
+        occupancy.busy_hours += timeline.busySlots(unit) * timeline.slotHours();
+        IdleGaps gaps = timeline.idleGaps(unit);
+        occupancy.idle_gaps += gaps.count;
+        occupancy.longest_gap_hours = std::max(occupancy.longest_gap_hours, gaps.longest_hours);
+    }
+    for (size_t s = 0; s + 1 < site_units.size(); s++) {
+        if (site_units[s] == site_units[s + 1]) continue;
+        occupancy.site_hours += window;
+        occupancy.all_busy_hours += timeline.allBusySlots(site_units[s], site_units[s + 1]) * timeline.slotHours();
+    }
+}
+
+void SimulationContext::flightStarted(double landing) {
+    if (!recorder.enabled()) return;
+    airborne_count++;
+    landings.push_back(landing);
+    std::push_heap(landings.begin(), landings.end(), std::greater<double>());
+}
+
+void SimulationContext::landUntil(double now) {
+    // Each landing before now is a change of state with no event of its own
+    while (!landings.empty() && landings.front() <= now) {
+        double landing = landings.front();
+        std::pop_heap(landings.begin(), landings.end(), std::greater<double>());
+        landings.pop_back();
+        airborne_count--;
+        sample(landing);
+    }
+}
+
+void SimulationContext::sample(double now) {
+    recorder.record(now, airborne_count, waiting_count, charging_count, fleet_passenger_miles);
+}
+
+void SimulationContext::takeOff(const Scenario &scenario, int vehicle, double now) {
+    if (scenario.demand.enabled) {
+        vehicleIdle(scenario, vehicle, now);
+    } else if (scenario.missions.enabled) {
+        startTrip(scenario, vehicle, now);
+    } else {
+        startFlight(scenario, vehicle, now);
+    }
+}
+
+void SimulationContext::startFlight(const Scenario &scenario, int vehicle, double now) {
+    const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+
+    // Fly until the battery is depleted or the window closes
+    double range_time = capacity[vehicle] * spec.battery_capacity / (spec.energy_use * spec.cruise_speed);
+    double endurance = range_time * battery_soc[vehicle];
+    double leg = std::min(endurance, scenario.horizon_hours - now);
+    if (leg <= 0) return;
+    battery_soc[vehicle] = leg < endurance ? battery_soc[vehicle] - leg / range_time : 0.0;
+    if (sense_params) senseFlight(scenario, vehicle, endurance, leg < endurance);
+
+    double leg_distance = leg * spec.cruise_speed;
+    flight_time[vehicle] += leg;
+    distance[vehicle] += leg_distance;
+    passenger_miles[vehicle] += spec.passenger_count * leg_distance;
+    fleet_passenger_miles += spec.passenger_count * leg_distance;
+    flightStarted(now + leg);
+
+    // One fault draw per started hour of flight
+    for (double hour = 0; hour < leg; hour += 1.0) {
+        if (draws.uniform() < spec.fault_probability) {
+            recordFault(scenario, vehicle);
+        }
+    }
+
+    if (now + leg < scenario.horizon_hours - kTimeEpsilon) {
+        events.push(now + leg, vehicle, EventType::Depleted);
+        if (reserving(scenario)) bookCharger(scenario, vehicle, now + leg, 0.0);
+    }
+}
+
+void SimulationContext::startTrip(const Scenario &scenario, int vehicle, double now) {
+    if (now >= scenario.horizon_hours - kTimeEpsilon) return;
+    const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+    const MissionProfile &mission = scenario.missions;
+
+    // A trip longer than a full battery allows (above reserve) is flown as the longest possible trip
+    double range_miles = capacity[vehicle] * spec.battery_capacity / spec.energy_use;
+    double usable = std::max(1.0 - mission.reserve_soc, 0.0);
+    if (next_trip[vehicle] < 0) {
+        next_trip[vehicle] = std::min(trip_sampler.next(gen), usable * range_miles);
+    }
+
+    // Charge first if the trip would dig into the reserve
+    double trip_soc = next_trip[vehicle] / range_miles;
+    if (battery_soc[vehicle] - trip_soc < mission.reserve_soc - kTimeEpsilon) {
+        requestCharger(scenario, vehicle, now);
+        return;
+    }
+
+    // Fly the trip; the part past the end of the window is not counted
+    double duration = next_trip[vehicle] / spec.cruise_speed;
+    double flown = std::min(duration, scenario.horizon_hours - now);
+    double flown_distance = flown * spec.cruise_speed;
+    flight_time[vehicle] += flown;
+    distance[vehicle] += flown_distance;
+    passenger_miles[vehicle] += spec.passenger_count * flown_distance;
+    fleet_passenger_miles += spec.passenger_count * flown_distance;
+    flightStarted(now + duration);
+    battery_soc[vehicle] -= flown_distance / range_miles;
+    trips[vehicle]++;
+    next_trip[vehicle] = -1.0;
+
+    // Fault probability over the trip at the spec's per-hour rate
+    if (draws.uniform() < 1.0 - std::pow(1.0 - spec.fault_probability, flown)) {
+        recordFault(scenario, vehicle);
+    }
+
+    // Zero-length trips with no turnaround would never advance time, so they end the day
+    double ready = now + duration + mission.turnaround_hours;
+    if (ready > now && ready < scenario.horizon_hours - kTimeEpsilon) {
+        events.push(ready, vehicle, EventType::TripDone);
+    }
+}
+
+void SimulationContext::requestCharger(const Scenario &scenario, int vehicle, double now) {
+    if (!charge_waiting[vehicle]) {
+        charge_waiting[vehicle] = 1;
+        waiting_count++;
+    }
+
+    // Charge at the booked slot, booking one now if there is none
+    if (reserving(scenario)) {
+        if (booked_unit[vehicle] < 0) bookCharger(scenario, vehicle, now, battery_soc[vehicle]);
+        if (booked_unit[vehicle] < 0) return;
+        if (booked_start[vehicle] <= now + kTimeEpsilon) {
+            startCharge(scenario, vehicle, unit_class[booked_unit[vehicle]], now);
+        } else {
+            events.push(booked_start[vehicle], vehicle, EventType::SlotStart);
+        }
+        return;
+    }
+
+    // Take the best free charger or preempt a nearly full vehicle, otherwise wait in line
+    int site = vehicle_site[vehicle];
+    int charger_class = chargers.acquire(site, spec_index[vehicle]);
+    if (charger_class < 0 && scenario.preemption) {
+        charger_class = preemptCharge(scenario, site, vehicle, now);
+    }
+    if (charger_class >= 0) {
+        plugIn(scenario, vehicle, charger_class, now);
+    } else {
+        chargers.wait(site, spec_index[vehicle], vehicle);
+    }
+}
+
+void SimulationContext::startCharge(const Scenario &scenario, int vehicle, int charger_class, double now) {
+    const ChargeCurve &curve = curves[spec_index[vehicle]];
+    double power = chargePower(vehicle, charger_class);
+    charge_class[vehicle] = charger_class;
+    charge_start[vehicle] = now;
+    charge_start_soc[vehicle] = battery_soc[vehicle];
+    if (charge_waiting[vehicle]) {
+        charge_waiting[vehicle] = 0;
+        waiting_count--;
+    }
+    charging_count++;
+
+    // Charge to the target; time past the end of the window is not counted
+    double duration = chargeTarget(scenario, vehicle, power, now);
+    double remaining = scenario.horizon_hours - now;
+    if (duration < remaining) {
+        charge_time[vehicle] += duration;
+        battery_soc[vehicle] = curve.socAfter(charge_start_soc[vehicle], duration * power);
+        charge_end[vehicle] = now + duration;
+        charge_event[vehicle] = events.push(now + duration, vehicle, EventType::ChargeDone);
+        if (sense_params) senseCharge(scenario, vehicle, duration, false);
+    } else {
+        charge_time[vehicle] += remaining;
+        battery_soc[vehicle] = curve.socAfter(charge_start_soc[vehicle], remaining * power);
+        charge_end[vehicle] = scenario.horizon_hours;
+        if (sense_params) senseCharge(scenario, vehicle, duration, true);
+    }
+    cycle_soc[vehicle] += battery_soc[vehicle] - charge_start_soc[vehicle];
+    active_charges[vehicle_site[vehicle]].insert({charge_end[vehicle], vehicle});
+
+    if (timeline.chargers() > 0) {
+        // The booked unit, otherwise any free unit of the class
+        int unit = booked_unit[vehicle];
+        auto &units = free_units[vehicle_site[vehicle] * site_classes.size() + charger_class];
+        if (!reserving(scenario) && !units.empty()) {
+            unit = units.back();
+            units.pop_back();
+        }
+        charge_unit[vehicle] = unit;
+        if (unit >= 0) timeline.mark(unit, now, charge_end[vehicle]);
+    }
+
+    if (scenario.energy.enabled) {
+        // The session draws its mean power: the energy taken on over its length in the window
+        const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+        double kwh = (battery_soc[vehicle] - charge_start_soc[vehicle]) * capacity[vehicle] * spec.battery_capacity;
+        double length = charge_end[vehicle] - now;
+        charge_kw[vehicle] = length > 0 ? kwh / length : 0.0;
+        meterCharge(vehicle, 1.0, now);
+        site_draw[vehicle_site[vehicle]] += peakDraw(scenario, vehicle, charger_class);
+    }
+}
+
+void SimulationContext::finishCharge(const Scenario &scenario, int vehicle, double now) {
+    int site = vehicle_site[vehicle];
+    charge_event[vehicle] = kNoEvent;
+    active_charges[site].erase({charge_end[vehicle], vehicle});
+    charging_count--;
+
+    if (scenario.energy.enabled) site_draw[site] -= peakDraw(scenario, vehicle, charge_class[vehicle]);
+    releaseUnit(scenario, vehicle);
+
+    // Hand the charger to the next vehicle in line it fits, then take off again
+    if (reserving(scenario)) {
+        cancelBooking(vehicle);
+    } else {
+        int next = chargers.release(site, charge_class[vehicle]);
+        if (next >= 0) plugIn(scenario, next, charge_class[vehicle], now);
+        if (capped(scenario)) admitWaiting(scenario, site, now);
+    }
+    takeOff(scenario, vehicle, now);
+}
+
+void SimulationContext::plugIn(const Scenario &scenario, int vehicle, int charger_class, double now) {
+    if (!capped(scenario)) {
+        startCharge(scenario, vehicle, charger_class, now);
+        return;
+    }
+
+    // Queue for power behind any vehicle already plugged in and waiting
+    int site = vehicle_site[vehicle];
+    plug_time[vehicle] = now;
+    power_waiting[site].emplace_back(vehicle, charger_class);
+    admitWaiting(scenario, site, now);
+}
+
+void SimulationContext::admitWaiting(const Scenario &scenario, int site, double now) {
+    // A session starts once it fits under the cap, or if nothing else charges at the site
+    auto &queue = power_waiting[site];
+    while (!queue.empty()) {
+        int vehicle = queue.front().first;
+        int charger_class = queue.front().second;
+        double draw = peakDraw(scenario, vehicle, charger_class);
+        if (site_draw[site] > kTimeEpsilon && site_draw[site] + draw > scenario.energy.site_power_kw + kTimeEpsilon) {
+            return;
+        }
+        queue.pop_front();
+        energy_stats.power_wait_hours += now - plug_time[vehicle];
+        startCharge(scenario, vehicle, charger_class, now);
+    }
+}
+
+void SimulationContext::meterCharge(int vehicle, double sign, double from) {
+    // The session's draw from the given time to its end, added or taken back
+    double end = charge_end[vehicle];
+    double kw = sign * charge_kw[vehicle];
+    energy_stats.energy_kwh += kw * std::max(end - from, 0.0);
+    energy_stats.cost += prices.cost(from, end, kw);
+    site_load[vehicle_site[vehicle]].add(from, end, kw);
+}
+
+double SimulationContext::peakDraw(const Scenario &scenario, int vehicle, int charger_class) const {
+    // The charge curve's peak rate, scaled by the class, in kW
+    const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+    return chargers.power(charger_class) * curves[spec_index[vehicle]].peakRate() * spec.battery_capacity;
+}
+
+void SimulationContext::releaseUnit(const Scenario &scenario, int vehicle) {
+    int unit = charge_unit[vehicle];
+    charge_unit[vehicle] = -1;
+    if (unit < 0 || reserving(scenario)) return;
+    free_units[vehicle_site[vehicle] * site_classes.size() + charge_class[vehicle]].push_back(unit);
+}
+
+bool SimulationContext::capped(const Scenario &scenario) const {
+    return scenario.energy.enabled && scenario.energy.site_power_kw > 0 && !reserving(scenario);
+}
+
+int SimulationContext::preemptCharge(const Scenario &scenario, int site, int arriving, double now) {
+    // The session closest to finishing on a charger the arrival fits holds the
+    // most charge relative to its need
+    auto &active = active_charges[site];
+    auto session = active.begin();
+    while (session != active.end() && !chargers.fits(charge_class[session->second], spec_index[arriving])) {
+        ++session;
+    }
+    if (session == active.end()) return -1;
+
+    int vehicle = session->second;
+    const ChargeCurve &curve = curves[spec_index[vehicle]];
+    double elapsed = now - charge_start[vehicle];
+    double soc = curve.socAfter(charge_start_soc[vehicle], elapsed * chargePower(vehicle, charge_class[vehicle]));
+    if (soc < scenario.preempt_soc) return -1;
+
+    // Undo the unused part of the session and send the vehicle flying; the arrival keeps its charger
+    events.cancel(charge_event[vehicle]);
+    charge_event[vehicle] = kNoEvent;
+    active.erase(session);
+    charging_count--;
+    charge_time[vehicle] -= std::min(charge_end[vehicle], scenario.horizon_hours) - now;
+    cycle_soc[vehicle] -= battery_soc[vehicle] - soc;
+    battery_soc[vehicle] = soc;
+    if (charge_unit[vehicle] >= 0) timeline.clear(charge_unit[vehicle], now, charge_end[vehicle]);
+    releaseUnit(scenario, vehicle);
+    if (scenario.energy.enabled) {
+        // Re-meter the session as cut short, at the mean draw of the charge it got
+        const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+        double kwh = (soc - charge_start_soc[vehicle]) * capacity[vehicle] * spec.battery_capacity;
+        meterCharge(vehicle, -1.0, charge_start[vehicle]);
+        charge_end[vehicle] = now;
+        charge_kw[vehicle] = now > charge_start[vehicle] ? kwh / (now - charge_start[vehicle]) : 0.0;
+        meterCharge(vehicle, 1.0, charge_start[vehicle]);
+        site_draw[site] -= peakDraw(scenario, vehicle, charge_class[vehicle]);
+    }
+    preemption_count++;
+    int freed = charge_class[vehicle];
+    takeOff(scenario, vehicle, now);
+    return freed;
+}
+
+bool SimulationContext::sensing(const Scenario &scenario) const {
+    return scenario.sensitivities && !scenario.missions.enabled && !scenario.demand.enabled &&
+           !scenario.maintenance.enabled && !scenario.reservations && !scenario.preemption &&
+           !scenario.charge_to_need && std::max(scenario.shifts.count, 1) == 1 && !capped(scenario);
+}
+
+void SimulationContext::senseFlight(const Scenario &scenario, int vehicle, double endurance, bool cut) {
+    // A full flight lasts the range, which grows with battery capacity; one the horizon cuts ends
+    // there, so it shortens as its takeoff moves later
+    const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+    size_t capacity_param = scenario.specs.size() + spec_index[vehicle];
+    double per_kwh = spec.battery_capacity > 0 ? endurance / spec.battery_capacity : 0.0;
+    double miles_per_hour = spec.passenger_count * spec.cruise_speed;
+    double *next = event_grad.data() + vehicle * sense_params;
+    for (size_t k = 0; k < sense_params; k++) {
+        double leg = cut ? -clock_grad[k] : (k == capacity_param ? per_kwh : 0.0);
+        next[k] = clock_grad[k] + leg;
+        sensitivity_stats.passenger_miles[k] += miles_per_hour * leg;
+    }
+}
+
+void SimulationContext::senseCharge(const Scenario &scenario, int vehicle, double duration, bool cut) {
+    // A session's length is proportional to the charge time and inverse to the charger power
+    const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+    size_t charge_param = static_cast<size_t>(spec_index[vehicle]);
+    size_t power_param = sense_params - 1;
+    double per_hour = spec.charge_time > 0 ? duration / spec.charge_time : 0.0;
+    double *next = event_grad.data() + vehicle * sense_params;
+    for (size_t k = 0; k < sense_params; k++) {
+        double length = k == charge_param ? per_hour : (k == power_param ? -duration : 0.0);
+        next[k] = clock_grad[k] + length;
+        sensitivity_stats.charge_time[k] += cut ? -clock_grad[k] : length;
+    }
+}
+
+bool SimulationContext::reserving(const Scenario &scenario) const {
+    return scenario.reservations && !scenario.missions.enabled && !scenario.demand.enabled;
+}
+
+void SimulationContext::bookCharger(const Scenario &scenario, int vehicle, double from, double soc) {
+    // The compatible charger that completes a full charge soonest
+    int site = vehicle_site[vehicle];
+    int spec = spec_index[vehicle];
+    double full = curves[spec].timeToCharge(soc, 1.0);
+    int best = -1;
+    double best_start = 0, best_end = 0;
+    for (int unit = site_units[site]; unit < site_units[site + 1]; unit++) {
+        if (!chargers.fits(unit_class[unit], spec)) continue;
+        double length = full / chargePower(vehicle, unit_class[unit]);
+        double start = calendars[unit].earliestFit(from, length);
+        if (best < 0 || start + length < best_end) {
+            best = unit;
+            best_start = start;
+            best_end = start + length;
+        }
+    }
+
+    // A slot past the horizon would never be used
+    if (best < 0 || best_start >= scenario.horizon_hours - kTimeEpsilon || best_end <= best_start) return;
+    calendars[best].book(best_start, best_end);
+    booked_unit[vehicle] = best;
+    booked_start[vehicle] = best_start;
+}
+
+void SimulationContext::cancelBooking(int vehicle) {
+    if (booked_unit[vehicle] < 0) return;
+    calendars[booked_unit[vehicle]].cancel(booked_start[vehicle]);
+    booked_unit[vehicle] = -1;
+}
+
+void SimulationContext::recordFault(const Scenario &scenario, int vehicle) {
+    faults[vehicle]++;
+    if (scenario.maintenance.enabled) needs_repair[vehicle] = 1;
+}
+
+void SimulationContext::landed(const Scenario &scenario, int vehicle, double now, bool depleted) {
+    if (needs_repair[vehicle]) {
+        // The vehicle misses its charging slot; release it for others
+        cancelBooking(vehicle);
+        requestBay(scenario, vehicle, now);
+    } else if (depleted) {
+        requestCharger(scenario, vehicle, now);
+    } else {
+        takeOff(scenario, vehicle, now);
+    }
+}
+
+void SimulationContext::requestBay(const Scenario &scenario, int vehicle, double now) {
+    // Same discipline as the chargers: a free bay, otherwise wait in line
+    int site = vehicle_site[vehicle];
+    bay_request[vehicle] = now;
+    if (free_bays[site] > 0) {
+        free_bays[site]--;
+        startRepair(scenario, vehicle, now);
+    } else {
+        bay_waiting[site].push_back(vehicle);
+    }
+}
+
+void SimulationContext::startRepair(const Scenario &scenario, int vehicle, double now) {
+    double end = now + scenario.maintenance.repair_hours;
+    maintenance_stats.repairs++;
+    maintenance_stats.total_wait_hours += now - bay_request[vehicle];
+    maintenance_stats.bay_hours += std::min(end, scenario.horizon_hours) - now;
+    if (end < scenario.horizon_hours - kTimeEpsilon) {
+        events.push(end, vehicle, EventType::RepairDone);
+    }
+}
+
+void SimulationContext::finishRepair(const Scenario &scenario, int vehicle, double now) {
+    int site = vehicle_site[vehicle];
+    needs_repair[vehicle] = 0;
+    if (!bay_waiting[site].empty()) {
+        int next = bay_waiting[site].front();
+        bay_waiting[site].pop_front();
+        startRepair(scenario, next, now);
+    } else {
+        free_bays[site]++;
+    }
+
+    // A vehicle that flew until empty still needs its charge
+    landed(scenario, vehicle, now, battery_soc[vehicle] <= 0);
+}
+
+double SimulationContext::chargeTarget(const Scenario &scenario, int vehicle, double power, double now) const {
+    const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+    const ChargeCurve &curve = curves[spec_index[vehicle]];
+    double soc = battery_soc[vehicle];
+    double full = curve.timeToCharge(soc, 1.0) / power;
+    if (!scenario.charge_to_need || scenario.missions.enabled || scenario.demand.enabled || reserving(scenario)) {
+        return full;
+    }
+
+    // Stop at the first time t where the charge covers flying from t to the horizon.
+    // The charge grows and the need shrinks with t, so bisect on their difference.
+    double range_time = capacity[vehicle] * spec.battery_capacity / (spec.energy_use * spec.cruise_speed);
+    auto surplus = [&](double t) {
+        return curve.socAfter(soc, t * power) * range_time - (scenario.horizon_hours - now - t);
+    };
+    if (surplus(full) <= 0) return full;
+
+    double lo = 0, hi = full;
+    for (int i = 0; i < kTargetIterations; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (surplus(mid) < 0) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return hi;
+}
+
+void SimulationContext::vehicleIdle(const Scenario &scenario, int vehicle, double now) {
+    if (now >= scenario.horizon_hours - kTimeEpsilon) return;
+    if (battery_soc[vehicle] < scenario.demand.charge_below_soc) {
+        requestCharger(scenario, vehicle, now);
+        return;
+    }
+
+    // Serve the oldest live request at this vertiport if the range allows, otherwise wait
+    int site = vehicle_site[vehicle];
+    auto &queue = pending[site];
+    while (!queue.empty() && now - queue.front().time > scenario.demand.max_wait_hours) {
+        queue.pop_front();
+        demand_stats.dropped++;
+    }
+    if (!queue.empty() && availableRange(scenario, vehicle) >= routes.miles(site, queue.front().destination)) {
+        TripRequest request = queue.front();
+        queue.pop_front();
+        flyRequest(scenario, vehicle, request, now);
+        return;
+    }
+    idle.insert(site, availableRange(scenario, vehicle), vehicle);
+}
+
+void SimulationContext::requestArrived(const Scenario &scenario, const TripRequest &request) {
+    demand_stats.requests++;
+    TripRequest arrived = request;
+    if (demand.next(gen, scenario.horizon_hours, next_request)) {
+        events.push(next_request.time, -1, EventType::Request);
+    }
+
+    // No route between the vertiports
+    if (!routes.reachable(arrived.origin, arrived.destination)) {
+        demand_stats.dropped++;
+        return;
+    }
+
+    int vehicle;
+    double miles = routes.miles(arrived.origin, arrived.destination);
+    if (idle.take(arrived.origin, miles, vehicle)) {
+        flyRequest(scenario, vehicle, arrived, arrived.time);
+        return;
+    }
+
+    // Otherwise the nearest vertiport with a vehicle that can reach the origin and fly the trip.
+    // The grid searches by straight-line distance, which never exceeds the route distance.
+    double max_deadhead = scenario.demand.max_deadhead_miles;
+    if (max_deadhead > 0) {
+        const Vertiport &origin = scenario.demand.vertiports[arrived.origin];
+        int site = grid.nearestIdle(origin.x, origin.y, max_deadhead, [&](int candidate, double) {
+            double deadhead = routes.miles(candidate, arrived.origin);
+            return candidate != arrived.origin && deadhead <= max_deadhead &&
+                   idle.maxRange(candidate) >= deadhead + miles;
+        });
+        if (site >= 0) {
+            idle.take(site, routes.miles(site, arrived.origin) + miles, vehicle);
+            flyRequest(scenario, vehicle, arrived, arrived.time, site);
+            return;
+        }
+    }
+    pending[arrived.origin].push_back(arrived);
+}
+
+void SimulationContext::flyRequest(const Scenario &scenario, int vehicle, const TripRequest &request, double now,
+                                   int deadhead_from) {
+    int s = spec_index[vehicle];
+    const EVTOL_Spec &spec = scenario.specs[s];
+    double deadhead_miles = deadhead_from >= 0 ? routes.miles(deadhead_from, request.origin) : 0.0;
+    double deadhead_time = deadhead_from >= 0 ? routes.hours(s, deadhead_from, request.origin) : 0.0;
+    double deadhead_kwh = deadhead_from >= 0 ? routes.kwh(s, deadhead_from, request.origin) : 0.0;
+    demand_stats.served++;
+    demand_stats.total_wait_hours += now + deadhead_time - request.time;
+    if (deadhead_miles > 0) {
+        demand_stats.deadheads++;
+        demand_stats.deadhead_miles += deadhead_miles;
+    }
+
+    // Fly empty to the origin, then to the destination; the part past the end
+    // of the window is not counted and only the trip itself carries passengers
+    double duration = deadhead_time + routes.hours(s, request.origin, request.destination);
+    double energy = deadhead_kwh + routes.kwh(s, request.origin, request.destination);
+    double flown = std::min(duration, scenario.horizon_hours - now);
+    double flown_distance = flown * spec.cruise_speed;
+    double passenger_distance = std::max(flown_distance - deadhead_miles, 0.0);
+    flight_time[vehicle] += flown;
+    distance[vehicle] += flown_distance;
+    passenger_miles[vehicle] += spec.passenger_count * passenger_distance;
+    fleet_passenger_miles += spec.passenger_count * passenger_distance;
+    flightStarted(now + duration);
+    double used = duration > 0 ? energy * flown / duration : 0.0;
+    battery_soc[vehicle] -= used / (capacity[vehicle] * spec.battery_capacity);
+    trips[vehicle]++;
+    vehicle_site[vehicle] = request.destination;
+
+    if (draws.uniform() < 1.0 - std::pow(1.0 - spec.fault_probability, flown)) {
+        recordFault(scenario, vehicle);
+    }
+
+    double ready = now + duration + scenario.demand.turnaround_hours;
+    if (ready < scenario.horizon_hours - kTimeEpsilon) {
+        events.push(ready, vehicle, EventType::TripDone);
+    }
+}
+
+double SimulationContext::availableRange(const Scenario &scenario, int vehicle) const {
+    const EVTOL_Spec &spec = scenario.specs[spec_index[vehicle]];
+    double usable = battery_soc[vehicle] - scenario.demand.reserve_soc;
+    return usable > 0 ? usable * capacity[vehicle] * spec.battery_capacity / spec.energy_use : 0.0;
+}
+
+double SimulationContext::chargePower(int vehicle, int charger_class) const {
+    // A faded battery takes the same power, so it fills in proportionally less time
+    return chargers.power(charger_class) / capacity[vehicle];
+}
+
+void SimulationContext::buildCurves(const Scenario &scenario) {
+    bool unchanged = curve_specs.size() == scenario.specs.size();
+    for (size_t s = 0; unchanged && s < scenario.specs.size(); s++) {
+        unchanged = sameCurve(curve_specs[s], scenario.specs[s]);
+    }
+    if (unchanged) return;
+
+    curve_specs = scenario.specs;
+    curves.clear();
+    for (const EVTOL_Spec &spec : scenario.specs) {
+        curves.emplace_back(spec);
+    }
+}
+
+void SimulationContext::buildRoutes(const Scenario &scenario) {
+    const DemandProfile &profile = scenario.demand;
+    bool unchanged = route_ports.size() == profile.vertiports.size() && route_links.size() == profile.links.size() &&
+                     route_specs.size() == scenario.specs.size();
+    for (size_t p = 0; unchanged && p < profile.vertiports.size(); p++) {
+        unchanged = route_ports[p].x == profile.vertiports[p].x && route_ports[p].y == profile.vertiports[p].y;
+    }
+    for (size_t l = 0; unchanged && l < profile.links.size(); l++) {
+        const RouteLink &a = route_links[l];
+        const RouteLink &b = profile.links[l];
+        unchanged = a.from == b.from && a.to == b.to && a.miles == b.miles;
+    }
+    for (size_t s = 0; unchanged && s < scenario.specs.size(); s++) {
+        unchanged = sameRouteSpec(route_specs[s], scenario.specs[s]);
+    }
+    if (unchanged) return;
+
+    route_ports = profile.vertiports;
+    route_links = profile.links;
+    route_specs = scenario.specs;
+    routes.build(profile, scenario.specs, route_threads);
+}
+
+void SimulationContext::aggregateCompanies(const Scenario &scenario) {
+    size_t companies = scenario.specs.size();
+    company_vehicle_count.assign(companies, 0);
+    company_flight_time.assign(companies, 0.0);
+    company_distance.assign(companies, 0.0);
+    company_charge_time.assign(companies, 0.0);
+    company_faults.assign(companies, 0);
+    company_passenger_miles.assign(companies, 0.0);
+
+    for (size_t v = 0; v < vehicle_id.size(); v++) {
+        int c = spec_index[v];
+        company_vehicle_count[c]++;
+        company_flight_time[c] += flight_time[v];
+        company_distance[c] += distance[v];
+        company_charge_time[c] += charge_time[v];
+        company_faults[c] += faults[v];
+        company_passenger_miles[c] += passenger_miles[v];
+    }
+}
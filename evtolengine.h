@@ -0,0 +1,472 @@
+/**
+ * File: evtolengine.h
+ * Discrete-event simulation engine for in-process embedding.
+ *
+ * SimulationContext runs a Scenario in simulated time on the calling thread
+ * (no sleeps, no per-vehicle threads) and keeps its results in columnar
+ * storage owned by the context. Callers read the results through read-only
+ * views instead of copying them into EVTOL objects or formatted strings.
+ *
+ * Views returned by a context stay valid until the next run() on that same
+ * context; the storage is reused between runs so repeated calls do not
+ * allocate once the context is warm.
+ */
+
+#ifndef EVTOLENGINE_H
+#define EVTOLENGINE_H
+
+#include "evtolcharge.h"
+#include "evtolchargers.h"
+#include "evtoldemand.h"
+#include "evtolrandom.h"
+#include "evtolenergy.h"
+#include "evtolroutes.h"
+#include "evtolevents.h"
+#include "evtolmission.h"
+#include "evtoloccupancy.h"
+#include "evtolreservations.h"
+#include "evtolseries.h"
+#include "evtolsimulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Version of the engine's results; bump whenever the same scenario and seed
+// would produce different numbers, so cached results are invalidated.
+constexpr unsigned int kEngineVersion = 12;
+
+/**
+ * Class ColumnView : Read-only, non-owning view over a contiguous column.
+ */
+template <typename T>
+class ColumnView {
+public:
+    ColumnView() = default;
+    ColumnView(const T *data, size_t size) : ptr(data), count(size) {}
+    explicit ColumnView(const std::vector<T> &column) : ptr(column.data()), count(column.size()) {}
+
+    const T *data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T *begin() const { return ptr; }
+    const T *end() const { return ptr + count; }
+    const T &operator[](size_t i) const { return ptr[i]; }
+
+private:
+    const T *ptr = nullptr;
+    size_t count = 0;
+};
+
+/**
+ * Struct VehicleColumns : Per-vehicle results, one row per deployed vehicle.
+ *
+ * spec_index refers to Scenario::specs of the scenario that was run.
+ */
+struct VehicleColumns {
+    ColumnView<int> vehicle_id;
+    ColumnView<int> spec_index;
+    ColumnView<double> flight_time;  // hours
+    ColumnView<double> distance;  // miles
+    ColumnView<double> charge_time;  // hours
+    ColumnView<int> faults;
+    ColumnView<double> passenger_miles;
+    ColumnView<int> trips;  // Trips flown in mission or demand mode
+    ColumnView<double> capacity;  // Battery capacity left after the run, as a fraction of new
+
+    size_t size() const { return vehicle_id.size(); }
+};
+
+/**
+ * Struct CompanyColumns : Per-company totals, one row per entry of Scenario::specs.
+ */
+struct CompanyColumns {
+    ColumnView<int> vehicle_count;
+    ColumnView<double> flight_time;  // hours
+    ColumnView<double> distance;  // miles
+    ColumnView<double> charge_time;  // hours
+    ColumnView<int> faults;
+    ColumnView<double> passenger_miles;
+
+    size_t size() const { return vehicle_count.size(); }
+};
+
+/**
+ * Struct DemandStats : Outcome of the trip requests of a demand-mode run.
+ */
+struct DemandStats {
+    uint64_t requests = 0;
+    uint64_t served = 0;
+    uint64_t dropped = 0;  // Waited longer than max_wait_hours, or still waiting at the horizon
+    uint64_t deadheads = 0;  // Requests served by a vehicle from another vertiport
+    double total_wait_hours = 0;  // Over served requests, until pickup
+    double deadhead_miles = 0;  // Flown empty to reach requests
+
+    double meanWait() const { return served ? total_wait_hours / served : 0.0; }
+};
+
+/**
+ * Struct MaintenanceStats : Fault repairs of a run with maintenance enabled.
+ */
+struct MaintenanceStats {
+    uint64_t repairs = 0;  // Repairs started
+    double total_wait_hours = 0;  // Spent waiting for a free bay, over started repairs
+    double bay_hours = 0;  // Bay time used within the horizon
+
+    double meanWait() const { return repairs ? total_wait_hours / repairs : 0.0; }
+};
+
+/**
+ * Struct EnergyStats : Metered charging of a run with the energy profile enabled.
+ */
+struct EnergyStats {
+    double energy_kwh = 0;  // Delivered within the horizon
+    double cost = 0;  // At the time-of-use price
+    double peak_kw = 0;  // Highest bucket load of any site
+    double power_wait_hours = 0;  // Plugged in, waiting for room under the site cap
+};
+
+/**
+ * Struct OccupancyStats : Charger occupancy of a run, summed over its shifts.
+ */
+struct OccupancyStats {
+    size_t chargers = 0;
+    double charger_hours = 0;  // Chargers times the window length
+    double busy_hours = 0;  // Charger hours spent charging
+    double site_hours = 0;  // Charger sites times the window length
+    double all_busy_hours = 0;  // Hours in which every charger of a site was charging, over the sites
+    uint64_t idle_gaps = 0;  // Maximal idle stretches, over the chargers
+    double longest_gap_hours = 0;
+
+    double utilization() const { return charger_hours > 0 ? busy_hours / charger_hours : 0.0; }
+    double allBusyFraction() const { return site_hours > 0 ? all_busy_hours / site_hours : 0.0; }
+    double gapsPerCharger() const { return chargers ? static_cast<double>(idle_gaps) / chargers : 0.0; }
+};
+
+/**
+ * Struct SensitivityStats : Pathwise derivatives of a run's fleet totals.
+ *
+ * One entry per parameter: the charge_time of each spec (per hour), then the
+ * battery_capacity of each spec (per kWh), then a factor scaling the power
+ * of every charger (at 1). valid is false when the scenario did not ask for
+ * them or uses a policy the estimator does not cover.
+ */
+struct SensitivityStats {
+    bool valid = false;
+    std::vector<double> passenger_miles;  // d(fleet passenger miles) / d(parameter)
+    std::vector<double> charge_time;  // d(fleet charge hours) / d(parameter)
+};
+
+/**
+ * Struct ShiftStats : Per-shift outcome of a run, folded into running totals.
+ *
+ * Finished shifts are reduced to these aggregates as the run goes, so a run
+ * of any number of shifts takes the memory of a single shift.
+ */
+struct ShiftStats {
+    int shifts = 0;  // Shifts run
+    double total_passenger_miles = 0;  // Over all shifts
+    double min_passenger_miles = 0;  // Fleet total of the weakest shift
+    double max_passenger_miles = 0;  // Fleet total of the strongest shift
+    double last_passenger_miles = 0;  // Fleet total of the final shift
+    double mean_capacity = 1;  // Fleet mean battery capacity at the end, fraction of new
+    double min_capacity = 1;  // Most faded battery at the end
+
+    double meanPassengerMiles() const { return shifts ? total_passenger_miles / shifts : 0.0; }
+};
+
+/**
+ * Class SimulationContext : Reusable discrete-event engine and result storage.
+ *
+ * Vehicles fly until their battery is depleted, queue first-come first-served
+ * for one of Scenario::chargers chargers, charge to full along their
+ * manufacturer's ChargeCurve and fly again, until the scenario horizon.
+ * With Scenario::charge_to_need a vehicle stops charging as soon as it holds
+ * enough energy to fly until the horizon; with Scenario::preemption a depleted
+ * arrival takes the charger of the vehicle closest to finishing, if that
+ * vehicle is already at Scenario::preempt_soc, and the preempted vehicle
+ * takes off with the charge it has.
+ *
+ * With Scenario::charger_classes set, each site has chargers of several power
+ * levels, some limited to certain manufacturers; a vehicle takes the most
+ * powerful free charger it fits, and a freed charger goes to the
+ * longest-waiting vehicle that fits it (see ChargerPool).
+ *
+ * With Scenario::reservations, a vehicle books a full charge on the charger
+ * that finishes it soonest as it takes off, since its depletion time is known
+ * then; each charger keeps a ReservationCalendar and the booking takes the
+ * earliest free slot from the depletion time on. Vehicles charge at their
+ * booked slot instead of queueing. Reservations apply to flying until empty
+ * and replace charge_to_need and preemption.
+ *
+ * With Scenario::missions enabled, each flight is a single trip of sampled
+ * length followed by a ground turnaround, and a vehicle charges when its next
+ * trip would leave less than the reserve in the battery. Mission mode always
+ * charges to full, since the next trip's need is not known in advance.
+ *
+ * With Scenario::demand enabled, vehicles start spread across the vertiports
+ * and fly passenger trip requests instead: a request is matched to the idle
+ * vehicle at its origin with the least range that covers the trip, failing
+ * that to the nearest vertiport (within max_deadhead_miles) with an idle
+ * vehicle that can fly there and then the trip, or waits at its origin until
+ * a vehicle becomes idle there. Route distance, flight time and energy
+ * between vertiports come from a RouteTable computed once per network.
+ * Vehicles below the demand profile's charge_below_soc charge at their
+ * vertiport's chargers.
+ *
+ * With Scenario::maintenance enabled, a vehicle that faulted on its last
+ * flight goes to a maintenance bay at its site when it lands, queueing like a
+ * charger arrival, and resumes (charging first if depleted) once repaired.
+ *
+ * With Scenario::energy enabled, each session's energy and cost are metered
+ * as it starts (and taken back for the unused part if it is preempted), and
+ * its mean draw goes into its site's LoadProfile. With a site power cap, a
+ * vehicle holding a charger starts charging only once the peak draws at its
+ * site leave room for its own; plugged-in vehicles are admitted first-come
+ * first-served as sessions end. The cap does not apply to reservations.
+ *
+ * Unless Scenario::occupancy_slot_hours is 0, every charging session is
+ * also drawn on an OccupancyTimeline row of the charger unit it uses, and
+ * each shift's timeline is summed into OccupancyStats when the shift ends.
+ * Long horizons or many units coarsen the slot (see OccupancyTimeline); a
+ * run with more units than the timeline can hold records no occupancy.
+ * Vehicles plugged in but waiting under a site power cap do not occupy a unit.
+ *
+ * With Scenario::series_points set, the fleet's state (vehicles in flight,
+ * vehicles waiting to charge, sessions in progress, cumulative passenger
+ * miles) is sampled at every event time and at every landing, and kept
+ * downsampled by a SeriesRecorder.
+ *
+ * With Scenario::sensitivities, the run also carries the derivative of every
+ * vehicle's next event time with respect to the SensitivityStats parameters
+ * (infinitesimal perturbation analysis): a flight's length moves with its
+ * range unless the horizon cuts it, a session's start with the event that
+ * freed its charger and its length with the charge time and charger power,
+ * so one pass yields the derivatives of the fleet totals along its sample
+ * path. Where two events tie (identical specs starting together do), the
+ * estimate follows the order the tie was processed in, i.e. one one-sided
+ * derivative. It covers flying until empty with first-come first-served
+ * chargers over a single shift; other policies leave SensitivityStats::valid
+ * false.
+ *
+ * With Scenario::shifts, the window repeats for the given number of shifts.
+ * Each shift restarts the clock at 0 with empty queues, calendars and bays,
+ * and vehicles resume from where the last one left them; the charge each
+ * vehicle took in a shift fades its battery before the next one. Results
+ * accumulate over all shifts.
+ *
+ * A context is not thread-safe; use one context per thread.
+ */
+class SimulationContext {
+public:
+    /**
+     * route_threads is passed to RouteTable::build: 0 picks the hardware
+     * concurrency, 1 builds on the calling thread (as pool workers must).
+     */
+    explicit SimulationContext(int route_threads = 0) : route_threads(route_threads) {}
+
+    SimulationContext(const SimulationContext &) = delete;
+    SimulationContext &operator=(const SimulationContext &) = delete;
+
+    /**
+     * Runs the scenario, replacing the results of any previous run.
+     * Invalidates views obtained before the call.
+     */
+    void run(const Scenario &scenario);
+
+    VehicleColumns vehicles() const;
+    CompanyColumns companies() const;
+
+    // Number of events processed by the last run.
+    uint64_t eventsProcessed() const { return events_processed; }
+
+    // Number of charging sessions cut short by preemption in the last run.
+    uint64_t preemptions() const { return preemption_count; }
+
+    // Trip requests of the last run (demand mode).
+    const DemandStats &demandStats() const { return demand_stats; }
+
+    // Fault repairs of the last run (maintenance enabled).
+    const MaintenanceStats &maintenanceStats() const { return maintenance_stats; }
+
+    // Energy, cost and peak site load of the last run (energy profile enabled).
+    const EnergyStats &energyStats() const { return energy_stats; }
+
+    // Mean charging load of a charger site per bucket of the last shift, in kW.
+    ColumnView<double> siteLoad(size_t site) const { return ColumnView<double>(site_load[site].load()); }
+
+    // Charger occupancy of the last run (timelines enabled).
+    const OccupancyStats &occupancyStats() const { return occupancy_stats; }
+
+    // Charger units' busy slots in the last shift; rows are grouped by site, in unitsOf order.
+    const OccupancyTimeline &occupancy() const { return timeline; }
+
+    // Charger units of a site: [first, second) in occupancy() rows.
+    std::pair<int, int> unitsOf(int site) const { return {site_units[site], site_units[site + 1]}; }
+
+    // Fleet state over the last run, downsampled (series_points set).
+    const FleetSeries &series() const { return recorder.series(); }
+
+    // Derivatives of the last run's fleet totals (sensitivities enabled).
+    const SensitivityStats &sensitivities() const { return sensitivity_stats; }
+
+    // Per-shift totals and battery wear of the last run.
+    const ShiftStats &shiftStats() const { return shift_stats; }
+
+private:
+    void reset(const Scenario &scenario);
+    void startShift(const Scenario &scenario, int shift);
+    void endShift(const Scenario &scenario);
+    void flightStarted(double landing);
+    bool sensing(const Scenario &scenario) const;
+    void senseFlight(const Scenario &scenario, int vehicle, double endurance, bool cut);
+    void senseCharge(const Scenario &scenario, int vehicle, double duration, bool cut);
+    void landUntil(double now);
+    void sample(double now);
+    void takeOff(const Scenario &scenario, int vehicle, double now);
+    void startFlight(const Scenario &scenario, int vehicle, double now);
+    void startTrip(const Scenario &scenario, int vehicle, double now);
+    void requestCharger(const Scenario &scenario, int vehicle, double now);
+    void startCharge(const Scenario &scenario, int vehicle, int charger_class, double now);
+    void finishCharge(const Scenario &scenario, int vehicle, double now);
+    void plugIn(const Scenario &scenario, int vehicle, int charger_class, double now);
+    void admitWaiting(const Scenario &scenario, int site, double now);
+    void meterCharge(int vehicle, double sign, double from);
+    double peakDraw(const Scenario &scenario, int vehicle, int charger_class) const;
+    bool capped(const Scenario &scenario) const;
+    void releaseUnit(const Scenario &scenario, int vehicle);
+    int preemptCharge(const Scenario &scenario, int site, int vehicle, double now);
+    bool reserving(const Scenario &scenario) const;
+    void bookCharger(const Scenario &scenario, int vehicle, double from, double soc);
+    void cancelBooking(int vehicle);
+    void recordFault(const Scenario &scenario, int vehicle);
+    void landed(const Scenario &scenario, int vehicle, double now, bool depleted);
+    void requestBay(const Scenario &scenario, int vehicle, double now);
+    void startRepair(const Scenario &scenario, int vehicle, double now);
+    void finishRepair(const Scenario &scenario, int vehicle, double now);
+    void vehicleIdle(const Scenario &scenario, int vehicle, double now);
+    void requestArrived(const Scenario &scenario, const TripRequest &request);
+    void flyRequest(const Scenario &scenario, int vehicle, const TripRequest &request, double now,
+                    int deadhead_from = -1);
+    double availableRange(const Scenario &scenario, int vehicle) const;
+    double chargePower(int vehicle, int charger_class) const;
+    double chargeTarget(const Scenario &scenario, int vehicle, double power, double now) const;
+    void aggregateCompanies(const Scenario &scenario);
+    void buildCurves(const Scenario &scenario);
+    void buildRoutes(const Scenario &scenario);
+
+    // Per-vehicle columns
+    std::vector<int> vehicle_id;
+    std::vector<int> spec_index;
+    std::vector<double> flight_time;
+    std::vector<double> distance;
+    std::vector<double> charge_time;
+    std::vector<int> faults;
+    std::vector<double> passenger_miles;
+    std::vector<int> trips;
+
+    // Per-company columns
+    std::vector<int> company_vehicle_count;
+    std::vector<double> company_flight_time;
+    std::vector<double> company_distance;
+    std::vector<double> company_charge_time;
+    std::vector<int> company_faults;
+    std::vector<double> company_passenger_miles;
+
+    // Charge curves per spec, rebuilt only when the specs change
+    std::vector<EVTOL_Spec> curve_specs;
+    std::vector<ChargeCurve> curves;
+
+    // Engine state, kept between runs to reuse its capacity
+    std::vector<double> battery_soc;  // State of charge per vehicle, 0 to 1
+    std::vector<double> capacity;  // Battery capacity per vehicle, as a fraction of the spec's
+    std::vector<double> cycle_soc;  // State of charge taken on in the current shift
+    ShiftStats shift_stats;
+    EventQueue events;
+    uint64_t events_processed = 0;
+    uint64_t preemption_count = 0;
+
+    // Charger sites: the vertiports in demand mode, otherwise a single site
+    std::vector<int> vehicle_site;  // Site each vehicle is at (or flying to)
+    std::vector<ChargerClass> site_classes;  // Scenario::charger_classes, or one class of plain chargers
+    std::vector<int> site_chargers;  // Chargers per site and class
+    ChargerPool chargers;
+
+    // Fleet time series
+    SeriesRecorder recorder;
+    std::vector<double> landings;  // Landing times of the flights in the air, a min-heap
+    std::vector<uint8_t> charge_waiting;  // Asked for a charger and not yet charging
+    int airborne_count = 0;
+    int waiting_count = 0;
+    int charging_count = 0;
+    double fleet_passenger_miles = 0;
+
+    // Sensitivities: per-parameter derivatives, parameters innermost
+    size_t sense_params = 0;  // 0 when not sensing
+    std::vector<double> event_grad;  // Of each vehicle's pending event time
+    std::vector<double> clock_grad;  // Of the time of the event being processed
+    SensitivityStats sensitivity_stats;
+
+    // Charger units, grouped by site: booked individually with reservations,
+    // otherwise handed out from per-class free lists for the occupancy timelines
+    std::vector<int> unit_class;  // Charger class of each unit
+    std::vector<int> site_units;  // First unit of each site, plus the total
+    std::vector<std::vector<int>> free_units;  // Per site and class
+    std::vector<int> charge_unit;  // Unit each vehicle is charging on, or -1
+    OccupancyTimeline timeline;
+    OccupancyStats occupancy_stats;
+
+    // Reservations: one calendar per charger unit
+    std::vector<ReservationCalendar> calendars;
+    std::vector<int> booked_unit;  // Unit each vehicle has booked, or -1
+    std::vector<double> booked_start;
+
+    // Charging sessions in progress
+    std::vector<EventHandle> charge_event;  // Pending ChargeDone per vehicle
+    std::vector<double> charge_start;  // Time the session started
+    std::vector<double> charge_start_soc;  // State of charge when it started
+    std::vector<double> charge_end;  // Scheduled end, or the horizon if it runs past it
+    std::vector<int> charge_class;  // Class of the charger in use
+    std::vector<std::set<std::pair<double, int>>> active_charges;  // Per site: (end, vehicle), soonest first
+
+    // Energy metering and the site power cap
+    PriceSchedule prices;
+    std::vector<LoadProfile> site_load;
+    std::vector<double> site_draw;  // Peak draw of the sessions charging at each site, kW
+    std::vector<double> charge_kw;  // Mean draw of each vehicle's session
+    std::vector<std::deque<std::pair<int, int>>> power_waiting;  // Per site: (vehicle, class) over the cap
+    std::vector<double> plug_time;  // Time each waiting vehicle plugged in
+    EnergyStats energy_stats;
+
+    // Maintenance bays, per charger site like the chargers
+    std::vector<uint8_t> needs_repair;  // Faulted on the current flight
+    std::vector<double> bay_request;  // Time each vehicle joined the bay queue
+    std::vector<int> free_bays;
+    std::vector<std::deque<int>> bay_waiting;
+    MaintenanceStats maintenance_stats;
+
+    // Mission mode
+    TripSampler trip_sampler;
+    std::vector<double> next_trip;  // Sampled length of each vehicle's next trip, miles
+
+    // Demand mode
+    DemandGenerator demand;
+    VertiportGrid grid;
+    RouteTable routes;  // Rebuilt only when the vertiports, links or specs change
+    int route_threads = 0;
+    std::vector<Vertiport> route_ports;
+    std::vector<RouteLink> route_links;
+    std::vector<EVTOL_Spec> route_specs;
+    IdleVehicleIndex idle;
+    std::vector<std::deque<TripRequest>> pending;  // Unserved requests per origin, oldest first
+    TripRequest next_request;  // Request of the pending Request event
+    DemandStats demand_stats;
+    std::mt19937 gen;  // Demand and trip samplers
+    BatchRandom draws;  // Deployment and fault draws
+};
+
+#endif // EVTOLENGINE_H
@@ -0,0 +1,111 @@
+/**
+ * File: evtolevents.cpp
+ * Indexed binary heap behind EventQueue.
+ */
+
+#include "evtolevents.h"
+
+EventHandle EventQueue::push(double time, int vehicle, EventType type) {
+    EventHandle handle;
+    if (!free_handles.empty()) {
+        handle = free_handles.back();
+        free_handles.pop_back();
+    } else {
+        handle = static_cast<EventHandle>(position.size());
+        position.push_back(kNoEvent);
+    }
+
+    heap.push_back({time, next_sequence++, vehicle, type, handle});
+    position[handle] = static_cast<uint32_t>(heap.size() - 1);
+    siftUp(heap.size() - 1);
+    return handle;
+}
+
+Event EventQueue::pop() {
+    Event event = heap.front();
+    removeAt(0);
+    return event;
+}
+
+bool EventQueue::cancel(EventHandle handle) {
+    if (!pending(handle)) return false;
+    removeAt(position[handle]);
+    return true;
+}
+
+bool EventQueue::reschedule(EventHandle handle, double time) {
+    if (!pending(handle)) return false;
+    size_t index = position[handle];
+    double old_time = heap[index].time;
+    heap[index].time = time;
+    if (time < old_time) {
+        siftUp(index);
+    } else {
+        siftDown(index);
+    }
+    return true;
+}
+
+bool EventQueue::pending(EventHandle handle) const {
+    return handle < position.size() && position[handle] != kNoEvent;
+}
+
+void EventQueue::clear() {
+    heap.clear();
+    position.clear();
+    free_handles.clear();
+    next_sequence = 0;
+}
+
+void EventQueue::reserve(size_t events) {
+    heap.reserve(events);
+    position.reserve(events);
+}
+
+void EventQueue::place(size_t index, const Event &event) {
+    heap[index] = event;
+    position[event.handle] = static_cast<uint32_t>(index);
+}
+
+void EventQueue::siftUp(size_t index) {
+    Event event = heap[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (!earlier(event, heap[parent])) break;
+        place(index, heap[parent]);
+        index = parent;
+    }
+    place(index, event);
+}
+
+void EventQueue::siftDown(size_t index) {
+    Event event = heap[index];
+    size_t n = heap.size();
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= n) break;
+        if (child + 1 < n && earlier(heap[child + 1], heap[child])) child++;
+        if (!earlier(heap[child], event)) break;
+        place(index, heap[child]);
+        index = child;
+    }
+    place(index, event);
+}
+
+void EventQueue::removeAt(size_t index) {
+    EventHandle handle = heap[index].handle;
+    position[handle] = kNoEvent;
+    free_handles.push_back(handle);
+
+    Event last = heap.back();
+    heap.pop_back();
+    if (index == heap.size()) return;
+
+    // Fill the hole with the last event and restore the heap in whichever direction it needs
+    place(index, last);
+    if (index > 0 && earlier(last, heap[(index - 1) / 2])) {
+        siftUp(index);
+    } else {
+        siftDown(index);
+    }
+}
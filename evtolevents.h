@@ -0,0 +1,86 @@
+/**
+ * File: evtolevents.h
+ * Indexed priority queue of simulation events with cancellation.
+ *
+ * Events are ordered by time, then by insertion order so that simultaneous
+ * events are processed deterministically. push() returns a handle that can
+ * cancel or reschedule the event while it is pending; every operation is
+ * O(log n) in the number of pending events.
+ */
+
+#ifndef EVTOLEVENTS_H
+#define EVTOLEVENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What happens to a vehicle when an event fires.
+enum class EventType : uint8_t { Depleted, ChargeDone, TripDone, Request, RepairDone, SlotStart };
+
+// Identifies a pending event; valid until the event is popped or cancelled.
+using EventHandle = uint32_t;
+
+constexpr EventHandle kNoEvent = 0xffffffffu;
+
+/**
+ * Struct Event : A vehicle event scheduled at a simulated time.
+ */
+struct Event {
+    double time;  // hours
+    uint64_t sequence;  // Insertion order, breaks ties deterministically
+    int vehicle;  // -1 for events not tied to a vehicle (Request)
+    EventType type;
+    EventHandle handle;
+};
+
+/**
+ * Class EventQueue : Binary min-heap of events with a handle-to-position index.
+ */
+class EventQueue {
+public:
+    EventHandle push(double time, int vehicle, EventType type);
+
+    // Removes and returns the earliest event.
+    Event pop();
+
+    const Event &top() const { return heap.front(); }
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+
+    /**
+     * Removes a pending event.
+     * returns True if the event was pending, false otherwise.
+     */
+    bool cancel(EventHandle handle);
+
+    /**
+     * Moves a pending event to a new time, keeping its handle.
+     * returns True if the event was pending, false otherwise.
+     */
+    bool reschedule(EventHandle handle, double time);
+
+    bool pending(EventHandle handle) const;
+
+    // Drops every event, keeping the allocated capacity.
+    void clear();
+
+    void reserve(size_t events);
+
+private:
+    static bool earlier(const Event &a, const Event &b) {
+        return a.time != b.time ? a.time < b.time : a.sequence < b.sequence;
+    }
+
+    void place(size_t index, const Event &event);
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void removeAt(size_t index);
+
+    std::vector<Event> heap;
+    std::vector<uint32_t> position;  // Heap index per handle, kNoEvent when not pending
+    std::vector<EventHandle> free_handles;
+    uint64_t next_sequence = 0;
+};
+
+#endif // EVTOLEVENTS_H
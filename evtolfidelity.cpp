@@ -0,0 +1,253 @@
+/**
+ * File: evtolfidelity.cpp
+ * Fluid bound, cohort simulation and the screening pipeline.
+ */
+
+#include "evtolfidelity.h"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+namespace {
+
+const double kTimeEpsilon = 1e-9;
+const double kUnbounded = std::numeric_limits<double>::infinity();
+
+// Vehicles per spec: the fixed mix, or the random draw's expected share.
+std::vector<double> expectedMix(const Scenario &scenario) {
+    size_t specs = scenario.specs.size();
+    std::vector<double> counts(specs, static_cast<double>(scenario.vehicle_count) / specs);
+    if (!scenario.fleet_mix.empty()) {
+        counts.assign(specs, 0.0);
+        for (size_t s = 0; s < scenario.fleet_mix.size(); s++) counts[s] = scenario.fleet_mix[s];
+    }
+    return counts;
+}
+
+// Hours a spec flies depleting (range) and recharging; 0 range never flies.
+double rangeHours(const EVTOL_Spec &spec) {
+    double miles_per_hour = spec.energy_use * spec.cruise_speed;
+    return miles_per_hour > 0 ? spec.battery_capacity / miles_per_hour : 0.0;
+}
+
+/**
+ * Struct Cohort : Vehicles of one spec that fly and charge together.
+ */
+struct Cohort {
+    int spec;
+    int count;
+};
+
+/**
+ * Struct CohortEvent : A cohort depleting or finishing its charge.
+ */
+struct CohortEvent {
+    double time;
+    int spec;  // Ties go to the lower spec, as the engine's vehicle order does
+    int cohort;
+    bool charged;
+
+    bool operator>(const CohortEvent &other) const {
+        if (time != other.time) return time > other.time;
+        if (charged != other.charged) return !charged; // Chargers are freed before they are asked for
+        return spec > other.spec;
+    }
+};
+
+} // namespace
+
+bool fidelityCovers(const Scenario &scenario) {
+    // Every charge runs from empty to full, which takes charge_time whatever the taper
+    return !scenario.specs.empty() && !scenario.missions.enabled && !scenario.demand.enabled &&
+           !scenario.maintenance.enabled && !scenario.reservations && !scenario.preemption &&
+           !scenario.charge_to_need && scenario.charger_classes.empty() && std::max(scenario.shifts.count, 1) == 1 &&
+           !(scenario.energy.enabled && scenario.energy.site_power_kw > 0);
+}
+
+bool analyticPassengerMiles(const Scenario &scenario, double &bound) {
+    if (!fidelityCovers(scenario)) return false;
+    const double horizon = std::max(scenario.horizon_hours, 0.0);
+    std::vector<double> counts = expectedMix(scenario);
+    size_t specs = scenario.specs.size();
+
+    // Per spec: miles flown before anything charges, miles every later leg could add with a
+    // charger always free, and miles per charging hour
+    std::vector<double> extra(specs, 0.0), per_charge_hour(specs, 0.0);
+    double first_depletion = kUnbounded;
+    bound = 0;
+    for (size_t s = 0; s < specs; s++) {
+        const EVTOL_Spec &spec = scenario.specs[s];
+        double range = rangeHours(spec);
+        double miles_per_hour = spec.passenger_count * spec.cruise_speed;
+        if (range <= 0 || counts[s] <= 0) continue;
+        bound += counts[s] * miles_per_hour * std::min(range, horizon);
+        first_depletion = std::min(first_depletion, range);
+
+        double hours = 0;
+        for (double t = range + spec.charge_time; t < horizon; t += spec.charge_time) {
+            double leg = std::min(range, horizon - t);
+            hours += leg;
+            t += leg;
+        }
+        extra[s] = counts[s] * miles_per_hour * hours;
+        per_charge_hour[s] = spec.charge_time > 0 ? miles_per_hour * range / spec.charge_time : kUnbounded;
+    }
+
+    // The charger hours left after the first depletion, spent on the best specs first
+    double charger_hours = std::max(scenario.chargers, 0) * std::max(horizon - first_depletion, 0.0);
+    std::vector<size_t> order(specs);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return per_charge_hour[a] > per_charge_hour[b]; });
+    for (size_t s : order) {
+        if (extra[s] <= 0) continue;
+        if (per_charge_hour[s] == kUnbounded) {
+            bound += extra[s];
+            continue;
+        }
+        double hours = std::min(extra[s] / per_charge_hour[s], charger_hours);
+        bound += hours * per_charge_hour[s];
+        charger_hours -= hours;
+    }
+    return true;
+}
+
+bool cohortPassengerMiles(const Scenario &scenario, double &miles) {
+    if (!fidelityCovers(scenario)) return false;
+    const double horizon = scenario.horizon_hours;
+    size_t specs = scenario.specs.size();
+
+    // Whole vehicles per spec; a random fleet gets its expected mix, remainders to the first specs
+    std::vector<Cohort> cohorts;
+    for (size_t s = 0; s < specs; s++) {
+        int count = static_cast<int>(scenario.vehicle_count / static_cast<int>(specs)) +
+                    (static_cast<int>(s) < scenario.vehicle_count % static_cast<int>(specs) ? 1 : 0);
+        if (!scenario.fleet_mix.empty()) count = s < scenario.fleet_mix.size() ? scenario.fleet_mix[s] : 0;
+        if (count > 0) cohorts.push_back({static_cast<int>(s), count});
+    }
+
+    std::priority_queue<CohortEvent, std::vector<CohortEvent>, std::greater<CohortEvent>> events;
+    std::deque<int> waiting;  // FCFS by depletion
+    double waiting_since = -1;  // Depletion time of the last cohort in line
+    int free_chargers = std::max(scenario.chargers, 0);
+    miles = 0;
+
+    auto fly = [&](int c, double now) {
+        const EVTOL_Spec &spec = scenario.specs[cohorts[c].spec];
+        double range = rangeHours(spec);
+        double leg = std::min(range, horizon - now);
+        if (leg <= 0) return;
+        miles += cohorts[c].count * spec.passenger_count * spec.cruise_speed * leg;
+        if (now + leg < horizon - kTimeEpsilon) events.push({now + leg, cohorts[c].spec, c, false});
+    };
+    auto serve = [&](double now) {
+        while (free_chargers > 0 && !waiting.empty()) {
+            int c = waiting.front();
+            if (cohorts[c].count > free_chargers) {
+                // Only part of the cohort gets a charger; the rest keeps its place in line
+                cohorts[c].count -= free_chargers;
+                cohorts.push_back({cohorts[c].spec, free_chargers});
+                c = static_cast<int>(cohorts.size()) - 1;
+            } else {
+                waiting.pop_front();
+            }
+            free_chargers -= cohorts[c].count;
+            double done = now + scenario.specs[cohorts[c].spec].charge_time;
+            if (done < horizon) events.push({done, cohorts[c].spec, c, true});
+        }
+    };
+
+    for (size_t c = 0; c < cohorts.size(); c++) fly(static_cast<int>(c), 0.0);
+    while (!events.empty()) {
+        CohortEvent event = events.top();
+        events.pop();
+        if (event.charged) {
+            free_chargers += cohorts[event.cohort].count;
+            fly(event.cohort, event.time);
+        } else if (!waiting.empty() && cohorts[waiting.back()].spec == event.spec && waiting_since == event.time) {
+            // Same spec, same instant: one cohort from here on
+            cohorts[waiting.back()].count += cohorts[event.cohort].count;
+            cohorts[event.cohort].count = 0;
+        } else {
+            waiting.push_back(event.cohort);
+            waiting_since = event.time;
+        }
+        // Serve once every event of this instant is in, so same-time arrivals queue in spec order
+        if (events.empty() || events.top().time != event.time) serve(event.time);
+    }
+    return true;
+}
+
+PipelineReport evaluateCandidates(ReplicaPool &pool, const std::vector<Scenario> &candidates,
+                                  const FidelityBudget &budget) {
+    PipelineReport report;
+    report.candidates.resize(candidates.size());
+    std::vector<size_t> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    // Analytic bounds for everyone; candidates without one must be simulated to be ranked
+    for (size_t i = 0; i < candidates.size(); i++) {
+        CandidateEvaluation &evaluation = report.candidates[i];
+        evaluation.bound = kUnbounded;
+        if (analyticPassengerMiles(candidates[i], evaluation.bound)) {
+            evaluation.fidelity = Fidelity::Analytic;
+            evaluation.passenger_miles = evaluation.bound;
+            report.analytic++;
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return report.candidates[a].bound > report.candidates[b].bound;
+    });
+
+    // Cohort runs down the bounds, until no remaining bound can reach the best cohort answer
+    double best = 0;
+    bool exhausted = false;  // Cohort budget ran out before the bounds did
+    for (size_t i : order) {
+        CandidateEvaluation &evaluation = report.candidates[i];
+        if (evaluation.fidelity == Fidelity::None) continue;
+        if (evaluation.bound < (1 - budget.tolerance) * best) break;
+        if (report.cohort >= budget.cohort_runs) {
+            exhausted = true;
+            break;
+        }
+        cohortPassengerMiles(candidates[i], evaluation.passenger_miles);
+        evaluation.fidelity = Fidelity::Cohort;
+        report.cohort++;
+        best = std::max(best, evaluation.passenger_miles);
+    }
+
+    // Full simulation down the cohort answers (unscreened candidates first), against the best mean;
+    // candidates the cohort budget did not reach compete on their bounds
+    std::vector<size_t> contenders;
+    for (size_t i : order) {
+        const CandidateEvaluation &evaluation = report.candidates[i];
+        bool unreached = exhausted && evaluation.fidelity == Fidelity::Analytic &&
+                         evaluation.bound >= (1 - budget.tolerance) * best;
+        if (evaluation.fidelity == Fidelity::Cohort || evaluation.fidelity == Fidelity::None || unreached) {
+            contenders.push_back(i);
+        }
+    }
+    auto estimate = [&](size_t i) {
+        const CandidateEvaluation &evaluation = report.candidates[i];
+        return evaluation.fidelity == Fidelity::None ? kUnbounded : evaluation.passenger_miles;
+    };
+    std::stable_sort(contenders.begin(), contenders.end(), [&](size_t a, size_t b) { return estimate(a) > estimate(b); });
+
+    best = 0;
+    for (size_t i : contenders) {
+        if (estimate(i) < (1 - budget.tolerance) * best || report.simulated >= budget.simulations) break;
+        CandidateEvaluation &evaluation = report.candidates[i];
+        evaluation.stats = pool.run(candidates[i], budget.replicas);
+        evaluation.passenger_miles = evaluation.stats.fleet.passenger_miles.mean();
+        evaluation.fidelity = Fidelity::Simulation;
+        report.simulated++;
+        if (report.best < 0 || evaluation.passenger_miles > best) {
+            best = evaluation.passenger_miles;
+            report.best = static_cast<int>(i);
+        }
+    }
+    return report;
+}
@@ -0,0 +1,96 @@
+/**
+ * File: evtolfidelity.h
+ * Multi-fidelity screening of candidate scenarios.
+ *
+ * Optimization loops compare many fleets, most of them clearly worse than
+ * the best, and a full replica simulation of each wastes most of the work.
+ * The pipeline ranks candidates by fleet passenger miles through three
+ * models of rising cost:
+ *
+ *   analytic    A fluid bound: every vehicle's first leg, plus the charger
+ *               hours left after the first depletion spent on the specs with
+ *               the most passenger miles per charging hour, each capped at
+ *               what it would fly with unlimited chargers. Constant time.
+ *   cohort      A deterministic event simulation of groups of same-spec
+ *               vehicles that deplete and charge together; a group only
+ *               splits when fewer chargers are free than it has vehicles.
+ *               No fault draws, no replicas.
+ *   simulation  The full per-vehicle engine over the budgeted replicas.
+ *
+ * Candidates are promoted in order of their current estimate and dropped once
+ * it falls more than the tolerance below the best answer of the next
+ * fidelity, so the budgets are spent on the contenders. Every candidate
+ * reports the highest fidelity that evaluated it.
+ *
+ * The cheap models cover the default policy only: flying until empty with
+ * first-come first-served chargers of one class and one shift. Random fleets
+ * are modelled by their expected mix. Other scenarios skip straight to
+ * simulation.
+ */
+
+#ifndef EVTOLFIDELITY_H
+#define EVTOLFIDELITY_H
+
+#include "evtolbatch.h"
+
+#include <cstddef>
+#include <vector>
+
+// Models a candidate can be evaluated with, cheapest first.
+enum class Fidelity { None, Analytic, Cohort, Simulation };
+
+/**
+ * Struct FidelityBudget : How much work the pipeline may spend.
+ */
+struct FidelityBudget {
+    size_t cohort_runs = 1000;  // Candidates given a cohort simulation
+    size_t simulations = 10;  // Candidates given a full simulation
+    int replicas = 10;  // Per full simulation
+    double tolerance = 0.05;  // Slack below the best answer so far, as a fraction of it
+};
+
+/**
+ * Struct CandidateEvaluation : What the pipeline learned about one candidate.
+ */
+struct CandidateEvaluation {
+    Fidelity fidelity = Fidelity::None;  // Highest fidelity that evaluated the candidate
+    double passenger_miles = 0;  // That fidelity's answer: bound, cohort total or replica mean
+    double bound = 0;  // Analytic upper bound; infinite where not covered
+    ScenarioStats stats;  // Full simulation only
+};
+
+/**
+ * Struct PipelineReport : Per-candidate results and the work spent.
+ */
+struct PipelineReport {
+    std::vector<CandidateEvaluation> candidates;  // In candidate order
+    size_t analytic = 0;
+    size_t cohort = 0;
+    size_t simulated = 0;
+    int best = -1;  // Simulated candidate with the most passenger miles
+};
+
+// Whether the analytic and cohort models cover a scenario.
+bool fidelityCovers(const Scenario &scenario);
+
+/**
+ * Fluid upper bound on a scenario's fleet passenger miles.
+ * returns True, or false if the scenario is not covered.
+ */
+bool analyticPassengerMiles(const Scenario &scenario, double &bound);
+
+/**
+ * Fleet passenger miles of a cohort simulation of the scenario.
+ * returns True, or false if the scenario is not covered.
+ */
+bool cohortPassengerMiles(const Scenario &scenario, double &miles);
+
+/**
+ * Screens the candidates and fully simulates the contenders within the budget.
+ * Candidates left unscreened when cohort_runs runs out compete for a full
+ * simulation on their analytic bounds.
+ */
+PipelineReport evaluateCandidates(ReplicaPool &pool, const std::vector<Scenario> &candidates,
+                                  const FidelityBudget &budget = FidelityBudget());
+
+#endif // EVTOLFIDELITY_H
@@ -0,0 +1,46 @@
+/**
+ * File: evtolmission.cpp
+ * Trip-length distributions for mission mode.
+ */
+
+#include "evtolmission.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TripSampler::reset(const MissionProfile &mission) {
+    profile = mission;
+    buffer.clear();
+    cursor = 0;
+}
+
+void TripSampler::refill(std::mt19937 &gen) {
+    buffer.resize(batch_size);
+    cursor = 0;
+    double mean = std::max(profile.mean_miles, 0.0);
+
+    switch (profile.distribution) {
+    case TripDistribution::Fixed:
+        std::fill(buffer.begin(), buffer.end(), mean);
+        break;
+    case TripDistribution::Uniform: {
+        double half = mean * std::min(std::max(profile.spread, 0.0), 1.0);
+        std::uniform_real_distribution<double> dist(mean - half, mean + half);
+        for (double &miles : buffer) miles = dist(gen);
+        break;
+    }
+    case TripDistribution::Exponential: {
+        std::exponential_distribution<double> dist(mean > 0 ? 1.0 / mean : 1.0);
+        for (double &miles : buffer) miles = mean > 0 ? dist(gen) : 0.0;
+        break;
+    }
+    case TripDistribution::Lognormal: {
+        // Pick mu so that the distribution's mean is mean_miles
+        double sigma = std::max(profile.spread, 0.0);
+        double mu = std::log(std::max(mean, 1e-9)) - 0.5 * sigma * sigma;
+        std::lognormal_distribution<double> dist(mu, sigma);
+        for (double &miles : buffer) miles = dist(gen);
+        break;
+    }
+    }
+}
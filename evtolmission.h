@@ -0,0 +1,42 @@
+/**
+ * File: evtolmission.h
+ * Batched trip-length sampling for mission mode.
+ *
+ * Trip lengths are drawn a block at a time into a buffer, so the engine's
+ * per-trip cost is a buffer read rather than a distribution call.
+ */
+
+#ifndef EVTOLMISSION_H
+#define EVTOLMISSION_H
+
+#include "evtolsimulation.h"
+
+#include <random>
+#include <vector>
+
+/**
+ * Class TripSampler : Buffered trip lengths (miles) drawn from a MissionProfile.
+ */
+class TripSampler {
+public:
+    explicit TripSampler(size_t batch_size = 1024) : batch_size(batch_size) {}
+
+    // Sets the distribution and drops any buffered samples.
+    void reset(const MissionProfile &profile);
+
+    // Returns the next trip length in miles.
+    double next(std::mt19937 &gen) {
+        if (cursor == buffer.size()) refill(gen);
+        return buffer[cursor++];
+    }
+
+private:
+    void refill(std::mt19937 &gen);
+
+    MissionProfile profile;
+    size_t batch_size;
+    std::vector<double> buffer;
+    size_t cursor = 0;
+};
+
+#endif // EVTOLMISSION_H
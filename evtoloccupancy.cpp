@@ -0,0 +1,118 @@
+/**
+ * File: evtoloccupancy.cpp
+ * Word-parallel bitmap updates and popcount queries behind OccupancyTimeline.
+ */
+
+#include "evtoloccupancy.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const size_t kWordBits = 64;
+
+// Bits [from, to) of a word, for 0 <= from < to <= 64.
+uint64_t bitRange(size_t from, size_t to) {
+    uint64_t upper = to == kWordBits ? ~0ULL : (1ULL << to) - 1;
+    return upper & ~((1ULL << from) - 1);
+}
+
+} // namespace
+
+const size_t OccupancyTimeline::kMaxWords;
+
+bool OccupancyTimeline::reset(size_t chargers, double horizon, double slot_hours) {
+    bool fit = fits(chargers);
+    rows = fit ? chargers : 0;
+    slot = slot_hours > 0 ? slot_hours : 1.0;
+    double needed = horizon > 0 ? std::ceil(horizon / slot - 1e-9) : 0;
+    if (rows > 0) {
+        // Widen the slot by a whole factor so every row fits in its share of the words
+        double most = static_cast<double>(kMaxWords / rows * kWordBits);
+        if (needed > most) {
+            slot *= std::ceil(needed / most);
+            needed = std::ceil(horizon / slot - 1e-9);
+        }
+    }
+    slots_per_hour = 1.0 / slot;
+    slot_count = static_cast<size_t>(needed);
+    words = (slot_count + kWordBits - 1) / kWordBits;
+    bits.assign(rows * words, 0);
+    return fit;
+}
+
+size_t OccupancyTimeline::slotOf(double t) const {
+    // Slot i is covered when its midpoint (i + 0.5) * slot is, so round to the nearest boundary
+    double position = std::floor(t * slots_per_hour + 0.5);
+    if (position <= 0) return 0;
+    return std::min(static_cast<size_t>(position), slot_count);
+}
+
+void OccupancyTimeline::setRange(size_t charger, double start, double end, bool busy) {
+    size_t from = slotOf(start);
+    size_t to = slotOf(end);
+    if (from >= to) return;
+
+    uint64_t *row = bits.data() + charger * words;
+    size_t first = from / kWordBits, last = (to - 1) / kWordBits;
+    for (size_t w = first; w <= last; w++) {
+        size_t lo = w == first ? from % kWordBits : 0;
+        size_t hi = w == last ? (to - 1) % kWordBits + 1 : kWordBits;
+        uint64_t mask = bitRange(lo, hi);
+        row[w] = busy ? row[w] | mask : row[w] & ~mask;
+    }
+}
+
+void OccupancyTimeline::mark(size_t charger, double start, double end) {
+    setRange(charger, start, end, true);
+}
+
+void OccupancyTimeline::clear(size_t charger, double start, double end) {
+    setRange(charger, start, end, false);
+}
+
+uint64_t OccupancyTimeline::busySlots(size_t charger) const {
+    const uint64_t *row = bits.data() + charger * words;
+    uint64_t count = 0;
+    for (size_t w = 0; w < words; w++) count += __builtin_popcountll(row[w]);
+    return count;
+}
+
+uint64_t OccupancyTimeline::allBusySlots(size_t first, size_t last) const {
+    if (first >= last) return 0;
+    uint64_t count = 0;
+    for (size_t w = 0; w < words; w++) {
+        uint64_t all = ~0ULL;
+        for (size_t c = first; c < last; c++) all &= bits[c * words + w];
+        count += __builtin_popcountll(all);
+    }
+    return count;
+}
+
+size_t OccupancyTimeline::findNext(const uint64_t *row, size_t from, bool busy) const {
+    // First slot at or after from in the given state, skipping whole words that have none
+    if (from >= slot_count) return slot_count;
+    size_t w = from / kWordBits;
+    uint64_t word = (busy ? row[w] : ~row[w]) & ~((1ULL << (from % kWordBits)) - 1);
+    while (word == 0) {
+        if (++w >= words) return slot_count;
+        word = busy ? row[w] : ~row[w];
+    }
+    return std::min(w * kWordBits + static_cast<size_t>(__builtin_ctzll(word)), slot_count);
+}
+
+IdleGaps OccupancyTimeline::idleGaps(size_t charger) const {
+    const uint64_t *row = bits.data() + charger * words;
+    IdleGaps gaps;
+    size_t i = findNext(row, 0, false);
+    while (i < slot_count) {
+        size_t end = findNext(row, i, true);
+        double hours = (end - i) * slot;
+        gaps.count++;
+        gaps.total_hours += hours;
+        gaps.longest_hours = std::max(gaps.longest_hours, hours);
+        i = findNext(row, end, false);
+    }
+    return gaps;
+}
@@ -0,0 +1,81 @@
+/**
+ * File: evtoloccupancy.h
+ * Charger occupancy timelines as fixed-resolution bitmaps.
+ *
+ * Each charger gets one row of bits, one bit per slot of slot_hours; a slot
+ * is busy when a charging session covers its midpoint. Marking a session
+ * sets a run of bits a word at a time, utilization is a popcount over the
+ * row, the time every charger of a group was busy is a popcount over the
+ * rows ANDed word by word, and idle gaps are found by skipping whole busy
+ * or idle words. Popcounts are __builtin_popcountll, a single popcnt
+ * instruction where the target has one.
+ *
+ * A timeline holds at most kMaxWords words: when the chargers and horizon
+ * need more, the slot is widened by a whole factor until they fit.
+ */
+
+#ifndef EVTOLOCCUPANCY_H
+#define EVTOLOCCUPANCY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Struct IdleGaps : Maximal idle stretches of one charger.
+ */
+struct IdleGaps {
+    uint64_t count = 0;
+    double total_hours = 0;
+    double longest_hours = 0;
+};
+
+/**
+ * Class OccupancyTimeline : Busy slots of a set of chargers over one window.
+ */
+class OccupancyTimeline {
+public:
+    static const size_t kMaxWords = size_t(1) << 22;  // 32 MiB
+
+    // Whether that many chargers fit in kMaxWords at one word per row.
+    static bool fits(size_t chargers) { return chargers <= kMaxWords; }
+
+    /**
+     * Covers [0, horizon) for the given chargers at slot_hours per bit, or a
+     * multiple of it if needed to stay within kMaxWords; clears every row.
+     * Returns false, leaving no chargers, when the chargers do not fit.
+     */
+    bool reset(size_t chargers, double horizon, double slot_hours);
+
+    // Marks [start, end) busy on a charger.
+    void mark(size_t charger, double start, double end);
+
+    // Marks [start, end) idle again, e.g. the unused part of a cut-short session.
+    void clear(size_t charger, double start, double end);
+
+    size_t chargers() const { return rows; }
+    size_t slots() const { return slot_count; }
+    double slotHours() const { return slot; }
+
+    // Busy slots of one charger.
+    uint64_t busySlots(size_t charger) const;
+
+    // Slots in which every charger of [first, last) was busy.
+    uint64_t allBusySlots(size_t first, size_t last) const;
+
+    IdleGaps idleGaps(size_t charger) const;
+
+private:
+    void setRange(size_t charger, double start, double end, bool busy);
+    size_t slotOf(double t) const;
+    size_t findNext(const uint64_t *row, size_t from, bool busy) const;
+
+    size_t rows = 0;
+    size_t slot_count = 0;
+    size_t words = 0;  // Per row
+    double slot = 1;
+    double slots_per_hour = 1;
+    std::vector<uint64_t> bits;  // Row by row, bit i of a row is slot i
+};
+
+#endif // EVTOLOCCUPANCY_H
@@ -0,0 +1,511 @@
+/**
+ * File: evtoloptimal.cpp
+ * Parallel branch and bound behind solveChargingSchedule.
+ */
+
+#include "evtoloptimal.h"
+#include "evtolcharge.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+const double kNever = std::numeric_limits<double>::infinity();
+
+// Charges closer to the horizon than this gain nothing
+const double kTimeEpsilon = 1e-9;
+
+// Bisection steps when solving for a charge that lasts until the horizon
+const int kTargetIterations = 48;
+
+// Search nodes a thread counts before publishing them
+const uint64_t kNodeBatch = 1024;
+
+// Frontier states per thread before the parallel search starts
+const size_t kStatesPerThread = 16;
+
+// State key words each thread remembers for duplicate detection (32 MiB)
+const size_t kSeenWords = size_t(1) << 22;
+
+// Steps per horizon of the tabulated future gain of a vehicle
+const int kGainSteps = 1024;
+
+// Up to this many specs get a charger value table per subset of specs
+const size_t kMaskedSpecs = 6;
+
+// Times in state keys are rounded to this many steps per hour
+const double kKeyResolution = 1e9;
+
+void storeMax(std::atomic<double> &target, double value) {
+    double current = target.load();
+    while (value > current && !target.compare_exchange_weak(current, value)) {
+    }
+}
+
+/**
+ * Struct SpecModel : What one manufacturer gets out of a charge.
+ */
+struct SpecModel {
+    ChargeCurve curve;
+    double range_time;  // Flight hours on a full battery
+    double weight;  // Passenger miles per flight hour
+    double best_rate;  // Passenger miles per charging hour, at peak power
+    double full_rate;  // Passenger miles per charging hour of a full charge
+    std::vector<double> future;  // futureGain at each step of the horizon
+};
+
+/**
+ * Struct SearchState : Vehicles' next depletion and chargers' next free time.
+ */
+struct SearchState {
+    std::vector<double> ready;  // kNever once a vehicle can no longer use a charge
+    std::vector<double> free;  // kNever once a charger is closed
+    double gain = 0;
+    std::vector<ChargeAssignment> path;
+};
+
+/**
+ * Struct Choice : Next use of the earliest free charger; vehicle -1 closes it.
+ */
+struct Choice {
+    int vehicle;
+    double start;
+    double end;
+    double gain;
+    double next_ready;
+};
+
+/**
+ * Struct SeenState : Canonical key of a reached state and the best gain it was reached with.
+ */
+struct SeenState {
+    std::vector<int64_t> key;
+    double gain;
+};
+
+/**
+ * Struct Worker : Scratch space and duplicate detection of one search thread.
+ */
+struct Worker {
+    std::vector<std::vector<Choice>> stack;  // Choices per depth
+    std::unordered_map<uint64_t, SeenState> seen;  // By hash of the key
+    size_t seen_words = 0;  // Key words stored in seen
+    std::vector<std::pair<int, int64_t>> waiting;  // stateKey scratch
+    std::vector<int64_t> key;  // stateKey scratch
+    uint64_t nodes = 0;  // Not yet added to the shared count
+};
+
+/**
+ * Class Search : Shared incumbent and per-thread depth-first search.
+ */
+class Search {
+public:
+    Search(const Scenario &scenario, const std::vector<int> &fleet, const ScheduleOptions &options);
+
+    OptimalSchedule run(int threads);
+
+private:
+    void charge(int spec, double start, double &end, double &flight) const;
+    double futureGain(int spec, double ready) const;
+    double futureBound(int spec, double ready) const;
+    void buildChargerValues();
+    double chargerBound(unsigned mask, double from) const;
+    double bound(const SearchState &state) const;
+    int nextCharger(const SearchState &state) const;
+    void choices(const SearchState &state, int charger, std::vector<Choice> &out) const;
+    void apply(SearchState &state, int charger, const Choice &choice) const;
+    uint64_t stateKey(const SearchState &state, Worker &worker) const;
+    void dfs(SearchState &state, size_t depth, Worker &worker);
+    void offer(const SearchState &state);
+
+    const std::vector<int> &fleet;
+    const ScheduleOptions &options;
+    double horizon;
+    size_t chargers;
+    std::vector<SpecModel> specs;
+    std::vector<std::vector<double>> charger_value;  // Per subset of specs, per step: see buildChargerValues
+
+    std::atomic<double> best{0.0};
+    std::atomic<double> open_bound{0.0};  // Highest bound among nodes cut off by the node limit
+    std::atomic<uint64_t> node_count{0};
+    std::atomic<bool> exhausted{false};
+    std::mutex best_mutex;
+    OptimalSchedule result;
+};
+
+Search::Search(const Scenario &scenario, const std::vector<int> &fleet, const ScheduleOptions &options)
+    : fleet(fleet), options(options), horizon(scenario.horizon_hours),
+      chargers(static_cast<size_t>(std::max(scenario.chargers, 0))) {
+    for (const EVTOL_Spec &spec : scenario.specs) {
+        SpecModel model;
+        model.curve = ChargeCurve(spec);
+        model.range_time = spec.battery_capacity / (spec.energy_use * spec.cruise_speed);
+        model.weight = spec.passenger_count * spec.cruise_speed;
+        double cv = spec.cv_soc > 0 ? std::min(spec.cv_soc, 1.0) : 1.0;
+        double cv_time = model.curve.timeToCharge(0.0, cv);
+        model.best_rate = cv_time > 0 ? model.weight * model.range_time * cv / cv_time : kNever;
+        double full = model.curve.fullChargeTime();
+        model.full_rate = full > 0 ? model.weight * model.range_time / full : kNever;
+        specs.push_back(model);
+    }
+    for (size_t s = 0; s < specs.size(); s++) {
+        specs[s].future.resize(kGainSteps + 1);
+        for (int i = 0; i <= kGainSteps; i++) {
+            specs[s].future[i] = futureGain(static_cast<int>(s), horizon * i / kGainSteps);
+        }
+    }
+    buildChargerValues();
+}
+
+void Search::buildChargerValues() {
+    // Most passenger miles one charger can produce from each step on, with as
+    // many ready vehicles of the subset's specs as it can use. Backwards over
+    // the steps, each charge is followed by the value at the step its end falls
+    // in, which is at least the value at the end itself. A charge ending in its
+    // own step is followed by the charger-hours bound instead.
+    size_t subsets = specs.size() <= kMaskedSpecs ? (size_t(1) << specs.size()) : 1;
+    charger_value.assign(subsets, std::vector<double>(kGainSteps + 1, 0.0));
+    double step_hours = horizon / kGainSteps;
+    for (size_t mask = 1; mask < subsets || mask == 1; mask++) {
+        size_t table = subsets == 1 ? 0 : mask;
+        std::vector<double> &value = charger_value[table];
+        double rate = 0;
+        for (size_t s = 0; s < specs.size(); s++) {
+            if (subsets == 1 || (mask >> s & 1)) rate = std::max(rate, specs[s].best_rate);
+        }
+        for (int i = kGainSteps - 1; i >= 0; i--) {
+            double from = step_hours * i;
+            double best_here = 0;
+            for (size_t s = 0; s < specs.size(); s++) {
+                if (subsets != 1 && !(mask >> s & 1)) continue;
+                double end, flight;
+                charge(static_cast<int>(s), from, end, flight);
+                if (end >= horizon - kTimeEpsilon) continue;
+                int j = static_cast<int>(end / step_hours);
+                double after = j > i ? value[std::min(j, kGainSteps)] : rate * (horizon - from);
+                best_here = std::max(best_here, specs[s].weight * flight + after);
+            }
+            value[i] = std::min(best_here, rate * (horizon - from));
+        }
+        if (subsets == 1) break;
+    }
+}
+
+double Search::chargerBound(unsigned mask, double from) const {
+    if (from >= horizon) return 0.0;
+    const std::vector<double> &value = charger_value[charger_value.size() == 1 ? 0 : mask];
+    int step = static_cast<int>(from / horizon * kGainSteps);
+    return value[std::min(std::max(step, 0), kGainSteps)];
+}
+
+void Search::charge(int spec, double start, double &end, double &flight) const {
+    // A full charge, unless charging only to the horizon's need ends sooner
+    const SpecModel &model = specs[spec];
+    double full = model.curve.fullChargeTime();
+    if (start + full + model.range_time <= horizon) {
+        end = start + full;
+        flight = model.range_time;
+        return;
+    }
+    auto surplus = [&](double t) {
+        return model.curve.socAfter(0.0, t) * model.range_time - (horizon - start - t);
+    };
+    double lo = 0, hi = full;
+    for (int i = 0; i < kTargetIterations; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (surplus(mid) < 0) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    end = start + hi;
+    flight = std::max(horizon - end, 0.0);
+}
+
+double Search::futureGain(int spec, double ready) const {
+    // Charging the moment the vehicle depletes, every time
+    double gain = 0, end, flight;
+    while (ready < horizon - kTimeEpsilon) {
+        charge(spec, ready, end, flight);
+        if (end >= horizon - kTimeEpsilon) break;
+        gain += specs[spec].weight * flight;
+        ready = end + specs[spec].range_time;
+    }
+    return gain;
+}
+
+double Search::futureBound(int spec, double ready) const {
+    // The gain only falls as the vehicle waits longer, so the earlier step bounds it
+    int step = static_cast<int>(ready / horizon * kGainSteps);
+    return specs[spec].future[std::min(std::max(step, 0), kGainSteps)];
+}
+
+double Search::bound(const SearchState &state) const {
+    // Each vehicle adds at most its gain with unlimited chargers. All its
+    // charges but the last are full, at the spec's full-charge rate of passenger
+    // miles per charging hour; the last may stop early, at up to the peak rate.
+    // Relaxing the charger hours left with a multiplier lambda, any lambda bounds
+    // the best split of those hours, so take the least over the rates.
+    std::vector<double> gain(specs.size(), 0.0), last(specs.size(), 0.0);
+    double first_ready = kNever;
+    unsigned mask = 0;
+    for (size_t v = 0; v < fleet.size(); v++) {
+        if (state.ready[v] == kNever) continue;
+        const SpecModel &model = specs[fleet[v]];
+        double future = futureBound(fleet[v], state.ready[v]);
+        gain[fleet[v]] += future;
+        last[fleet[v]] += std::min(future, model.weight * model.range_time);
+        first_ready = std::min(first_ready, state.ready[v]);
+        mask |= 1u << (fleet[v] & 31);
+    }
+    double capacity = 0, chargers_alone = 0;
+    for (double free : state.free) {
+        capacity += std::max(horizon - std::max(free, first_ready), 0.0);
+        chargers_alone += chargerBound(mask, std::max(free, first_ready));
+    }
+
+    double relaxed = kNever;
+    auto relax = [&](double lambda) {
+        double total = lambda * capacity;
+        for (size_t s = 0; s < specs.size(); s++) {
+            total += std::max(1.0 - lambda / specs[s].best_rate, 0.0) * last[s];
+            total += std::max(1.0 - lambda / specs[s].full_rate, 0.0) * (gain[s] - last[s]);
+        }
+        relaxed = std::min(relaxed, total);
+    };
+    relax(0.0);
+    for (size_t s = 0; s < specs.size(); s++) {
+        if (gain[s] <= 0) continue;
+        relax(specs[s].best_rate);
+        relax(specs[s].full_rate);
+    }
+    // Or what the chargers could produce with vehicles always at hand
+    return state.gain + std::min(relaxed, chargers_alone);
+}
+
+int Search::nextCharger(const SearchState &state) const {
+    int charger = -1;
+    for (size_t c = 0; c < state.free.size(); c++) {
+        if (state.free[c] < horizon - kTimeEpsilon && (charger < 0 || state.free[c] < state.free[charger])) {
+            charger = static_cast<int>(c);
+        }
+    }
+    return charger;
+}
+
+void Search::choices(const SearchState &state, int charger, std::vector<Choice> &out) const {
+    out.clear();
+    double free = state.free[charger];
+    for (size_t v = 0; v < fleet.size(); v++) {
+        if (state.ready[v] == kNever) continue;
+        Choice choice;
+        choice.vehicle = static_cast<int>(v);
+        choice.start = std::max(free, state.ready[v]);
+        double flight;
+        charge(fleet[v], choice.start, choice.end, flight);
+        if (choice.end >= horizon - kTimeEpsilon) continue;
+        choice.gain = specs[fleet[v]].weight * flight;
+        choice.next_ready = choice.end + specs[fleet[v]].range_time;
+        out.push_back(choice);
+    }
+
+    // Vehicles of one spec that would start together lead to the same subtrees:
+    // the earliest free charger is the soonest any waiting vehicle can start
+    std::sort(out.begin(), out.end(), [&](const Choice &a, const Choice &b) {
+        if (a.start != b.start) return a.start < b.start;
+        if (fleet[a.vehicle] != fleet[b.vehicle]) return fleet[a.vehicle] < fleet[b.vehicle];
+        return a.vehicle < b.vehicle;
+    });
+    out.erase(std::unique(out.begin(), out.end(),
+                          [&](const Choice &a, const Choice &b) {
+                              return a.start == b.start && fleet[a.vehicle] == fleet[b.vehicle];
+                          }),
+              out.end());
+
+    // Leaving the charger idle until a vehicle depletes is pointless if another
+    // vehicle could charge in the meantime: moving that vehicle's next charge
+    // into the gap is never worse. Likewise a charger is only closed once no
+    // vehicle can use it, since giving it any vehicle's next charge is never worse.
+    double first_end = kNever;
+    for (const Choice &choice : out) first_end = std::min(first_end, choice.end);
+    out.erase(std::remove_if(out.begin(), out.end(),
+                             [&](const Choice &choice) { return choice.start >= first_end; }),
+              out.end());
+    if (out.empty()) out.push_back({-1, free, kNever, 0.0, kNever});
+}
+
+void Search::apply(SearchState &state, int charger, const Choice &choice) const {
+    state.free[charger] = choice.end;
+    if (choice.vehicle < 0) return;
+    state.ready[choice.vehicle] = choice.next_ready < horizon - kTimeEpsilon ? choice.next_ready : kNever;
+    state.gain += choice.gain;
+    state.path.push_back({choice.vehicle, charger, choice.start, choice.end});
+}
+
+void Search::offer(const SearchState &state) {
+    if (state.gain <= best.load()) return;
+    std::lock_guard<std::mutex> lock(best_mutex);
+    if (state.gain <= result.passenger_miles) return;
+    result.passenger_miles = state.gain;
+    result.charges = state.path;
+    storeMax(best, state.gain);
+}
+
+uint64_t Search::stateKey(const SearchState &state, Worker &worker) const {
+    // Chargers are interchangeable, as are vehicles of one spec; vehicles
+    // waiting for the earliest free charger are equivalent however long they waited
+    auto quantize = [](double t) {
+        return t == kNever ? std::numeric_limits<int64_t>::max() : std::llround(t * kKeyResolution);
+    };
+    std::vector<int64_t> &key = worker.key;
+    key.clear();
+    for (double free : state.free) key.push_back(quantize(free));
+    std::sort(key.begin(), key.end());
+    double first_free = *std::min_element(state.free.begin(), state.free.end());
+    std::vector<std::pair<int, int64_t>> &waiting = worker.waiting;
+    waiting.clear();
+    for (size_t v = 0; v < fleet.size(); v++) {
+        waiting.push_back({fleet[v], quantize(std::max(state.ready[v], first_free))});
+    }
+    std::sort(waiting.begin(), waiting.end());
+    for (const auto &vehicle : waiting) {
+        key.push_back(vehicle.first);
+        key.push_back(vehicle.second);
+    }
+
+    uint64_t h = 1469598103934665603ull;  // FNV-1a
+    for (int64_t value : key) {
+        h ^= static_cast<uint64_t>(value);
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+void Search::dfs(SearchState &state, size_t depth, Worker &worker) {
+    if (++worker.nodes == kNodeBatch) {
+        if (node_count.fetch_add(worker.nodes) + worker.nodes >= options.max_nodes) exhausted = true;
+        worker.nodes = 0;
+    }
+
+    int charger = nextCharger(state);
+    if (charger < 0) {
+        offer(state);
+        return;
+    }
+    // A state already reached with at least this gain has the same future. A
+    // hash shared by different states only skips the check, never the subtree.
+    uint64_t hash = stateKey(state, worker);
+    auto known = worker.seen.find(hash);
+    if (known != worker.seen.end()) {
+        if (known->second.key == worker.key) {
+            if (known->second.gain >= state.gain) return;
+            known->second.gain = state.gain;
+        }
+    } else if (worker.seen_words + worker.key.size() <= kSeenWords) {
+        worker.seen.emplace(hash, SeenState{worker.key, state.gain});
+        worker.seen_words += worker.key.size();
+    }
+
+    double limit = bound(state);
+    if (limit <= best.load() + kTimeEpsilon) return;
+    if (exhausted.load(std::memory_order_relaxed)) {
+        offer(state);
+        storeMax(open_bound, limit);
+        return;
+    }
+
+    if (worker.stack.size() <= depth) worker.stack.emplace_back();
+    choices(state, charger, worker.stack[depth]);
+    for (size_t i = 0; i < worker.stack[depth].size(); i++) {
+        const Choice choice = worker.stack[depth][i];
+        double free = state.free[charger];
+        double ready = choice.vehicle >= 0 ? state.ready[choice.vehicle] : 0.0;
+        double gain = state.gain;
+        apply(state, charger, choice);
+        dfs(state, depth + 1, worker);
+        state.free[charger] = free;
+        if (choice.vehicle >= 0) {
+            state.ready[choice.vehicle] = ready;
+            state.gain = gain;
+            state.path.pop_back();
+        }
+    }
+}
+
+OptimalSchedule Search::run(int threads) {
+    // Every vehicle takes off full at time 0
+    SearchState root;
+    root.free.assign(chargers, 0.0);
+    for (int spec : fleet) {
+        const SpecModel &model = specs[spec];
+        double first = std::min(model.range_time, horizon);
+        root.gain += model.weight * first;
+        root.ready.push_back(model.range_time < horizon - kTimeEpsilon ? model.range_time : kNever);
+    }
+    result.passenger_miles = root.gain;
+    storeMax(best, root.gain);
+
+    // Expand breadth-first until every thread has several subtrees to search
+    if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(threads, 1);
+    std::vector<SearchState> frontier(1, root);
+    std::vector<Choice> expansion;
+    uint64_t expanded = 0;
+    while (frontier.size() < kStatesPerThread * threads) {
+        std::vector<SearchState> next;
+        bool grew = false;
+        for (SearchState &state : frontier) {
+            int charger = nextCharger(state);
+            if (charger < 0) {
+                offer(state);
+                continue;
+            }
+            expanded++;
+            grew = true;
+            choices(state, charger, expansion);
+            for (const Choice &choice : expansion) {
+                next.push_back(state);
+                apply(next.back(), charger, choice);
+            }
+        }
+        frontier.swap(next);
+        if (!grew) break;
+    }
+    node_count = expanded;
+
+    // Subtrees go out in order, so the earliest-start branches run first
+    std::atomic<size_t> next_state{0};
+    auto work = [&]() {
+        Worker worker;
+        for (size_t i = next_state++; i < frontier.size(); i = next_state++) {
+            dfs(frontier[i], 0, worker);
+        }
+        node_count += worker.nodes;
+    };
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(work);
+    work();
+    for (auto &worker : workers) worker.join();
+
+    result.nodes = node_count.load();
+    result.exact = !exhausted.load();
+    result.upper_bound = std::max(result.passenger_miles, open_bound.load());
+    std::sort(result.charges.begin(), result.charges.end(),
+              [](const ChargeAssignment &a, const ChargeAssignment &b) { return a.start < b.start; });
+    return result;
+}
+
+} // namespace
+
+OptimalSchedule solveChargingSchedule(const Scenario &scenario, const std::vector<int> &fleet,
+                                      const ScheduleOptions &options) {
+    Search search(scenario, fleet, options);
+    return search.run(options.threads);
+}
@@ -0,0 +1,75 @@
+/**
+ * File: evtoloptimal.h
+ * Offline optimal charging schedule, as an upper bound for online policies.
+ *
+ * With faults not grounding vehicles, a vehicle flying until empty depletes
+ * at times fixed by its spec and its charges, so the whole day is decided by
+ * which vehicle each charger serves next. The solver searches those choices
+ * by branch and bound, charging each vehicle to full or, when that would
+ * outlast the horizon, just enough to fly until it (as charge_to_need does),
+ * and maximizes total passenger miles.
+ *
+ * A node is pruned against the best schedule found so far using the lesser of
+ * two relaxations: every vehicle charging the moment it depletes (unlimited
+ * chargers), and the chargers' hours left, priced by a Lagrangian split
+ * between the two. Only active schedules are branched on (no charge starts
+ * after another could have finished), vehicles of one spec in the same state
+ * are interchangeable, and states already reached with at least the same gain
+ * (compared by their full canonical key) are skipped. The first levels of the
+ * tree are split across threads that share the incumbent.
+ *
+ * The search is exponential in the fleet. With the default specs it proves
+ * the optimum for about ten vehicles; from about twenty on it stops at the
+ * node limit, and with 50 to 200 vehicles the default two million nodes leave
+ * the best schedule about 15% below the upper bound it returns. Check exact,
+ * or compare against upper_bound, before treating the result as optimal.
+ */
+
+#ifndef EVTOLOPTIMAL_H
+#define EVTOLOPTIMAL_H
+
+#include "evtolsimulation.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Struct ScheduleOptions : Limits of the schedule search.
+ */
+struct ScheduleOptions {
+    int threads = 0;  // 0 picks the hardware concurrency
+    uint64_t max_nodes = 2000000;  // Search nodes before the search stops with the best bound so far
+};
+
+/**
+ * Struct ChargeAssignment : One charge of the schedule.
+ */
+struct ChargeAssignment {
+    int vehicle;
+    int charger;
+    double start;  // hours
+    double end;
+};
+
+/**
+ * Struct OptimalSchedule : Best schedule found and the bound it proves.
+ */
+struct OptimalSchedule {
+    double passenger_miles = 0;  // Of the best schedule found
+    double upper_bound = 0;  // No charging schedule does better; equals passenger_miles when exact
+    bool exact = true;  // False if the node limit stopped the search
+    uint64_t nodes = 0;
+    std::vector<ChargeAssignment> charges;  // In start order
+};
+
+/**
+ * Finds the charging schedule with the most passenger miles for a fleet.
+ * fleet holds the index into scenario.specs of each vehicle (for example
+ * SimulationContext::vehicles().spec_index); chargers, horizon and specs come
+ * from the scenario. Missions, demand, charger classes and preemption are not
+ * modelled.
+ */
+OptimalSchedule solveChargingSchedule(const Scenario &scenario, const std::vector<int> &fleet,
+                                      const ScheduleOptions &options = ScheduleOptions());
+
+#endif // EVTOLOPTIMAL_H
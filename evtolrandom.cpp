@@ -0,0 +1,152 @@
+/**
+ * File: evtolrandom.cpp
+ * Scalar, AVX2 and AVX-512 xoshiro256+ kernels behind BatchRandom.
+ */
+
+#include "evtolrandom.h"
+
+#include <cstring>
+
+#ifdef EVTOL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Exponent bits of 1.0: OR-ed over a 52-bit mantissa they give a double in [1, 2)
+const uint64_t kOne = 0x3FF0000000000000ULL;
+
+uint64_t splitmix64(uint64_t &x) {
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Writes rounds * kLanes uniforms to out, lane by lane within a round, and
+ * advances the state. The vector kernels below compute exactly these
+ * per-lane operations.
+ */
+using FillFunction = void (*)(uint64_t (*state)[BatchRandom::kLanes], double *out, size_t rounds);
+
+void fillScalar(uint64_t (*s)[BatchRandom::kLanes], double *out, size_t rounds) {
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t l = 0; l < BatchRandom::kLanes; l++) {
+            uint64_t result = s[0][l] + s[3][l];
+            uint64_t t = s[1][l] << 17;
+            s[2][l] ^= s[0][l];
+            s[3][l] ^= s[1][l];
+            s[1][l] ^= s[2][l];
+            s[0][l] ^= s[3][l];
+            s[2][l] ^= t;
+            s[3][l] = (s[3][l] << 45) | (s[3][l] >> 19);
+
+            uint64_t bits = (result >> 12) | kOne;
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            out[r * BatchRandom::kLanes + l] = value - 1.0;
+        }
+    }
+}
+
+#ifdef EVTOL_X86_KERNELS
+
+__attribute__((target("avx2"))) void fillAvx2(uint64_t (*s)[BatchRandom::kLanes], double *out, size_t rounds) {
+    const __m256i one = _mm256_set1_epi64x(static_cast<long long>(kOne));
+    const __m256d unit = _mm256_set1_pd(1.0);
+
+    // The eight lanes as two halves of four
+    for (size_t half = 0; half < BatchRandom::kLanes; half += 4) {
+        __m256i s0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s[0] + half));
+        __m256i s1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s[1] + half));
+        __m256i s2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s[2] + half));
+        __m256i s3 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s[3] + half));
+        for (size_t r = 0; r < rounds; r++) {
+            __m256i result = _mm256_add_epi64(s0, s3);
+            __m256i t = _mm256_slli_epi64(s1, 17);
+            s2 = _mm256_xor_si256(s2, s0);
+            s3 = _mm256_xor_si256(s3, s1);
+            s1 = _mm256_xor_si256(s1, s2);
+            s0 = _mm256_xor_si256(s0, s3);
+            s2 = _mm256_xor_si256(s2, t);
+            s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+
+            __m256i bits = _mm256_or_si256(_mm256_srli_epi64(result, 12), one);
+            _mm256_storeu_pd(out + r * BatchRandom::kLanes + half, _mm256_sub_pd(_mm256_castsi256_pd(bits), unit));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s[0] + half), s0);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s[1] + half), s1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s[2] + half), s2);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(s[3] + half), s3);
+    }
+}
+
+__attribute__((target("avx512f"))) void fillAvx512(uint64_t (*s)[BatchRandom::kLanes], double *out,
+                                                    size_t rounds) {
+    // Shifts and rotates in their masked forms over all lanes: GCC's unmasked
+    // ones merge from an undefined register and trip -Wmaybe-uninitialized
+    const __mmask8 all = 0xFF;
+    const __m512i one = _mm512_set1_epi64(static_cast<long long>(kOne));
+    const __m512d unit = _mm512_set1_pd(1.0);
+    __m512i s0 = _mm512_loadu_si512(s[0]);
+    __m512i s1 = _mm512_loadu_si512(s[1]);
+    __m512i s2 = _mm512_loadu_si512(s[2]);
+    __m512i s3 = _mm512_loadu_si512(s[3]);
+    for (size_t r = 0; r < rounds; r++) {
+        __m512i result = _mm512_add_epi64(s0, s3);
+        __m512i t = _mm512_mask_slli_epi64(s1, all, s1, 17);
+        s2 = _mm512_xor_si512(s2, s0);
+        s3 = _mm512_xor_si512(s3, s1);
+        s1 = _mm512_xor_si512(s1, s2);
+        s0 = _mm512_xor_si512(s0, s3);
+        s2 = _mm512_xor_si512(s2, t);
+        s3 = _mm512_mask_rol_epi64(s3, all, s3, 45);
+
+        __m512i bits = _mm512_or_si512(_mm512_mask_srli_epi64(result, all, result, 12), one);
+        _mm512_storeu_pd(out + r * BatchRandom::kLanes, _mm512_sub_pd(_mm512_castsi512_pd(bits), unit));
+    }
+    _mm512_storeu_si512(s[0], s0);
+    _mm512_storeu_si512(s[1], s1);
+    _mm512_storeu_si512(s[2], s2);
+    _mm512_storeu_si512(s[3], s3);
+}
+
+#endif // EVTOL_X86_KERNELS
+
+FillFunction kernelFunction(SimdLevel kernel) {
+#ifdef EVTOL_X86_KERNELS
+    if (kernel == SimdLevel::Avx512) return fillAvx512;
+    if (kernel == SimdLevel::Avx2) return fillAvx2;
+#endif
+    (void)kernel;
+    return fillScalar;
+}
+
+} // namespace
+
+BatchRandom::BatchRandom(SimdLevel kernel) : active_kernel(resolveSimdLevel(kernel)) { seed(0); }
+
+void BatchRandom::seed(uint64_t seed) {
+    // Lane by lane, so a lane's state does not depend on the lane count of the kernel
+    for (size_t l = 0; l < kLanes; l++) {
+        for (size_t w = 0; w < 4; w++) state[w][l] = splitmix64(seed);
+    }
+    next = kBlock;
+}
+
+void BatchRandom::fill(double *out, size_t n) {
+    while (n > 0) {
+        if (next == kBlock) refill();
+        size_t count = std::min(n, kBlock - next);
+        std::memcpy(out, buffer + next, count * sizeof(double));
+        next += count;
+        out += count;
+        n -= count;
+    }
+}
+
+void BatchRandom::refill() {
+    kernelFunction(active_kernel)(state, buffer, kBlock / kLanes);
+    next = 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * File: evtolrandom.h
+ * Batched uniform random numbers from parallel xoshiro256+ lanes.
+ *
+ * The engine draws a uniform for every started flight hour's fault check and
+ * for every randomly deployed vehicle. BatchRandom produces them a block at a
+ * time from eight independent xoshiro256+ generators, one per AVX-512 lane
+ * (two AVX2 registers), and hands them out from the buffer, so a draw is a
+ * load and a compare instead of a call into std::mt19937 and a distribution.
+ *
+ * Each uniform takes the top 52 bits of a lane's output as the mantissa of a
+ * double in [1, 2) and subtracts one, which is exact, so every kernel (see
+ * evtolsimd.h) produces the same stream bit for bit. Lanes are seeded from
+ * one 64-bit seed through splitmix64.
+ */
+
+#ifndef EVTOLRANDOM_H
+#define EVTOLRANDOM_H
+
+#include "evtolsimd.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Class BatchRandom : Buffered uniforms in [0, 1) from eight xoshiro256+ lanes.
+ */
+class BatchRandom {
+public:
+    static const size_t kLanes = 8;
+    static const size_t kBlock = 512;  // Uniforms per refill, a multiple of kLanes
+
+    explicit BatchRandom(SimdLevel kernel = SimdLevel::Auto);
+
+    // Restarts the stream; the first draw after it fills a block.
+    void seed(uint64_t seed);
+
+    double uniform() {
+        if (next == kBlock) refill();
+        return buffer[next++];
+    }
+
+    // Uniform index in [0, n), n > 0.
+    int index(int n) { return std::min(static_cast<int>(uniform() * n), n - 1); }
+
+    // Copies the next n uniforms of the stream to out.
+    void fill(double *out, size_t n);
+
+    // The kernel refills use: the requested one, or the widest narrower one the CPU supports.
+    SimdLevel kernel() const { return active_kernel; }
+
+private:
+    void refill();
+
+    SimdLevel active_kernel;
+    uint64_t state[4][kLanes];  // xoshiro256+ state words, lane-major within each word
+    double buffer[kBlock];  // Round r, lane l at r * kLanes + l
+    size_t next = kBlock;
+};
+
+#endif // EVTOLRANDOM_H
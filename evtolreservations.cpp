@@ -0,0 +1,116 @@
+/**
+ * File: evtolreservations.cpp
+ * Augmented treap behind ReservationCalendar.
+ */
+
+#include "evtolreservations.h"
+
+#include <algorithm>
+
+void ReservationCalendar::update(int node) {
+    Node &n = nodes[node];
+    n.min_start = n.start;
+    n.max_end = n.end;
+    n.max_gap = 0;
+    if (n.left >= 0) {
+        const Node &l = nodes[n.left];
+        n.min_start = l.min_start;
+        n.max_gap = std::max(l.max_gap, n.start - l.max_end);
+    }
+    if (n.right >= 0) {
+        const Node &r = nodes[n.right];
+        n.max_end = r.max_end;
+        n.max_gap = std::max(n.max_gap, std::max(r.max_gap, r.min_start - n.end));
+    }
+}
+
+int ReservationCalendar::merge(int a, int b) {
+    if (a < 0) return b;
+    if (b < 0) return a;
+    if (nodes[a].priority > nodes[b].priority) {
+        nodes[a].right = merge(nodes[a].right, b);
+        update(a);
+        return a;
+    }
+    nodes[b].left = merge(a, nodes[b].left);
+    update(b);
+    return b;
+}
+
+void ReservationCalendar::split(int node, double start, int &less, int &rest) {
+    if (node < 0) {
+        less = rest = -1;
+        return;
+    }
+    if (nodes[node].start < start) {
+        split(nodes[node].right, start, nodes[node].right, rest);
+        less = node;
+    } else {
+        split(nodes[node].left, start, less, nodes[node].left);
+        rest = node;
+    }
+    update(node);
+}
+
+double ReservationCalendar::fit(int node, double from, double length) const {
+    // Everything in the subtree ends before from, or starts late enough
+    if (node < 0) return from;
+    const Node &n = nodes[node];
+    if (n.max_end <= from || n.min_start >= from + length) return from;
+
+    // Starting before the subtree, the slot goes after its first wide enough gap,
+    // and with no such gap only after the whole subtree
+    if (from <= n.min_start && n.max_gap < length) return n.max_end;
+
+    double slot = fit(n.left, from, length);
+    if (slot + length <= n.start) return slot;
+    return fit(n.right, std::max(slot, n.end), length);
+}
+
+double ReservationCalendar::earliestFit(double from, double length) const {
+    return fit(root, from, length);
+}
+
+void ReservationCalendar::book(double start, double end) {
+    int node;
+    if (!free_nodes.empty()) {
+        node = free_nodes.back();
+        free_nodes.pop_back();
+    } else {
+        node = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+    }
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    nodes[node] = {start, end, state, -1, -1, start, end, 0};
+
+    int less, rest;
+    split(root, start, less, rest);
+    root = merge(merge(less, node), rest);
+    count++;
+}
+
+bool ReservationCalendar::cancel(double start) {
+    // Split out the bookings starting exactly at start; there is at most one
+    int less, rest, match, after;
+    split(root, start, less, rest);
+    int node = rest;
+    while (node >= 0 && nodes[node].left >= 0) node = nodes[node].left;
+    bool found = node >= 0 && nodes[node].start == start;
+    if (found) {
+        split(rest, nodes[node].end, match, after);
+        free_nodes.push_back(match);
+        count--;
+        rest = after;
+    }
+    root = merge(less, rest);
+    return found;
+}
+
+void ReservationCalendar::clear() {
+    nodes.clear();
+    free_nodes.clear();
+    root = -1;
+    count = 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * File: evtolreservations.h
+ * Booking calendar of one charger.
+ *
+ * Bookings are disjoint [start, end) intervals kept in a treap ordered by
+ * start. Every node also holds the earliest start, latest end and widest gap
+ * between consecutive bookings of its subtree, so an earliest-fit query only
+ * descends into subtrees that can hold the slot: booking, cancelling and
+ * finding the earliest free slot of a given length are all O(log n) expected.
+ */
+
+#ifndef EVTOLRESERVATIONS_H
+#define EVTOLRESERVATIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Class ReservationCalendar : Disjoint bookings of one charger with earliest-fit queries.
+ */
+class ReservationCalendar {
+public:
+    // Earliest start at or after from where [start, start + length) overlaps no booking.
+    double earliestFit(double from, double length) const;
+
+    // Books [start, end); the interval must not overlap an existing booking.
+    void book(double start, double end);
+
+    /**
+     * Removes the booking that starts at start.
+     * returns True if there was one, false otherwise.
+     */
+    bool cancel(double start);
+
+    size_t size() const { return count; }
+    void clear();
+
+private:
+    struct Node {
+        double start;
+        double end;
+        uint32_t priority;
+        int left;
+        int right;
+        double min_start;  // Over the subtree
+        double max_end;
+        double max_gap;  // Widest gap between consecutive bookings of the subtree
+    };
+
+    void update(int node);
+    int merge(int a, int b);
+    void split(int node, double start, int &less, int &rest);
+    double fit(int node, double from, double length) const;
+
+    std::vector<Node> nodes;
+    std::vector<int> free_nodes;
+    int root = -1;
+    size_t count = 0;
+    uint32_t state = 0x9e3779b9u;  // Priority generator (xorshift)
+};
+
+#endif // EVTOLRESERVATIONS_H
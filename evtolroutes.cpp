@@ -0,0 +1,117 @@
+/**
+ * File: evtolroutes.cpp
+ * Parallel all-pairs shortest paths for RouteTable.
+ */
+
+#include "evtolroutes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// Adjacency in compressed sparse row form.
+struct Graph {
+    std::vector<int> start;
+    std::vector<int> target;
+    std::vector<double> miles;
+};
+
+double straightLine(const Vertiport &a, const Vertiport &b) {
+    return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+Graph buildGraph(const DemandProfile &profile) {
+    size_t n = profile.vertiports.size();
+    std::vector<std::vector<std::pair<int, double>>> adjacency(n);
+    for (const RouteLink &link : profile.links) {
+        if (link.from < 0 || link.to < 0 || static_cast<size_t>(link.from) >= n || static_cast<size_t>(link.to) >= n) {
+            continue;
+        }
+        double miles = link.miles > 0 ? link.miles
+                                      : straightLine(profile.vertiports[link.from], profile.vertiports[link.to]);
+        adjacency[link.from].push_back({link.to, miles});
+        adjacency[link.to].push_back({link.from, miles});
+    }
+
+    Graph graph;
+    graph.start.assign(n + 1, 0);
+    for (size_t v = 0; v < n; v++) {
+        graph.start[v + 1] = graph.start[v] + static_cast<int>(adjacency[v].size());
+        for (const auto &edge : adjacency[v]) {
+            graph.target.push_back(edge.first);
+            graph.miles.push_back(edge.second);
+        }
+    }
+    return graph;
+}
+
+// Single-source shortest paths into one row of the matrix.
+void dijkstra(const Graph &graph, int source, double *row, size_t n) {
+    std::fill(row, row + n, std::numeric_limits<double>::infinity());
+    row[source] = 0;
+    typedef std::pair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> frontier;
+    frontier.push({0.0, source});
+
+    while (!frontier.empty()) {
+        Entry entry = frontier.top();
+        frontier.pop();
+        if (entry.first > row[entry.second]) continue;
+        for (int e = graph.start[entry.second]; e < graph.start[entry.second + 1]; e++) {
+            double miles = entry.first + graph.miles[e];
+            if (miles < row[graph.target[e]]) {
+                row[graph.target[e]] = miles;
+                frontier.push({miles, graph.target[e]});
+            }
+        }
+    }
+}
+
+} // namespace
+
+void RouteTable::build(const DemandProfile &profile, const std::vector<EVTOL_Spec> &specs, int threads) {
+    count = profile.vertiports.size();
+    size_t n = count;
+    route_miles.assign(n * n, 0.0);
+
+    if (profile.links.empty()) {
+        // Direct flights between every pair
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                route_miles[i * n + j] = straightLine(profile.vertiports[i], profile.vertiports[j]);
+            }
+        }
+    } else {
+        // One Dijkstra per source, sources interleaved across threads
+        Graph graph = buildGraph(profile);
+        if (threads <= 0) threads = static_cast<int>(std::thread::hardware_concurrency());
+        threads = std::max(1, std::min(threads, static_cast<int>(n)));
+        auto work = [&](int first) {
+            for (size_t source = first; source < n; source += threads) {
+                dijkstra(graph, static_cast<int>(source), &route_miles[source * n], n);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < threads; t++) workers.emplace_back(work, t);
+        work(0);
+        for (auto &worker : workers) worker.join();
+    }
+
+    // Per-manufacturer flight time and energy
+    spec_hours.resize(specs.size());
+    spec_kwh.resize(specs.size());
+    for (size_t s = 0; s < specs.size(); s++) {
+        spec_hours[s].resize(n * n);
+        spec_kwh[s].resize(n * n);
+        for (size_t k = 0; k < n * n; k++) {
+            spec_hours[s][k] = route_miles[k] / specs[s].cruise_speed;
+            spec_kwh[s][k] = route_miles[k] * specs[s].energy_use;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * File: evtolroutes.h
+ * Precomputed route graph between vertiports.
+ *
+ * Vertiports are connected by the links of a DemandProfile (or, without
+ * links, by direct flights between every pair). All-pairs shortest paths are
+ * computed once per scenario, with one Dijkstra per source vertiport spread
+ * across threads, and stored as flat row-major matrices: route miles, plus
+ * flight hours and energy (kWh) per manufacturer. A route lookup in the event
+ * loop is then a single indexed load.
+ */
+
+#ifndef EVTOLROUTES_H
+#define EVTOLROUTES_H
+
+#include "evtolsimulation.h"
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+/**
+ * Class RouteTable : All-pairs route distance, time and energy between vertiports.
+ *
+ * Unreachable pairs have infinite miles, hours and energy.
+ */
+class RouteTable {
+public:
+    /**
+     * Computes the matrices for the vertiports, links and specs.
+     * threads 0 picks the hardware concurrency.
+     */
+    void build(const DemandProfile &profile, const std::vector<EVTOL_Spec> &specs, int threads = 0);
+
+    double miles(int from, int to) const { return route_miles[index(from, to)]; }
+    double hours(int spec, int from, int to) const { return spec_hours[spec][index(from, to)]; }
+    double kwh(int spec, int from, int to) const { return spec_kwh[spec][index(from, to)]; }
+
+    bool reachable(int from, int to) const { return miles(from, to) < std::numeric_limits<double>::infinity(); }
+    size_t sites() const { return count; }
+
+private:
+    size_t index(int from, int to) const { return static_cast<size_t>(from) * count + static_cast<size_t>(to); }
+
+    size_t count = 0;
+    std::vector<double> route_miles;
+    std::vector<std::vector<double>> spec_hours;  // Per spec, row-major
+    std::vector<std::vector<double>> spec_kwh;  // Per spec, row-major
+};
+
+#endif // EVTOLROUTES_H
@@ -0,0 +1,109 @@
+/**
+ * File: evtolseries.cpp
+ * LTTB downsampling and the fleet series recorder.
+ */
+
+#include "evtolseries.h"
+
+#include <algorithm>
+#include <cmath>
+
+void downsampleLTTB(const double *time, const double *value, size_t count, size_t max_points, TimeSeries &out) {
+    out.clear();
+    if (count <= max_points || count <= 2) {
+        out.time.assign(time, time + count);
+        out.value.assign(value, value + count);
+        return;
+    }
+    out.time.reserve(std::max<size_t>(max_points, 2));
+    out.value.reserve(std::max<size_t>(max_points, 2));
+    out.time.push_back(time[0]);
+    out.value.push_back(value[0]);
+
+    // The points between the ends fall into max_points - 2 buckets; bucket i is [lo(i), lo(i + 1))
+    size_t buckets = max_points > 2 ? max_points - 2 : 0;
+    double width = buckets ? static_cast<double>(count - 2) / buckets : 0.0;
+    auto lo = [&](size_t i) { return i < buckets ? 1 + static_cast<size_t>(i * width) : count - 1; };
+
+    size_t kept = 0;
+    for (size_t i = 0; i < buckets; i++) {
+        // Mean of the next bucket, or the last point after the final bucket
+        size_t next_lo = lo(i + 1), next_hi = i + 1 < buckets ? lo(i + 2) : count;
+        double mean_t = 0, mean_v = 0;
+        for (size_t j = next_lo; j < next_hi; j++) {
+            mean_t += time[j];
+            mean_v += value[j];
+        }
+        mean_t /= next_hi - next_lo;
+        mean_v /= next_hi - next_lo;
+
+        // The point of this bucket spanning the largest triangle with the last kept point and that mean
+        double at = time[kept], av = value[kept];
+        size_t best = lo(i);
+        double best_area = -1;
+        for (size_t j = lo(i); j < next_lo; j++) {
+            double area = std::fabs((at - mean_t) * (value[j] - av) - (at - time[j]) * (mean_v - av));
+            if (area > best_area) {
+                best_area = area;
+                best = j;
+            }
+        }
+        out.time.push_back(time[best]);
+        out.value.push_back(value[best]);
+        kept = best;
+    }
+
+    out.time.push_back(time[count - 1]);
+    out.value.push_back(value[count - 1]);
+}
+
+TimeSeries &FleetSeries::metric(size_t m) {
+    TimeSeries *all[kSeriesMetrics] = {&airborne, &queue, &chargers_busy, &passenger_miles};
+    return *all[m];
+}
+
+const TimeSeries &FleetSeries::metric(size_t m) const {
+    return const_cast<FleetSeries *>(this)->metric(m);
+}
+
+void FleetSeries::clear() {
+    for (size_t m = 0; m < kSeriesMetrics; m++) metric(m).clear();
+}
+
+void SeriesRecorder::reset(size_t max_points) {
+    points = max_points > 0 ? std::max<size_t>(max_points, 2) : 0;
+    sample_time.clear();
+    for (auto &column : samples) column.clear();
+    kept.clear();
+}
+
+void SeriesRecorder::record(double time, double airborne, double queue, double chargers_busy,
+                            double passenger_miles) {
+    if (!enabled()) return;
+    if (sample_time.empty() || sample_time.back() != time) {
+        sample_time.push_back(time);
+        for (auto &column : samples) column.push_back(0.0);
+    }
+    samples[0].back() = airborne;
+    samples[1].back() = queue;
+    samples[2].back() = chargers_busy;
+    samples[3].back() = passenger_miles;
+}
+
+void SeriesRecorder::finishShift(double offset) {
+    if (!enabled()) return;
+
+    // Earlier shifts are already reduced; downsampling them again with this one keeps the total bounded
+    for (size_t m = 0; m < kSeriesMetrics; m++) {
+        TimeSeries &series = kept.metric(m);
+        joined_time.assign(series.time.begin(), series.time.end());
+        joined_value.assign(series.value.begin(), series.value.end());
+        for (size_t i = 0; i < sample_time.size(); i++) {
+            joined_time.push_back(sample_time[i] + offset);
+            joined_value.push_back(samples[m][i]);
+        }
+        downsampleLTTB(joined_time.data(), joined_value.data(), joined_time.size(), points, series);
+    }
+    sample_time.clear();
+    for (auto &column : samples) column.clear();
+}
@@ -0,0 +1,89 @@
+/**
+ * File: evtolseries.h
+ * Fleet time series for dashboards, downsampled to a bounded size.
+ *
+ * SeriesRecorder takes one sample of the fleet's state per event time and,
+ * when a shift ends, reduces each metric to at most a fixed number of points
+ * with Largest-Triangle-Three-Buckets (LTTB). LTTB splits the samples into
+ * equal buckets and keeps from each the point spanning the largest triangle
+ * with the point kept before it and the mean of the next bucket, so peaks,
+ * dips and steps survive where plain decimation would drop them. A run keeps
+ * the samples of one shift plus the reduced series of the shifts before it,
+ * so neither the payload nor the memory grows with the number of shifts.
+ */
+
+#ifndef EVTOLSERIES_H
+#define EVTOLSERIES_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Struct TimeSeries : Points (time, value) in time order.
+ */
+struct TimeSeries {
+    std::vector<double> time;  // hours
+    std::vector<double> value;
+
+    size_t size() const { return time.size(); }
+    bool empty() const { return time.empty(); }
+    void clear() {
+        time.clear();
+        value.clear();
+    }
+};
+
+/**
+ * Reduces count points to at most max_points with LTTB, always keeping the
+ * first and the last; a max_points below three keeps only those two.
+ */
+void downsampleLTTB(const double *time, const double *value, size_t count, size_t max_points, TimeSeries &out);
+
+// Number of metrics in FleetSeries.
+constexpr size_t kSeriesMetrics = 4;
+
+/**
+ * Struct FleetSeries : The fleet's state over a run, one series per metric.
+ *
+ * Shift s covers [s * horizon, (s + 1) * horizon) of the time axis.
+ */
+struct FleetSeries {
+    TimeSeries airborne;  // Vehicles in flight
+    TimeSeries queue;  // Vehicles waiting to start charging
+    TimeSeries chargers_busy;  // Charging sessions in progress
+    TimeSeries passenger_miles;  // Cumulative, credited as each flight starts
+
+    TimeSeries &metric(size_t m);
+    const TimeSeries &metric(size_t m) const;
+    bool empty() const { return airborne.empty(); }
+    void clear();
+};
+
+/**
+ * Class SeriesRecorder : Samples the fleet's state and keeps it downsampled.
+ */
+class SeriesRecorder {
+public:
+    // Starts a run keeping at most max_points (at least 2) per metric; 0 turns recording off.
+    void reset(size_t max_points);
+
+    bool enabled() const { return points > 0; }
+
+    // Samples the state at a time of the current shift; a later sample at the same time replaces it.
+    void record(double time, double airborne, double queue, double chargers_busy, double passenger_miles);
+
+    // Moves the shift's samples, shifted by offset hours, into the series and downsamples them.
+    void finishShift(double offset);
+
+    const FleetSeries &series() const { return kept; }
+
+private:
+    size_t points = 0;
+    std::vector<double> sample_time;
+    std::vector<double> samples[kSeriesMetrics];
+    FleetSeries kept;
+    std::vector<double> joined_time;  // Scratch for finishShift
+    std::vector<double> joined_value;
+};
+
+#endif // EVTOLSERIES_H
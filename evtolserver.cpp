@@ -0,0 +1,396 @@
+/**
+ * File: evtolserver.cpp
+ * Query parsing, response formatting and the Unix domain socket server.
+ */
+
+#include "evtolserver.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Upper bounds that keep a single query from monopolizing the daemon
+const int kMaxVehicles = 1000000;
+const int kMaxReplicas = 100000;
+const int kMaxShifts = 100000;
+const double kMaxHorizonHours = 24 * 366;  // A year per shift
+const int kMaxSeriesPoints = 100000;
+
+// Protocol names of the FleetSeries metrics, in metric order
+const char *const kSeriesNames[kSeriesMetrics] = {"airborne", "queue", "chargers_busy", "passenger_miles"};
+
+bool parseInt(const std::string &text, int min, int max, int &out) {
+    char *end = nullptr;
+    errno = 0;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (errno != 0 || end == text.c_str() || *end != '\0' || value < min || value > max) return false;
+    out = static_cast<int>(value);
+    return true;
+}
+
+bool parseDouble(const std::string &text, double &out) {
+    char *end = nullptr;
+    errno = 0;
+    out = std::strtod(text.c_str(), &end);
+    return errno == 0 && end != text.c_str() && *end == '\0';
+}
+
+void writeStat(std::ostringstream &out, const char *name, const RunningStat &stat) {
+    out << ' ' << name << '=' << stat.mean() << ',' << stat.stddev();
+}
+
+void writeMetrics(std::ostringstream &out, const MetricStats &stats) {
+    writeStat(out, "vehicles", stats.vehicles);
+    writeStat(out, "flight_time", stats.flight_time);
+    writeStat(out, "distance", stats.distance);
+    writeStat(out, "charge_time", stats.charge_time);
+    writeStat(out, "faults", stats.faults);
+    writeStat(out, "passenger_miles", stats.passenger_miles);
+}
+
+bool writeAll(int fd, const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+bool parseQuery(const std::string &line, ScenarioQuery &query, std::string &error) {
+    std::istringstream in(line);
+    std::string token;
+
+    while (in >> token) {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos) {
+            error = "expected key=value, got '" + token + "'";
+            return false;
+        }
+        std::string key = token.substr(0, eq);
+        std::string value = token.substr(eq + 1);
+        Scenario &scenario = query.scenario;
+
+        bool ok;
+        if (key == "vehicles") {
+            ok = parseInt(value, 0, kMaxVehicles, scenario.vehicle_count);
+        } else if (key == "chargers") {
+            ok = parseInt(value, 0, kMaxVehicles, scenario.chargers);
+        } else if (key == "replicas") {
+            ok = parseInt(value, 1, kMaxReplicas, query.replicas);
+        } else if (key == "horizon") {
+            ok = parseDouble(value, scenario.horizon_hours) && std::isfinite(scenario.horizon_hours) &&
+                 scenario.horizon_hours >= 0 && scenario.horizon_hours <= kMaxHorizonHours;
+        } else if (key == "seed") {
+            int seed = 0;
+            ok = parseInt(value, 0, 2147483647, seed);
+            scenario.seed = static_cast<unsigned int>(seed);
+        } else if (key == "charge") {
+            ok = value == "full" || value == "need" || value == "reserve";
+            scenario.charge_to_need = value == "need";
+            scenario.reservations = value == "reserve";
+        } else if (key == "preempt") {
+            scenario.preemption = value != "off";
+            ok = !scenario.preemption ||
+                 (parseDouble(value, scenario.preempt_soc) && scenario.preempt_soc >= 0 && scenario.preempt_soc <= 1);
+        } else if (key == "trip") {
+            // trip=<fixed|uniform|exp|lognormal>:<mean miles>
+            MissionProfile &mission = scenario.missions;
+            size_t colon = value.find(':');
+            std::string kind = value.substr(0, colon);
+            mission.enabled = true;
+            ok = colon != std::string::npos && parseDouble(value.substr(colon + 1), mission.mean_miles) &&
+                 mission.mean_miles > 0;
+            if (kind == "fixed") {
+                mission.distribution = TripDistribution::Fixed;
+            } else if (kind == "uniform") {
+                mission.distribution = TripDistribution::Uniform;
+            } else if (kind == "exp") {
+                mission.distribution = TripDistribution::Exponential;
+            } else if (kind == "lognormal") {
+                mission.distribution = TripDistribution::Lognormal;
+            } else {
+                ok = false;
+            }
+        } else if (key == "turnaround") {
+            ok = parseDouble(value, scenario.missions.turnaround_hours) && scenario.missions.turnaround_hours >= 0;
+        } else if (key == "reserve") {
+            double &reserve = scenario.missions.reserve_soc;
+            ok = parseDouble(value, reserve) && reserve >= 0 && reserve < 1;
+        } else if (key == "repair") {
+            // repair=off or repair=<bays>:<hours>
+            MaintenanceProfile &maintenance = scenario.maintenance;
+            size_t colon = value.find(':');
+            maintenance.enabled = value != "off";
+            ok = !maintenance.enabled ||
+                 (colon != std::string::npos && parseInt(value.substr(0, colon), 0, kMaxVehicles, maintenance.bays) &&
+                  parseDouble(value.substr(colon + 1), maintenance.repair_hours) && maintenance.repair_hours > 0);
+        } else if (key == "price") {
+            // price=<per kWh for hour 0>,<hour 1>,... repeating; enables energy metering
+            EnergyProfile &energy = scenario.energy;
+            energy.enabled = true;
+            energy.hourly_price.clear();
+            std::istringstream prices(value);
+            std::string price;
+            ok = true;
+            while (ok && std::getline(prices, price, ',')) {
+                double p;
+                ok = parseDouble(price, p) && p >= 0;
+                energy.hourly_price.push_back(p);
+            }
+            ok = ok && !energy.hourly_price.empty();
+        } else if (key == "sitecap") {
+            scenario.energy.enabled = true;
+            ok = parseDouble(value, scenario.energy.site_power_kw) && scenario.energy.site_power_kw >= 0;
+        } else if (key == "shifts") {
+            // shifts=<count> or shifts=<count>:<capacity fade per full cycle>
+            ShiftProfile &shifts = scenario.shifts;
+            size_t colon = value.find(':');
+            ok = parseInt(value.substr(0, colon), 1, kMaxShifts, shifts.count) &&
+                 (colon == std::string::npos ||
+                  (parseDouble(value.substr(colon + 1), shifts.fade_per_cycle) && shifts.fade_per_cycle >= 0 &&
+                   shifts.fade_per_cycle < 1));
+        } else if (key == "sensitivity") {
+            ok = value == "on" || value == "off";
+            scenario.sensitivities = value == "on";
+        } else if (key == "estimate") {
+            query.estimate.clear();
+            std::istringstream factors(value);
+            std::string factor;
+            ok = true;
+            while (ok && std::getline(factors, factor, ',')) {
+                double f;
+                ok = parseDouble(factor, f) && f > 0;
+                query.estimate.push_back(f);
+            }
+            ok = ok && !query.estimate.empty();
+        } else if (key == "series") {
+            ok = parseInt(value, 0, kMaxSeriesPoints, scenario.series_points) && scenario.series_points != 1;
+        } else if (key == "mix") {
+            scenario.fleet_mix.clear();
+            std::istringstream counts(value);
+            std::string count;
+            ok = true;
+            while (ok && std::getline(counts, count, ',')) {
+                int n = 0;
+                ok = parseInt(count, 0, kMaxVehicles, n);
+                scenario.fleet_mix.push_back(n);
+            }
+            ok = ok && scenario.fleet_mix.size() <= scenario.specs.size() && scenario.fleetSize() <= kMaxVehicles;
+        } else {
+            error = "unknown key '" + key + "'";
+            return false;
+        }
+
+        if (!ok) {
+            error = "invalid value for '" + key + "'";
+            return false;
+        }
+    }
+    const Scenario &scenario = query.scenario;
+    if (scenario.occupancy_slot_hours > 0 && !OccupancyTimeline::fits(static_cast<size_t>(scenario.chargers))) {
+        error = "too many chargers for occupancy timelines";
+        return false;
+    }
+    return true;
+}
+
+std::string formatStats(const ScenarioStats &stats) {
+    std::ostringstream out;
+    out << "ok replicas=" << stats.replicas << " events=" << stats.events << "\n";
+    out << "fleet";
+    writeMetrics(out, stats.fleet);
+    out << "\n";
+    if (stats.occupancy.utilization.count > 0) {
+        out << "chargers";
+        writeStat(out, "utilization", stats.occupancy.utilization);
+        writeStat(out, "all_busy", stats.occupancy.all_busy);
+        writeStat(out, "idle_gaps", stats.occupancy.idle_gaps);
+        writeStat(out, "longest_gap", stats.occupancy.longest_gap);
+        out << "\n";
+    }
+    if (stats.demand.requests.count > 0) {
+        out << "demand";
+        writeStat(out, "requests", stats.demand.requests);
+        writeStat(out, "served", stats.demand.served);
+        writeStat(out, "dropped", stats.demand.dropped);
+        writeStat(out, "wait_hours", stats.demand.mean_wait);
+        writeStat(out, "deadhead_miles", stats.demand.deadhead_miles);
+        out << "\n";
+    }
+    if (stats.maintenance.repairs.count > 0) {
+        out << "maintenance";
+        writeStat(out, "repairs", stats.maintenance.repairs);
+        writeStat(out, "wait_hours", stats.maintenance.wait_hours);
+        writeStat(out, "bay_hours", stats.maintenance.bay_hours);
+        out << "\n";
+    }
+    if (stats.energy.energy_kwh.count > 0) {
+        out << "energy";
+        writeStat(out, "kwh", stats.energy.energy_kwh);
+        writeStat(out, "cost", stats.energy.cost);
+        writeStat(out, "peak_kw", stats.energy.peak_kw);
+        writeStat(out, "power_wait_hours", stats.energy.power_wait_hours);
+        out << "\n";
+    }
+    if (stats.shifts.passenger_miles.count > 0) {
+        out << "shifts";
+        writeStat(out, "passenger_miles", stats.shifts.passenger_miles);
+        writeStat(out, "min_passenger_miles", stats.shifts.min_passenger_miles);
+        writeStat(out, "last_passenger_miles", stats.shifts.last_passenger_miles);
+        writeStat(out, "mean_capacity", stats.shifts.mean_capacity);
+        writeStat(out, "min_capacity", stats.shifts.min_capacity);
+        out << "\n";
+    }
+    for (size_t m = 0; m < kSeriesMetrics && !stats.series.empty(); m++) {
+        const TimeSeries &series = stats.series.metric(m);
+        out << "series " << kSeriesNames[m];
+        for (size_t i = 0; i < series.size(); i++) out << ' ' << series.time[i] << ',' << series.value[i];
+        out << "\n";
+    }
+    // Parameters as laid out in SensitivityStats: charge times, battery capacities, charger power
+    const SensitivityMetrics &derivatives = stats.sensitivities;
+    size_t specs = stats.companies.size();
+    for (size_t k = 0; k < derivatives.passenger_miles.size(); k++) {
+        out << "sensitivity ";
+        if (k < 2 * specs) {
+            out << (k < specs ? "charge_time@" : "battery_capacity@") << k % specs;
+        } else {
+            out << "charger_power";
+        }
+        writeStat(out, "passenger_miles", derivatives.passenger_miles[k]);
+        writeStat(out, "charge_time", derivatives.charge_time[k]);
+        out << "\n";
+    }
+    for (size_t c = 0; c < stats.companies.size(); c++) {
+        out << "company " << c;
+        writeMetrics(out, stats.companies[c]);
+        out << "\n";
+    }
+    out << "end\n";
+    return out.str();
+}
+
+std::string formatEstimate(const SurrogateModel &model, const SurrogateEstimate &estimate) {
+    std::ostringstream out;
+    out << "ok surrogate points=" << model.points << "\n";
+    out << "estimate";
+    for (size_t o = 0; o < model.outputs.size(); o++) {
+        out << ' ' << model.outputs[o] << '=' << estimate.value[o] << ',' << estimate.error[o];
+    }
+    out << "\nend\n";
+    return out.str();
+}
+
+QueryServer::~QueryServer() {
+    if (listen_fd >= 0) ::close(listen_fd);
+    if (!path.empty()) ::unlink(path.c_str());
+}
+
+bool QueryServer::listen(const std::string &socket_path, std::string &error) {
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        error = "socket path too long";
+        return false;
+    }
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+
+    ::unlink(socket_path.c_str());
+    if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || ::listen(listen_fd, 16) < 0) {
+        error = std::string("bind/listen: ") + std::strerror(errno);
+        ::close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    path = socket_path;
+    return true;
+}
+
+void QueryServer::serve() {
+    while (!stopping) {
+        int fd = ::accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break; // Listening socket was shut down by stop()
+        }
+        serveConnection(fd);
+        ::close(fd);
+    }
+}
+
+void QueryServer::stop() {
+    stopping = true;
+    if (listen_fd >= 0) ::shutdown(listen_fd, SHUT_RDWR);
+}
+
+std::string QueryServer::handle(const std::string &request) {
+    if (request == "ping") return "pong\nend\n";
+
+    ScenarioQuery query;
+    std::string error;
+    if (!parseQuery(request, query, error)) return "error " + error + "\nend\n";
+
+    if (!query.estimate.empty()) {
+        if (!surrogate) return "error no surrogate loaded\nend\n";
+        if (query.estimate.size() != surrogate->parameters.size()) {
+            return "error expected " + std::to_string(surrogate->parameters.size()) + " factors\nend\n";
+        }
+        SurrogateEstimate estimate;
+        if (surrogateCovers(*surrogate, query.scenario) &&
+            estimateSurrogate(*surrogate, query.estimate.data(), estimate)) {
+            return formatEstimate(*surrogate, estimate);
+        }
+
+        // Outside what the model was trained on: simulate the point instead
+        SweepPlan plan;
+        plan.parameters = surrogate->parameters;
+        Scenario point;
+        applySweepPoint(query.scenario, plan, query.estimate.data(), point);
+        query.scenario = point;
+    }
+
+    if (cache) return formatStats(cache->run(*pool, query.scenario, query.replicas));
+    return formatStats(pool->run(query.scenario, query.replicas));
+}
+
+void QueryServer::serveConnection(int fd) {
+    std::string buffer;
+    char chunk[4096];
+
+    while (!stopping) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        buffer.append(chunk, static_cast<size_t>(n));
+
+        // Answer every complete line received so far
+        size_t newline;
+        while ((newline = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            if (!writeAll(fd, handle(line))) return;
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * File: evtolserver.h
+ * What-if query daemon over a Unix domain socket.
+ *
+ * The server keeps a warm ReplicaPool (worker threads plus their simulation
+ * contexts) for its whole lifetime and answers scenario queries with
+ * aggregated replica statistics, so a query costs only the simulation itself.
+ *
+ * Protocol: one request per line, one response per request.
+ *
+ *   request  := "ping" | key=value { ' ' key=value }
+ *   keys     := vehicles, chargers, horizon (hours, at most a year), replicas, seed,
+ *               mix (comma-separated vehicle counts per manufacturer),
+ *               charge (full | need | reserve, booked chargers),
+ *               preempt (off | minimum SoC to preempt),
+ *               trip (fixed|uniform|exp|lognormal:mean miles, enables missions),
+ *               turnaround (hours), reserve (SoC kept after every trip),
+ *               repair (off | bays:hours, grounds faulted vehicles),
+ *               shifts (count[:capacity fade per full cycle]),
+ *               price (comma-separated price per kWh for each hour),
+ *               sitecap (charging kW per site),
+ *               series (points per time series, 0 = none; 1 is rejected),
+ *               sensitivity (on | off, pathwise derivatives),
+ *               estimate (comma-separated sweep factors for the surrogate)
+ *   response := "ok ..." line, a "fleet ..." line, a "chargers ..." line
+ *               (occupancy), for demand-mode scenarios (library callers) a
+ *               "demand ..." line (requests, served, dropped, mean wait hours,
+ *               deadhead miles), with repair a "maintenance ..." line (repairs,
+ *               bay wait and bay hours), with price or sitecap an "energy ..."
+ *               line (kWh, cost, peak site kW, power wait hours), with more than one
+ *               shift a "shifts ..." line (passenger miles per shift, of the
+ *               weakest and last shift, mean and lowest battery capacity), with
+ *               series one "series <metric> t,v ..." line per metric of the first replica, with sensitivities one
+ *               "sensitivity <parameter> ..." line per parameter, one
+ *               "company <i> ..." line per manufacturer, then "end"; or
+ *               "error <message>" then "end".
+ *
+ * A query with estimate= is answered from the server's SurrogateModel when
+ * the rest of the query is the scenario the model was trained around (seed
+ * aside) and every factor lies in its trained range: an "ok surrogate
+ * points=<n>" line, an "estimate name=value,error ..." line, then "end".
+ * Otherwise the factors are applied to the query's specs and it is
+ * simulated as usual.
+ *
+ * Statistics are written as name=mean,stddev over the replicas. When the
+ * server has a ResultCache, repeated queries with a non-zero seed are
+ * answered from it.
+ */
+
+#ifndef EVTOLSERVER_H
+#define EVTOLSERVER_H
+
+#include "evtolbatch.h"
+#include "evtolcache.h"
+#include "evtolsurrogate.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/**
+ * Struct ScenarioQuery : A scenario and the number of replicas to run.
+ */
+struct ScenarioQuery {
+    Scenario scenario;
+    int replicas = 1;
+    std::vector<double> estimate;  // Sweep factors to answer from a surrogate
+};
+
+/**
+ * Parses one request line into a query.
+ * returns True on success, false with a message in error otherwise.
+ */
+bool parseQuery(const std::string &line, ScenarioQuery &query, std::string &error);
+
+// Formats aggregated statistics as a protocol response (including "end").
+std::string formatStats(const ScenarioStats &stats);
+
+// Formats a surrogate estimate as a protocol response (including "end").
+std::string formatEstimate(const SurrogateModel &model, const SurrogateEstimate &estimate);
+
+/**
+ * Class QueryServer : Serves scenario queries on a Unix domain socket.
+ */
+class QueryServer {
+public:
+    explicit QueryServer(ReplicaPool &pool, ResultCache *cache = nullptr, const SurrogateModel *surrogate = nullptr)
+        : pool(&pool), cache(cache), surrogate(surrogate) {}
+    ~QueryServer();
+
+    QueryServer(const QueryServer &) = delete;
+    QueryServer &operator=(const QueryServer &) = delete;
+
+    /**
+     * Binds and listens on the socket path, replacing a stale socket file.
+     * returns True on success, false with a message in error otherwise.
+     */
+    bool listen(const std::string &socket_path, std::string &error);
+
+    // Accepts and serves connections until stop() is called.
+    void serve();
+
+    // Stops serve(); safe to call from another thread or a signal handler.
+    void stop();
+
+    // Answers a single request line.
+    std::string handle(const std::string &request);
+
+private:
+    void serveConnection(int fd);
+
+    ReplicaPool *pool;
+    ResultCache *cache;
+    const SurrogateModel *surrogate;
+    std::string path;
+    int listen_fd = -1;
+    std::atomic<bool> stopping{false};
+};
+
+#endif // EVTOLSERVER_H
@@ -0,0 +1,30 @@
+/**
+ * File: evtolsimd.cpp
+ * CPU feature checks behind resolveSimdLevel.
+ */
+
+#include "evtolsimd.h"
+
+#include <initializer_list>
+
+namespace {
+
+bool supported(SimdLevel level) {
+#ifdef EVTOL_X86_KERNELS
+    if (level == SimdLevel::Avx512) return __builtin_cpu_supports("avx512f");
+    if (level == SimdLevel::Avx2) return __builtin_cpu_supports("avx2");
+    return true;
+#else
+    return level == SimdLevel::Scalar;
+#endif
+}
+
+} // namespace
+
+SimdLevel resolveSimdLevel(SimdLevel requested) {
+    // Widest first, so an unsupported request falls back as far as it has to
+    for (SimdLevel level : {SimdLevel::Avx512, SimdLevel::Avx2}) {
+        if ((requested == SimdLevel::Auto || level <= requested) && supported(level)) return level;
+    }
+    return SimdLevel::Scalar;
+}
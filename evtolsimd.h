@@ -0,0 +1,25 @@
+/**
+ * File: evtolsimd.h
+ * Run-time choice of vector instruction sets.
+ *
+ * Kernels with AVX2 and AVX-512 variants are compiled with per-function
+ * target attributes, so one binary runs the widest variant each CPU supports
+ * and the scalar code everywhere else. The variants exist in EVTOL_SIMD
+ * builds of the library for x86-64 with GCC or Clang.
+ */
+
+#ifndef EVTOLSIMD_H
+#define EVTOLSIMD_H
+
+// Library sources test this before defining AVX2 or AVX-512 kernels
+#if defined(EVTOL_SIMD) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define EVTOL_X86_KERNELS 1
+#endif
+
+// Instruction sets a kernel can use; Auto asks for the widest.
+enum class SimdLevel { Auto, Scalar, Avx2, Avx512 };
+
+// The requested level, or the widest narrower one the library and CPU support.
+SimdLevel resolveSimdLevel(SimdLevel requested);
+
+#endif // EVTOLSIMD_H
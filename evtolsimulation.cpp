@@ -7,218 +7,226 @@
  * The simulation ensures fair charger allocation, tracks faults, and computes stats.
  *
  * The code follows OOP principles, with classes for EVTOL vehicles and a 
- * SimulationManager to control execution.
+ * SimulationManager to control execution. The command-line entry point lives
+ * in main.cpp; this file builds into the evtolsim library.
  *
  * @author Ashish Chittimilla
  * @date March 17th 2025
  */
 
+#include "evtolsimulation.h"
+
+#include <algorithm>
 #include <iostream>
-#include <vector>
 #include <random>
 #include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <chrono>
-#include <queue>
-#include <algorithm>
-
 
-// Struct to define eVTOL vehicle properties
-struct EVTOL_Spec {
-    std::string company;
-    double cruise_speed;  // mph
-    double battery_capacity;  // kWh
-    double charge_time;  // hours
-    double energy_use;  // kWh/mile
-    int passenger_count;
-    double fault_probability;
-};
 
 // Manufacturer data
-std::vector<EVTOL_Spec> manufacturers = {
-    {"Alpha Company", 120, 320, 0.6, 1.6, 4, 0.25},
-    {"Bravo Company", 100, 100, 0.2, 1.5, 5, 0.10},
-    {"Charlie Company", 160, 220, 0.8, 2.2, 3, 0.05},
-    {"Delta Company", 90, 120, 0.62, 0.8, 2, 0.22},
-    {"Echo Company", 30, 150, 0.3, 5.8, 2, 0.61}
+const std::vector<EVTOL_Spec> manufacturers = {
+    {"Alpha Company", 120, 320, 0.6, 1.6, 4, 0.25, 0.80, 0.15},
+    {"Bravo Company", 100, 100, 0.2, 1.5, 5, 0.10, 0.85, 0.20},
+    {"Charlie Company", 160, 220, 0.8, 2.2, 3, 0.05, 0.75, 0.10},
+    {"Delta Company", 90, 120, 0.62, 0.8, 2, 0.22, 0.80, 0.20},
+    {"Echo Company", 30, 150, 0.3, 5.8, 2, 0.61, 0.90, 0.25}
 };
 
-// Synchronization for charging stations
-std::mutex charger_mutex;
-std::condition_variable charger_cv;
-int available_chargers = 3;
+int Scenario::fleetSize() const {
+    if (fleet_mix.empty()) return vehicle_count;
+    int total = 0;
+    for (int count : fleet_mix) total += count;
+    return total;
+}
 
-// Charging queue (vehicles that need charging)
-std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> chargingQueue;
-std::mutex queue_mutex;
+void RealTimeClock::advance(double hours) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(hours * ms_per_hour)));
+}
 
-/**
- * Class EVTOL : Represents an electric vertical takeoff and landing (eVTOL) vehicle.
- *
- * This class models an individual eVTOL's flight, battery usage, and charging behavior.
- * Each EVTOL operates within a 3-hour window, flying until its battery depletes, 
- * then queuing for charging.
- */
-class EVTOL {
-public:
-    EVTOL_Spec spec;
-    int vehicle_id;
-    double total_flight_time = 0;
-    double total_distance_traveled = 0;
-    double total_charge_time = 0;
-    int total_faults = 0;
-    double total_passenger_miles = 0;
-    double simulation_time = 3.0; // Simulation window of 3 hours
-
-    EVTOL(EVTOL_Spec spec, int id) : spec(spec), vehicle_id(id) {}
-
-    /**
-     * Simulates EVTOL behavior within 3 hours, including flight and charging.
-     */
-    void runFlightCycle() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<double> random_prob(0.0, 1.0);
-
-        while (simulation_time > 0) {
-            // Compute how long this vehicle can fly before battery depletion
-            double max_flight_time = spec.battery_capacity / (spec.energy_use * spec.cruise_speed);
-            max_flight_time = std::min(max_flight_time, simulation_time);
-
-            // Update flight statistics
-            total_flight_time += max_flight_time;
-            double distance = max_flight_time * spec.cruise_speed;
-            total_distance_traveled += distance;
-            total_passenger_miles += spec.passenger_count * distance;
-            simulation_time -= max_flight_time;
-
-            // Fault calculation
-            for (double hour = 0; hour < max_flight_time; hour += 1.0) {
-                if (random_prob(gen) < spec.fault_probability) {
-                    total_faults++;
-                }
-            }
+void VirtualClock::advance(double hours) {
+    std::lock_guard<std::mutex> lock(clock_mutex);
+    elapsed_hours += hours;
+}
 
-            // If there's still simulation time left, queue for charging
-            if (simulation_time > 0) {
-                queueForCharging();
-                if (!charge()) break; // If we couldn't charge in time, stop
-            }
-        }
-    }
+double VirtualClock::elapsed() const {
+    std::lock_guard<std::mutex> lock(clock_mutex);
+    return elapsed_hours;
+}
 
-    
-    //Adds the EVTOL to the charging queue.
-    void queueForCharging() {
-        std::lock_guard<std::mutex> lock(queue_mutex);
-        chargingQueue.push({simulation_time, vehicle_id});
-    }
+void ChargingScheduler::enqueue(double remaining_time, int vehicle_id) {
+    std::lock_guard<std::mutex> lock(charger_mutex);
+    chargingQueue.push({remaining_time, vehicle_id});
+}
 
-    /**
-     * Simulates the charging process.
-     * returns True if charging was successful, false otherwise.
-     */
-    bool charge() {
-        std::unique_lock<std::mutex> lock(charger_mutex);
+bool ChargingScheduler::acquire(int vehicle_id) {
+    std::unique_lock<std::mutex> lock(charger_mutex);
+    bool got_charger = charger_cv.wait_for(lock, wait_timeout, [this, vehicle_id] {
+        return available_chargers > 0 && !chargingQueue.empty() && chargingQueue.top().second == vehicle_id;
+    });
 
-        // Wait for available charger
-        bool got_charger = charger_cv.wait_for(lock, std::chrono::milliseconds(100), [this] {
-            return available_chargers > 0 && !chargingQueue.empty() && chargingQueue.top().second == vehicle_id;
-        });
+    if (!got_charger) return false;
 
-        if (!got_charger) return false; // If we couldn't charge in time, we stop here
+    // Take a charger
+    available_chargers--;
+    chargingQueue.pop(); // Remove from queue
+    return true;
+}
 
-        // Take a charger
-        available_chargers--;
-        chargingQueue.pop(); // Remove from queue
-        lock.unlock();
+void ChargingScheduler::release() {
+    {
+        std::lock_guard<std::mutex> lock(charger_mutex);
+        available_chargers++;
+    }
+    charger_cv.notify_all();
+}
 
-        // Simulate charging
-        double charging_duration = std::min(spec.charge_time, simulation_time);
-        if (charging_duration + total_flight_time > 3.0) return false; // If charge exceeds 3-hour window, stop
+size_t ChargingScheduler::queueSize() const {
+    std::lock_guard<std::mutex> lock(charger_mutex);
+    return chargingQueue.size();
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(charging_duration * 1000)));
-        total_charge_time += charging_duration;
-        simulation_time -= charging_duration;
+int ChargingScheduler::availableChargers() const {
+    std::lock_guard<std::mutex> lock(charger_mutex);
+    return available_chargers;
+}
 
-        // Release charger
-        lock.lock();
-        available_chargers++;
-        lock.unlock();
-        charger_cv.notify_all();
+bool ChargingScheduler::popNext(int &vehicle_id) {
+    std::lock_guard<std::mutex> lock(charger_mutex);
+    if (chargingQueue.empty()) return false;
+    vehicle_id = chargingQueue.top().second;
+    chargingQueue.pop();
+    return true;
+}
 
-        return true;
-    }
+void EVTOL::runFlightCycle() {
+    std::random_device rd;
+    std::mt19937 gen(seed != 0 ? seed : rd());
+    std::uniform_real_distribution<double> random_prob(0.0, 1.0);
+
+    while (simulation_time > 0) {
+        // Compute how long this vehicle can fly before battery depletion
+        double max_flight_time = spec.battery_capacity / (spec.energy_use * spec.cruise_speed);
+        max_flight_time = std::min(max_flight_time, simulation_time);
+
+        // Update flight statistics
+        total_flight_time += max_flight_time;
+        double distance = max_flight_time * spec.cruise_speed;
+        total_distance_traveled += distance;
+        total_passenger_miles += spec.passenger_count * distance;
+        simulation_time -= max_flight_time;
+
+        // Fault calculation
+        for (double hour = 0; hour < max_flight_time; hour += 1.0) {
+            if (random_prob(gen) < spec.fault_probability) {
+                total_faults++;
+            }
+        }
 
-    void run() {
-        runFlightCycle();
+        // If there's still simulation time left, queue for charging
+        if (simulation_time > 0) {
+            queueForCharging();
+            if (!charge()) break; // If we couldn't charge in time, stop
+        }
     }
+}
 
-    /**
-     * Prints the statistics of the EVTOL's flight and charging performance.
-     */
-    void printStats() const {
-        std::cout << "Vehicle ID: " << vehicle_id << " | Company: " << spec.company << "\n";
-        std::cout << "  Total Flight Time: " << total_flight_time << " hours\n";
-        std::cout << "  Total Distance: " << total_distance_traveled << " miles\n";
-        std::cout << "  Total Charge Time: " << total_charge_time << " hours\n";
-        std::cout << "  Total Faults: " << total_faults << "\n";
-        std::cout << "  Total Passenger Miles: " << total_passenger_miles << " miles\n";
-        std::cout << "-----------------------------------\n";
-    }
-};
+void EVTOL::queueForCharging() {
+    scheduler->enqueue(simulation_time, vehicle_id);
+}
 
-/**
- * Class SimulationManager : Manages simulation execution for multiple EVTOLs.
- */
-class SimulationManager {
-public:
-    std::vector<EVTOL> vehicles;
-    
-    
-    //Deploys 20 randomly chosen EVTOLs from different manufacturers.
-    void deployVehicles() {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<int> dist(0, 4);
-
-        // Deploy 20 random vehicles
-        for (int i = 0; i < 20; i++) {
-            EVTOL_Spec spec = manufacturers[dist(gen)];
-            vehicles.emplace_back(spec, i + 1);
-        }
+bool EVTOL::charge() {
+    // Wait for available charger
+    if (!scheduler->acquire(vehicle_id)) return false; // If we couldn't charge in time, we stop here
+
+    // Simulate charging
+    double charging_duration = std::min(spec.charge_time, simulation_time);
+    if (charging_duration + total_flight_time > horizon) {
+        scheduler->release();
+        return false; // If charge exceeds the window, stop
     }
 
-    //Starts the simulation by launching threads for each EVTOL.
-    void startSimulation() {
-        std::vector<std::thread> threads;
+    clock->advance(charging_duration);
+    total_charge_time += charging_duration;
+    simulation_time -= charging_duration;
 
-        for (auto &vehicle : vehicles) {
-            threads.push_back(std::thread(&EVTOL::run, &vehicle));
-        }
+    // Release charger
+    scheduler->release();
+
+    return true;
+}
+
+VehicleStats EVTOL::stats() const {
+    return {vehicle_id, spec.company, total_flight_time, total_distance_traveled,
+            total_charge_time, total_faults, total_passenger_miles};
+}
 
-        for (auto &t : threads) {
-            if (t.joinable()) t.join();
+void EVTOL::printStats() const {
+    std::cout << "Vehicle ID: " << vehicle_id << " | Company: " << spec.company << "\n";
+    std::cout << "  Total Flight Time: " << total_flight_time << " hours\n";
+    std::cout << "  Total Distance: " << total_distance_traveled << " miles\n";
+    std::cout << "  Total Charge Time: " << total_charge_time << " hours\n";
+    std::cout << "  Total Faults: " << total_faults << "\n";
+    std::cout << "  Total Passenger Miles: " << total_passenger_miles << " miles\n";
+    std::cout << "-----------------------------------\n";
+}
+
+SimulationManager::SimulationManager() : clock(&real_clock), scheduler(config.chargers) {}
+
+SimulationManager::SimulationManager(SimulationClock &clock, int chargers)
+    : clock(&clock), scheduler(chargers) {
+    config.chargers = chargers;
+}
+
+SimulationManager::SimulationManager(const Scenario &scenario, SimulationClock &clock)
+    : config(scenario), clock(&clock), scheduler(scenario.chargers) {}
+
+void SimulationManager::deployVehicles() {
+    std::random_device rd;
+    std::mt19937 gen(config.seed != 0 ? config.seed : rd());
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(config.specs.size()) - 1);
+
+    // Deploy the fixed fleet mix in spec order, otherwise random vehicles
+    int fleet_size = config.fleetSize();
+    size_t mix_spec = 0;
+    int mix_left = config.fleet_mix.empty() ? 0 : config.fleet_mix[0];
+    for (int i = 0; i < fleet_size; i++) {
+        int spec_index;
+        if (config.fleet_mix.empty()) {
+            spec_index = dist(gen);
+        } else {
+            while (mix_left == 0) mix_left = config.fleet_mix[++mix_spec];
+            spec_index = static_cast<int>(mix_spec);
+            mix_left--;
         }
+        EVTOL_Spec spec = config.specs[spec_index];
+        vehicles.emplace_back(spec, i + 1, scheduler, *clock, config.horizon_hours);
+        if (config.seed != 0) vehicles.back().seed = config.seed + i + 1;
     }
+}
 
-    
-    //Prints simulation results.
-    void printResults() {
-        std::cout << "Simulation Results:\n";
-        for (const auto &vehicle : vehicles) {
-            vehicle.printStats();
-        }
+void SimulationManager::startSimulation() {
+    std::vector<std::thread> threads;
+
+    for (auto &vehicle : vehicles) {
+        threads.push_back(std::thread(&EVTOL::run, &vehicle));
     }
-};
 
+    for (auto &t : threads) {
+        if (t.joinable()) t.join();
+    }
+}
 
-int main() {
-    SimulationManager sim;
-    sim.deployVehicles();
-    sim.startSimulation();
-    sim.printResults();
-    return 0;
+std::vector<VehicleStats> SimulationManager::results() const {
+    std::vector<VehicleStats> out;
+    out.reserve(vehicles.size());
+    for (const auto &vehicle : vehicles) {
+        out.push_back(vehicle.stats());
+    }
+    return out;
 }
 
+void SimulationManager::printResults() const {
+    std::cout << "Simulation Results:\n";
+    for (const auto &vehicle : vehicles) {
+        vehicle.printStats();
+    }
+}
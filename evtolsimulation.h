@@ -0,0 +1,411 @@
+/**
+ * File: evtolsimulation.h
+ * Public interface of the eVTOL simulation library.
+ *
+ * Declares the manufacturer spec table, the scenario description, the
+ * simulation engine (EVTOL vehicles driven by a SimulationManager) and the
+ * per-vehicle results it produces. The command-line simulator, the unit tests
+ * and the benchmarks all link against this library.
+ *
+ * @author Ashish Chittimilla
+ * @date March 17th 2025
+ */
+
+#ifndef EVTOLSIMULATION_H
+#define EVTOLSIMULATION_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Struct to define eVTOL vehicle properties
+struct EVTOL_Spec {
+    std::string company;
+    double cruise_speed;  // mph
+    double battery_capacity;  // kWh
+    double charge_time;  // hours
+    double energy_use;  // kWh/mile
+    int passenger_count;
+    double fault_probability;
+    double cv_soc = 1.0;  // State of charge where the constant-voltage taper starts (1 = constant rate)
+    double taper_power = 1.0;  // Charging power at full charge, as a fraction of peak power
+};
+
+// Manufacturer data
+extern const std::vector<EVTOL_Spec> manufacturers;
+
+// Distribution trip lengths are drawn from in mission mode.
+enum class TripDistribution { Fixed, Uniform, Exponential, Lognormal };
+
+/**
+ * Struct MissionProfile : Trip-based operations for the event engine.
+ *
+ * When enabled, vehicles fly discrete trips of sampled length instead of
+ * flying until empty. A vehicle charges when its next trip would take the
+ * battery below reserve_soc, and spends turnaround_hours on the ground after
+ * every trip.
+ */
+struct MissionProfile {
+    bool enabled = false;
+    TripDistribution distribution = TripDistribution::Exponential;
+    double mean_miles = 30;  // Trip length for Fixed, mean for the others
+    double spread = 0.5;  // Uniform: half-width as a fraction of the mean; Lognormal: sigma of log length
+    double turnaround_hours = 0.1;
+    double reserve_soc = 0.2;  // State of charge that must remain after every trip
+};
+
+/**
+ * Struct ChargerClass : Identical chargers of one power level and compatibility.
+ */
+struct ChargerClass {
+    int count;  // Per charger site
+    double power = 1.0;  // Charging speed relative to the spec's charge_time
+    std::vector<int> specs;  // Indices into Scenario::specs that can use it; empty = all
+};
+
+/**
+ * Struct Vertiport : A landing site with its own chargers.
+ */
+struct Vertiport {
+    double x;  // miles
+    double y;  // miles
+    int chargers;  // Replaces Scenario::chargers in demand mode
+    double demand_weight;  // Relative share of trip requests that start or end here
+};
+
+/**
+ * Struct RouteLink : A flyable corridor between two vertiports, in both directions.
+ */
+struct RouteLink {
+    int from;
+    int to;
+    double miles = 0;  // Corridor length; 0 uses the straight-line distance
+};
+
+/**
+ * Struct DemandProfile : Passenger trip requests across a vertiport network.
+ *
+ * When enabled, requests arrive as a Poisson process whose network-wide rate
+ * follows hourly_rate (one entry per hour, repeating), with origins and
+ * destinations drawn by demand_weight. Idle vehicles are dispatched to the
+ * requests at their vertiport, or fly empty from the nearest vertiport within
+ * max_deadhead_miles; requests unserved after max_wait_hours are dropped.
+ * Vehicles fly the shortest route over links, or straight between any two
+ * vertiports when there are no links.
+ */
+struct DemandProfile {
+    bool enabled = false;
+    std::vector<Vertiport> vertiports;
+    std::vector<double> hourly_rate;  // Trip requests per hour, network-wide
+    double max_wait_hours = 0.25;
+    double turnaround_hours = 0.1;
+    double reserve_soc = 0.2;  // State of charge that must remain after every trip
+    double charge_below_soc = 0.4;  // Idle vehicles below this state of charge go to charge
+    double max_deadhead_miles = 0;  // How far an empty vehicle may fly to a request's origin (0 = never)
+    std::vector<RouteLink> links;  // Route graph; empty means direct flights between all vertiports
+};
+
+/**
+ * Struct MaintenanceProfile : Fault-driven grounding for the event engine.
+ *
+ * When enabled, a vehicle that faults during a flight lands as planned, then
+ * is grounded until it has spent repair_hours in one of the maintenance bays
+ * of its charger site, queueing first-come first-served when all are busy.
+ */
+struct MaintenanceProfile {
+    bool enabled = false;
+    int bays = 1;  // Per charger site
+    double repair_hours = 0.5;
+};
+
+/**
+ * Struct EnergyProfile : Electricity prices and site power limits for the event engine.
+ *
+ * When enabled, every charging session is metered: its energy is priced at
+ * hourly_price (per kWh, one entry per hour of the window, repeating) and
+ * its mean draw is added to its site's load profile in buckets of
+ * bucket_hours. With site_power_kw set, a vehicle that got a charger only
+ * starts charging once the peak draws of the sessions at its site leave room
+ * for its own, waiting plugged in first-come first-served otherwise.
+ */
+struct EnergyProfile {
+    bool enabled = false;
+    std::vector<double> hourly_price;  // Price per kWh; empty = free
+    double site_power_kw = 0;  // Charging power cap per charger site; 0 = none
+    double bucket_hours = 0.25;  // Resolution of the load profile
+};
+
+/**
+ * Struct ShiftProfile : Back-to-back shifts with battery wear for the event engine.
+ *
+ * The scenario runs count consecutive windows of horizon_hours each. Vehicles
+ * keep their charge, vertiport and pending repairs from one shift to the next
+ * (an unfinished repair starts over), or start full with overnight_charge.
+ * After every shift a battery loses fade_per_cycle of its new capacity per
+ * equivalent full cycle charged, down to min_capacity; a faded battery holds
+ * less range and fills proportionally sooner.
+ */
+struct ShiftProfile {
+    int count = 1;
+    bool overnight_charge = false;  // Vehicles start every shift after the first fully charged
+    double fade_per_cycle = 0;  // Fraction of new capacity lost per full cycle
+    double min_capacity = 0.5;  // Fraction of new capacity fading stops at
+};
+
+/**
+ * Struct Scenario : Describes one simulation run.
+ *
+ * The defaults reproduce the original problem: 20 vehicles drawn from the
+ * manufacturer table, 3 chargers and a 3-hour window.
+ */
+struct Scenario {
+    int vehicle_count = 20;
+    int chargers = 3;
+    double horizon_hours = 3.0;
+    unsigned int seed = 0;  // 0 draws a fresh seed from std::random_device
+    std::vector<EVTOL_Spec> specs = manufacturers;  // Specs vehicles are drawn from
+
+    // Charging policy of the event engine (SimulationContext)
+    bool charge_to_need = false;  // Charge only as much as needed to fly until the horizon
+    bool preemption = false;  // Let a depleted vehicle take over a charger from a nearly full one
+    double preempt_soc = 0.8;  // State of charge at which a charging vehicle may be preempted
+    bool reservations = false;  // Book a charger slot at takeoff instead of queueing on arrival
+
+    // Resolution of the charger occupancy timelines, in hours per slot; 0 turns them off (event engine only)
+    double occupancy_slot_hours = 1.0 / 60;
+
+    // Derivatives of passenger miles and charge time by perturbation analysis (event engine only)
+    bool sensitivities = false;
+
+    // Points kept per fleet time series; 0 turns the series off (event engine only)
+    int series_points = 0;
+
+    // Heterogeneous chargers at every charger site, replacing Scenario::chargers
+    // and Vertiport::chargers when set (event engine only)
+    std::vector<ChargerClass> charger_classes;
+
+    // Trip-based operations instead of flying until empty (event engine only)
+    MissionProfile missions;
+
+    // Demand-driven dispatch over a vertiport network (event engine only)
+    DemandProfile demand;
+
+    // Faults ground vehicles at maintenance bays (event engine only)
+    MaintenanceProfile maintenance;
+
+    // Energy cost, site load and power cap (event engine only)
+    EnergyProfile energy;
+
+    // Consecutive shifts with battery capacity fade (event engine only)
+    ShiftProfile shifts;
+
+    // Optional fixed fleet mix: vehicle count per entry of specs. When set it
+    // replaces the random draw and vehicle_count is taken as its sum.
+    std::vector<int> fleet_mix;
+
+    // Number of vehicles the scenario deploys.
+    int fleetSize() const;
+};
+
+/**
+ * Struct VehicleStats : Final statistics of one vehicle after a run.
+ */
+struct VehicleStats {
+    int vehicle_id;
+    std::string company;
+    double flight_time;  // hours
+    double distance;  // miles
+    double charge_time;  // hours
+    int faults;
+    double passenger_miles;
+};
+
+/**
+ * Class SimulationClock : Source of simulated time for the charging process.
+ *
+ * Vehicles never call sleep_for directly; they ask the clock to advance by a
+ * number of simulated hours. Injecting the clock lets tests run the full
+ * flight/charge cycle without waiting on the wall clock.
+ */
+class SimulationClock {
+public:
+    virtual ~SimulationClock() = default;
+
+    // Advances simulated time by the given number of hours.
+    virtual void advance(double hours) = 0;
+};
+
+/**
+ * Class RealTimeClock : Maps each simulated hour onto wall-clock time.
+ *
+ * This is the original behaviour of the simulation (1 hour = 1000 ms).
+ */
+class RealTimeClock : public SimulationClock {
+public:
+    explicit RealTimeClock(int ms_per_hour = 1000) : ms_per_hour(ms_per_hour) {}
+
+    void advance(double hours) override;
+
+private:
+    int ms_per_hour;
+};
+
+/**
+ * Class VirtualClock : Advances instantly and records the elapsed simulated time.
+ */
+class VirtualClock : public SimulationClock {
+public:
+    void advance(double hours) override;
+    double elapsed() const;
+
+private:
+    mutable std::mutex clock_mutex;
+    double elapsed_hours = 0;
+};
+
+/**
+ * Class ChargingScheduler : Owns the chargers and the charging queue.
+ *
+ * Each SimulationManager (or test) gets its own scheduler instance, so no
+ * charging state is shared between independent simulations.
+ */
+class ChargingScheduler {
+public:
+    explicit ChargingScheduler(int chargers = 3,
+                               std::chrono::milliseconds wait_timeout = std::chrono::milliseconds(100))
+        : available_chargers(chargers), wait_timeout(wait_timeout) {}
+
+    ChargingScheduler(const ChargingScheduler &) = delete;
+    ChargingScheduler &operator=(const ChargingScheduler &) = delete;
+
+    // Adds a vehicle to the charging queue.
+    void enqueue(double remaining_time, int vehicle_id);
+
+    /**
+     * Waits for a free charger and the vehicle's turn in the queue.
+     * returns True if the vehicle took a charger, false if the wait timed out.
+     */
+    bool acquire(int vehicle_id);
+
+    // Returns a charger to the pool and wakes waiting vehicles.
+    void release();
+
+    size_t queueSize() const;
+    int availableChargers() const;
+
+    /**
+     * Removes the highest-priority vehicle from the queue without charging it.
+     * returns True if a vehicle was removed, false if the queue was empty.
+     */
+    bool popNext(int &vehicle_id);
+
+private:
+    mutable std::mutex charger_mutex;
+    std::condition_variable charger_cv;
+    int available_chargers;
+    std::chrono::milliseconds wait_timeout;
+
+    // Charging queue (vehicles that need charging)
+    std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> chargingQueue;
+};
+
+/**
+ * Class EVTOL : Represents an electric vertical takeoff and landing (eVTOL) vehicle.
+ *
+ * This class models an individual eVTOL's flight, battery usage, and charging behavior.
+ * Each EVTOL operates within the simulation window, flying until its battery depletes,
+ * then queuing for charging.
+ */
+class EVTOL {
+public:
+    EVTOL_Spec spec;
+    int vehicle_id;
+    double total_flight_time = 0;
+    double total_distance_traveled = 0;
+    double total_charge_time = 0;
+    int total_faults = 0;
+    double total_passenger_miles = 0;
+    double horizon;  // Length of the simulation window in hours
+    double simulation_time;  // Time left in the simulation window
+    unsigned int seed = 0;  // Fault RNG seed, 0 draws one from std::random_device
+
+    EVTOL(EVTOL_Spec spec, int id, ChargingScheduler &scheduler, SimulationClock &clock, double horizon = 3.0)
+        : spec(spec), vehicle_id(id), horizon(horizon), simulation_time(horizon),
+          scheduler(&scheduler), clock(&clock) {}
+
+    /**
+     * Simulates EVTOL behavior within the window, including flight and charging.
+     */
+    void runFlightCycle();
+
+    // Adds the EVTOL to the charging queue.
+    void queueForCharging();
+
+    /**
+     * Simulates the charging process.
+     * returns True if charging was successful, false otherwise.
+     */
+    bool charge();
+
+    void run() { runFlightCycle(); }
+
+    // Returns a snapshot of this vehicle's statistics.
+    VehicleStats stats() const;
+
+    /**
+     * Prints the statistics of the EVTOL's flight and charging performance.
+     */
+    void printStats() const;
+
+private:
+    ChargingScheduler *scheduler;
+    SimulationClock *clock;
+};
+
+/**
+ * Class SimulationManager : Manages simulation execution for multiple EVTOLs.
+ */
+class SimulationManager {
+public:
+    std::vector<EVTOL> vehicles;
+
+    // Runs the default scenario against the wall clock, as the command-line simulation does.
+    SimulationManager();
+
+    // Runs the default scenario against an injected clock, e.g. a VirtualClock in tests.
+    explicit SimulationManager(SimulationClock &clock, int chargers = 3);
+
+    // Runs the given scenario against an injected clock.
+    SimulationManager(const Scenario &scenario, SimulationClock &clock);
+
+    SimulationManager(const SimulationManager &) = delete;
+    SimulationManager &operator=(const SimulationManager &) = delete;
+
+    // Deploys the scenario's vehicles, each drawn at random from its spec table.
+    void deployVehicles();
+
+    // Starts the simulation by launching threads for each EVTOL.
+    void startSimulation();
+
+    // Returns the statistics of every deployed vehicle.
+    std::vector<VehicleStats> results() const;
+
+    // Prints simulation results.
+    void printResults() const;
+
+    const Scenario &scenario() const { return config; }
+
+private:
+    Scenario config;
+    RealTimeClock real_clock;
+    SimulationClock *clock;
+    ChargingScheduler scheduler;
+};
+
+#endif // EVTOLSIMULATION_H
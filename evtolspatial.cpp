@@ -0,0 +1,90 @@
+/**
+ * File: evtolspatial.cpp
+ * Grid construction and point lookups for VertiportGrid.
+ */
+
+#include "evtolspatial.h"
+
+#include <limits>
+
+void VertiportGrid::build(const std::vector<Vertiport> &vertiports, double cell_size) {
+    ports = vertiports;
+    size_t n = ports.size();
+    site_cell.assign(n, 0);
+    if (n == 0) {
+        columns = rows = 0;
+        cell_start.assign(1, 0);
+        cell_sites.clear();
+        cell_idle.clear();
+        return;
+    }
+
+    double max_x = ports[0].x, max_y = ports[0].y;
+    min_x = ports[0].x;
+    min_y = ports[0].y;
+    for (const Vertiport &port : ports) {
+        min_x = std::min(min_x, port.x);
+        min_y = std::min(min_y, port.y);
+        max_x = std::max(max_x, port.x);
+        max_y = std::max(max_y, port.y);
+    }
+
+    // About one vertiport per cell unless a size is given
+    double extent = std::max(max_x - min_x, max_y - min_y);
+    cell = cell_size > 0 ? cell_size : std::max(extent / std::ceil(std::sqrt(static_cast<double>(n))), 1e-6);
+    columns = static_cast<int>((max_x - min_x) / cell) + 1;
+    rows = static_cast<int>((max_y - min_y) / cell) + 1;
+
+    // Counting sort of the sites into cells
+    size_t cells = static_cast<size_t>(columns) * rows;
+    cell_start.assign(cells + 1, 0);
+    for (size_t s = 0; s < n; s++) {
+        site_cell[s] = cellRow(ports[s].y) * columns + cellColumn(ports[s].x);
+        cell_start[site_cell[s] + 1]++;
+    }
+    for (size_t c = 0; c < cells; c++) cell_start[c + 1] += cell_start[c];
+    cell_sites.resize(n);
+    std::vector<int> fill(cell_start.begin(), cell_start.end() - 1);
+    for (size_t s = 0; s < n; s++) cell_sites[fill[site_cell[s]]++] = static_cast<int>(s);
+
+    cell_idle.assign(cells, 0);
+}
+
+int VertiportGrid::nearest(double x, double y) const {
+    if (ports.empty()) return -1;
+
+    // Ring search over all cells, ignoring idle counts
+    int cx = cellColumn(x), cy = cellRow(y);
+    int best = -1;
+    double best_miles = std::numeric_limits<double>::infinity();
+    int max_ring = std::max(columns, rows);
+
+    for (int ring = 0; ring <= max_ring; ring++) {
+        if (ring > 0 && (ring - 1) * cell > best_miles) break;
+        for (int row = std::max(cy - ring, 0); row <= std::min(cy + ring, rows - 1); row++) {
+            for (int col = std::max(cx - ring, 0); col <= std::min(cx + ring, columns - 1); col++) {
+                if (std::max(std::abs(row - cy), std::abs(col - cx)) != ring) continue;
+                int c = row * columns + col;
+                for (int i = cell_start[c]; i < cell_start[c + 1]; i++) {
+                    int site = cell_sites[i];
+                    double miles = std::hypot(ports[site].x - x, ports[site].y - y);
+                    if (miles < best_miles) {
+                        best = site;
+                        best_miles = miles;
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
+int VertiportGrid::cellColumn(double x) const {
+    int col = static_cast<int>(std::floor((x - min_x) / cell));
+    return std::min(std::max(col, 0), columns - 1);
+}
+
+int VertiportGrid::cellRow(double y) const {
+    int row = static_cast<int>(std::floor((y - min_y) / cell));
+    return std::min(std::max(row, 0), rows - 1);
+}
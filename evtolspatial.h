@@ -0,0 +1,90 @@
+/**
+ * File: evtolspatial.h
+ * Uniform-grid spatial index over vertiports and the idle vehicles at them.
+ *
+ * Vertiports are bucketed into square cells once per scenario. Each cell
+ * also keeps a count of the idle vehicles at its vertiports, updated on every
+ * flight start and end, so nearest-neighbour searches skip empty cells and
+ * never scan the fleet.
+ */
+
+#ifndef EVTOLSPATIAL_H
+#define EVTOLSPATIAL_H
+
+#include "evtolsimulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * Class VertiportGrid : Cells of vertiports with per-cell idle vehicle counts.
+ */
+class VertiportGrid {
+public:
+    // Buckets the vertiports; cell_size 0 picks about one vertiport per cell.
+    void build(const std::vector<Vertiport> &vertiports, double cell_size = 0);
+
+    // Nearest vertiport to a point, or -1 without vertiports.
+    int nearest(double x, double y) const;
+
+    // Records idle vehicles arriving at (delta > 0) or leaving (delta < 0) a vertiport.
+    void addIdle(int site, int delta) { cell_idle[site_cell[site]] += delta; }
+
+    /**
+     * Finds the vertiport nearest to a point, within max_miles, that has idle
+     * vehicles and satisfies accept(site, miles). Cells are searched in rings
+     * of increasing distance, and the search stops once no closer site can exist.
+     * returns The site, or -1 if none qualifies.
+     */
+    template <typename Accept>
+    int nearestIdle(double x, double y, double max_miles, Accept accept) const;
+
+private:
+    int cellColumn(double x) const;
+    int cellRow(double y) const;
+
+    std::vector<Vertiport> ports;
+    double min_x = 0, min_y = 0, cell = 1;
+    int columns = 0, rows = 0;
+    std::vector<int> cell_start;  // Sites of cell c are cell_sites[cell_start[c] .. cell_start[c + 1])
+    std::vector<int> cell_sites;
+    std::vector<int> site_cell;
+    std::vector<int> cell_idle;  // Idle vehicles per cell
+};
+
+template <typename Accept>
+int VertiportGrid::nearestIdle(double x, double y, double max_miles, Accept accept) const {
+    if (ports.empty()) return -1;
+    int cx = cellColumn(x), cy = cellRow(y);
+    int best = -1;
+    double best_miles = max_miles;
+    int max_ring = std::max(columns, rows);
+
+    for (int ring = 0; ring <= max_ring; ring++) {
+        // Every site in this ring is at least (ring - 1) cells away
+        if (ring > 0 && (ring - 1) * cell > best_miles) break;
+
+        for (int row = cy - ring; row <= cy + ring; row++) {
+            if (row < 0 || row >= rows) continue;
+            bool edge_row = row == cy - ring || row == cy + ring;
+            int step = edge_row ? 1 : 2 * ring;
+            for (int col = cx - ring; col <= cx + ring; col += std::max(step, 1)) {
+                if (col < 0 || col >= columns) continue;
+                int c = row * columns + col;
+                if (cell_idle[c] <= 0) continue;
+                for (int i = cell_start[c]; i < cell_start[c + 1]; i++) {
+                    int site = cell_sites[i];
+                    double miles = std::hypot(ports[site].x - x, ports[site].y - y);
+                    if (miles > best_miles || (miles == best_miles && best >= 0 && site > best)) continue;
+                    if (!accept(site, miles)) continue;
+                    best = site;
+                    best_miles = miles;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+#endif // EVTOLSPATIAL_H
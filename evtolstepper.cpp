@@ -0,0 +1,279 @@
+/**
+ * File: evtolstepper.cpp
+ * Scalar, AVX2 and AVX-512 step kernels and the fixed-step driver.
+ */
+
+#include "evtolstepper.h"
+#include "evtolfidelity.h"
+
+#include <algorithm>
+#include <random>
+
+#ifdef EVTOL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const double kFlying = 0.0;
+const double kWaiting = 1.0;
+const double kCharging = 2.0;
+
+// Lanes per AVX-512 register; the columns are padded to a multiple of it
+const size_t kLaneBlock = 8;
+
+// Upper bound on the steps of one run
+const double kMaxSteps = 1e9;
+
+/**
+ * Struct StepLanes : The columns a kernel works on.
+ */
+struct StepLanes {
+    double *phase;
+    double *left;
+    const double *range;
+    const double *speed;
+    const double *pax_rate;
+    size_t count;  // A multiple of kLaneBlock
+};
+
+/**
+ * Struct StepSums : Fleet totals accumulated by the kernels.
+ */
+struct StepSums {
+    double flight = 0;
+    double distance = 0;
+    double charge = 0;
+    double passenger_miles = 0;
+};
+
+/**
+ * Advances every lane by dt, appends the vehicles that ran empty to depleted
+ * and returns how many finished charging. The vector kernels below compute
+ * exactly these per-lane operations, so the fleet evolves identically.
+ */
+using StepFunction = size_t (*)(const StepLanes &lanes, double dt, StepSums &sums, std::vector<int> &depleted);
+
+size_t stepScalar(const StepLanes &lanes, double dt, StepSums &sums, std::vector<int> &depleted) {
+    size_t charged = 0;
+    for (size_t i = 0; i < lanes.count; i++) {
+        double phase = lanes.phase[i];
+        bool flying = phase == kFlying;
+        bool charging = phase == kCharging;
+        double left = lanes.left[i];
+        double step = flying || charging ? std::min(dt, left) : 0.0;
+        double flown = flying ? step : 0.0;
+        sums.flight += flown;
+        sums.distance += flown * lanes.speed[i];
+        sums.passenger_miles += flown * lanes.pax_rate[i];
+        sums.charge += charging ? step : 0.0;
+
+        double rest = left - step;
+        bool done = (flying || charging) && rest <= 0;
+        if (done && flying) {
+            lanes.phase[i] = kWaiting;
+            depleted.push_back(static_cast<int>(i));
+        } else if (done) {
+            lanes.phase[i] = kFlying;
+            rest = lanes.range[i];
+            charged++;
+        }
+        lanes.left[i] = rest;
+    }
+    return charged;
+}
+
+#ifdef EVTOL_X86_KERNELS
+
+// Adds a kernel's per-lane accumulators, stored flight, distance, charge, passenger miles.
+void addLanes(const double *out, size_t width, StepSums &sums) {
+    double *totals[] = {&sums.flight, &sums.distance, &sums.charge, &sums.passenger_miles};
+    for (size_t k = 0; k < 4; k++) {
+        for (size_t lane = 0; lane < width; lane++) *totals[k] += out[k * width + lane];
+    }
+}
+
+__attribute__((target("avx2"))) size_t stepAvx2(const StepLanes &lanes, double dt, StepSums &sums,
+                                                 std::vector<int> &depleted) {
+    const __m256d flying = _mm256_set1_pd(kFlying), waiting = _mm256_set1_pd(kWaiting);
+    const __m256d charging = _mm256_set1_pd(kCharging), zero = _mm256_setzero_pd(), step_hours = _mm256_set1_pd(dt);
+    __m256d flight = zero, distance = zero, charge = zero, pax = zero;
+    size_t charged = 0;
+
+    for (size_t i = 0; i < lanes.count; i += 4) {
+        __m256d phase = _mm256_load_pd(lanes.phase + i);
+        __m256d left = _mm256_load_pd(lanes.left + i);
+        __m256d is_flying = _mm256_cmp_pd(phase, flying, _CMP_EQ_OQ);
+        __m256d is_charging = _mm256_cmp_pd(phase, charging, _CMP_EQ_OQ);
+        __m256d active = _mm256_or_pd(is_flying, is_charging);
+
+        __m256d step = _mm256_and_pd(active, _mm256_min_pd(left, step_hours));
+        __m256d flown = _mm256_and_pd(is_flying, step);
+        flight = _mm256_add_pd(flight, flown);
+        distance = _mm256_add_pd(distance, _mm256_mul_pd(flown, _mm256_load_pd(lanes.speed + i)));
+        pax = _mm256_add_pd(pax, _mm256_mul_pd(flown, _mm256_load_pd(lanes.pax_rate + i)));
+        charge = _mm256_add_pd(charge, _mm256_and_pd(is_charging, step));
+
+        __m256d rest = _mm256_sub_pd(left, step);
+        __m256d done = _mm256_and_pd(active, _mm256_cmp_pd(rest, zero, _CMP_LE_OQ));
+        __m256d emptied = _mm256_and_pd(done, is_flying);
+        __m256d filled = _mm256_and_pd(done, is_charging);
+        phase = _mm256_blendv_pd(phase, waiting, emptied);
+        phase = _mm256_blendv_pd(phase, flying, filled);
+        rest = _mm256_blendv_pd(rest, _mm256_load_pd(lanes.range + i), filled);
+        _mm256_store_pd(lanes.phase + i, phase);
+        _mm256_store_pd(lanes.left + i, rest);
+
+        // Phase changes are rare: a bit test per register, a loop only when one happened
+        int emptied_bits = _mm256_movemask_pd(emptied);
+        for (; emptied_bits; emptied_bits &= emptied_bits - 1) {
+            depleted.push_back(static_cast<int>(i) + __builtin_ctz(emptied_bits));
+        }
+        charged += __builtin_popcount(_mm256_movemask_pd(filled));
+    }
+
+    alignas(32) double out[4 * 4];
+    _mm256_store_pd(out, flight);
+    _mm256_store_pd(out + 4, distance);
+    _mm256_store_pd(out + 8, charge);
+    _mm256_store_pd(out + 12, pax);
+    addLanes(out, 4, sums);
+    return charged;
+}
+
+__attribute__((target("avx512f"))) size_t stepAvx512(const StepLanes &lanes, double dt, StepSums &sums,
+                                                      std::vector<int> &depleted) {
+    const __m512d flying = _mm512_set1_pd(kFlying), waiting = _mm512_set1_pd(kWaiting);
+    const __m512d charging = _mm512_set1_pd(kCharging), zero = _mm512_setzero_pd(), step_hours = _mm512_set1_pd(dt);
+    __m512d flight = zero, distance = zero, charge = zero, pax = zero;
+    size_t charged = 0;
+
+    for (size_t i = 0; i < lanes.count; i += 8) {
+        __m512d phase = _mm512_load_pd(lanes.phase + i);
+        __m512d left = _mm512_load_pd(lanes.left + i);
+        __mmask8 is_flying = _mm512_cmp_pd_mask(phase, flying, _CMP_EQ_OQ);
+        __mmask8 is_charging = _mm512_cmp_pd_mask(phase, charging, _CMP_EQ_OQ);
+        __mmask8 active = is_flying | is_charging;
+
+        // Masked forms with an explicit source keep GCC quiet about undefined registers under LTO
+        __m512d step = _mm512_mask_min_pd(zero, active, left, step_hours);
+        __m512d flown = _mm512_mask_mov_pd(zero, is_flying, step);
+        flight = _mm512_add_pd(flight, flown);
+        distance = _mm512_add_pd(distance, _mm512_mul_pd(flown, _mm512_load_pd(lanes.speed + i)));
+        pax = _mm512_add_pd(pax, _mm512_mul_pd(flown, _mm512_load_pd(lanes.pax_rate + i)));
+        charge = _mm512_add_pd(charge, _mm512_mask_mov_pd(zero, is_charging, step));
+
+        __m512d rest = _mm512_sub_pd(left, step);
+        __mmask8 done = _mm512_mask_cmp_pd_mask(active, rest, zero, _CMP_LE_OQ);
+        __mmask8 emptied = done & is_flying;
+        __mmask8 filled = done & is_charging;
+        phase = _mm512_mask_mov_pd(phase, emptied, waiting);
+        phase = _mm512_mask_mov_pd(phase, filled, flying);
+        rest = _mm512_mask_mov_pd(rest, filled, _mm512_load_pd(lanes.range + i));
+        _mm512_store_pd(lanes.phase + i, phase);
+        _mm512_store_pd(lanes.left + i, rest);
+
+        for (unsigned int bits = emptied; bits; bits &= bits - 1) {
+            depleted.push_back(static_cast<int>(i) + __builtin_ctz(bits));
+        }
+        charged += __builtin_popcount(filled);
+    }
+
+    alignas(64) double out[8 * 4];
+    _mm512_store_pd(out, flight);
+    _mm512_store_pd(out + 8, distance);
+    _mm512_store_pd(out + 16, charge);
+    _mm512_store_pd(out + 24, pax);
+    addLanes(out, 8, sums);
+    return charged;
+}
+
+#endif // EVTOL_X86_KERNELS
+
+StepFunction kernelFunction(SimdLevel kernel) {
+#ifdef EVTOL_X86_KERNELS
+    if (kernel == SimdLevel::Avx512) return stepAvx512;
+    if (kernel == SimdLevel::Avx2) return stepAvx2;
+#endif
+    (void)kernel;
+    return stepScalar;
+}
+
+} // namespace
+
+SteppedContext::SteppedContext(SimdLevel kernel) : active_kernel(resolveSimdLevel(kernel)), draws(kernel) {}
+
+bool SteppedContext::run(const Scenario &scenario, double step_hours, std::string &error) {
+    if (!(step_hours > 0) || scenario.horizon_hours / step_hours > kMaxSteps) {
+        error = "the step must be positive and give at most 10^9 steps";
+        return false;
+    }
+    if (!fidelityCovers(scenario)) {
+        error = "the stepper covers flying until empty with first-come first-served chargers over one shift";
+        return false;
+    }
+
+    // Deploy: the fixed mix in order, or a uniform draw per vehicle
+    int vehicles = scenario.fleetSize();
+    size_t lanes_used = (static_cast<size_t>(vehicles) + kLaneBlock - 1) / kLaneBlock * kLaneBlock;
+    phase.assign(lanes_used, kWaiting); // Padding lanes wait forever and never join the queue
+    left.assign(lanes_used, 0.0);
+    range.assign(lanes_used, 0.0);
+    recharge.assign(lanes_used, 0.0);
+    speed.assign(lanes_used, 0.0);
+    pax_rate.assign(lanes_used, 0.0);
+
+    draws.seed(scenario.seed != 0 ? scenario.seed : std::random_device{}());
+    int specs = static_cast<int>(scenario.specs.size());
+    size_t mix_spec = 0;
+    int mix_left = scenario.fleet_mix.empty() ? 0 : scenario.fleet_mix[0];
+    for (int v = 0; v < vehicles; v++) {
+        int s;
+        if (scenario.fleet_mix.empty()) {
+            s = draws.index(specs);
+        } else {
+            while (mix_left == 0) mix_left = scenario.fleet_mix[++mix_spec];
+            s = static_cast<int>(mix_spec);
+            mix_left--;
+        }
+        const EVTOL_Spec &spec = scenario.specs[s];
+        double per_hour = spec.energy_use * spec.cruise_speed;
+        phase[v] = kFlying;
+        range[v] = per_hour > 0 ? spec.battery_capacity / per_hour : 0.0;
+        left[v] = range[v];
+        recharge[v] = spec.charge_time;
+        speed[v] = spec.cruise_speed;
+        pax_rate[v] = spec.passenger_count * spec.cruise_speed;
+    }
+
+    StepLanes lanes{phase.data(), left.data(), range.data(), speed.data(), pax_rate.data(), lanes_used};
+    StepFunction step = kernelFunction(active_kernel);
+    StepSums sums;
+    totals = SteppedStats();
+    totals.vehicles = vehicles;
+    waiting.clear();
+    int free_chargers = std::max(scenario.chargers, 0);
+
+    // Step k covers [k * step, (k + 1) * step), the last one cut at the horizon
+    double now = 0;
+    while (now < scenario.horizon_hours) {
+        double next = std::min((totals.steps + 1) * step_hours, scenario.horizon_hours);
+        depleted.clear();
+        free_chargers += static_cast<int>(step(lanes, next - now, sums, depleted));
+        waiting.insert(waiting.end(), depleted.begin(), depleted.end());
+        for (; free_chargers > 0 && !waiting.empty(); free_chargers--, totals.charges++) {
+            int v = waiting.front();
+            waiting.pop_front();
+            phase[v] = kCharging;
+            left[v] = recharge[v];
+        }
+        now = next;
+        totals.steps++;
+    }
+
+    totals.flight_time = sums.flight;
+    totals.distance = sums.distance;
+    totals.charge_time = sums.charge;
+    totals.passenger_miles = sums.passenger_miles;
+    return true;
+}
@@ -0,0 +1,272 @@
+/**
+ * File: evtolsurrogate.cpp
+ * Quadratic least-squares fits, estimates and model files.
+ */
+
+#include "evtolsurrogate.h"
+#include "evtolcache.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+const char *const kModelHeader = "evtolsurrogate 1";
+
+// Upper bound on a model file's outputs, against corrupt counts
+const size_t kMaxOutputs = 1024;
+
+// Writes a double so that it reads back bit-for-bit.
+void writeExact(std::ostream &out, double value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%a", value);
+    out << buffer;
+}
+
+bool readExact(std::istream &in, double &value) {
+    std::string text;
+    if (!(in >> text)) return false;
+    char *end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return *end == '\0';
+}
+
+std::string keyOf(const Scenario &scenario) {
+    Scenario unseeded = scenario;
+    unseeded.seed = 0;
+    return canonicalScenarioKey(unseeded);
+}
+
+// Fills the quadratic's terms at a point; factors are scaled to [-1, 1] over their ranges.
+void termsAt(const std::vector<SweepParameter> &parameters, const double *factors, double *terms) {
+    size_t dims = parameters.size();
+    double *x = terms + 1;
+    terms[0] = 1.0;
+    for (size_t p = 0; p < dims; p++) {
+        double range = parameters[p].high - parameters[p].low;
+        x[p] = range > 0 ? 2 * (factors[p] - parameters[p].low) / range - 1 : 0.0;
+    }
+    double *square = x + dims;
+    for (size_t p = 0; p < dims; p++) {
+        for (size_t q = p; q < dims; q++) *square++ = x[p] * x[q];
+    }
+}
+
+/**
+ * Inverts a symmetric positive definite matrix in place through its Cholesky
+ * factor L: A^-1 = L^-T L^-1.
+ * returns False if the matrix is not positive definite.
+ */
+bool invertSymmetric(std::vector<double> &a, size_t n) {
+    std::vector<double> l(n * n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            double sum = a[i * n + j];
+            for (size_t k = 0; k < j; k++) sum -= l[i * n + k] * l[j * n + k];
+            if (i == j) {
+                if (!(sum > 0)) return false;
+                l[i * n + i] = std::sqrt(sum);
+            } else {
+                l[i * n + j] = sum / l[j * n + j];
+            }
+        }
+    }
+
+    // L^-1, lower triangular, by forward substitution
+    std::vector<double> inv(n * n, 0.0);
+    for (size_t j = 0; j < n; j++) {
+        inv[j * n + j] = 1.0 / l[j * n + j];
+        for (size_t i = j + 1; i < n; i++) {
+            double sum = 0;
+            for (size_t k = j; k < i; k++) sum -= l[i * n + k] * inv[k * n + j];
+            inv[i * n + j] = sum / l[i * n + i];
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j <= i; j++) {
+            double sum = 0;
+            for (size_t k = i; k < n; k++) sum += inv[k * n + i] * inv[k * n + j];
+            a[i * n + j] = a[j * n + i] = sum;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+size_t SurrogateModel::terms() const {
+    size_t dims = parameters.size();
+    return 1 + dims + dims * (dims + 1) / 2;
+}
+
+bool fitSurrogate(const Scenario &base, const SweepPlan &plan, const SweepTable &table, SurrogateModel &model,
+                  std::string &error) {
+    model = SurrogateModel();
+    model.base_key = keyOf(base);
+    model.parameters = plan.parameters;
+    size_t dims = plan.parameters.size();
+    size_t terms = model.terms();
+    size_t rows = table.rows();
+    if (rows <= terms) {
+        error = "a quadratic in " + std::to_string(dims) + " parameters needs more than " + std::to_string(terms) +
+                " points";
+        return false;
+    }
+
+    // Metric columns come in mean, sd pairs after the factors
+    std::vector<size_t> columns;
+    for (size_t c = dims; c + 1 < table.columns.size(); c += 2) {
+        const std::string &name = table.columns[c];
+        model.outputs.push_back(name.substr(0, name.rfind("_mean")));
+        columns.push_back(c);
+    }
+    size_t outputs = columns.size();
+    model.points = rows;
+
+    // Normal equations X'X b = X'y for every output at once
+    std::vector<double> gram(terms * terms, 0.0);
+    std::vector<double> moments(terms * outputs, 0.0);
+    std::vector<double> t(terms);
+    for (size_t r = 0; r < rows; r++) {
+        const double *row = table.row(r);
+        termsAt(model.parameters, row, t.data());
+        for (size_t i = 0; i < terms; i++) {
+            for (size_t j = 0; j <= i; j++) gram[i * terms + j] += t[i] * t[j];
+            for (size_t o = 0; o < outputs; o++) moments[i * outputs + o] += t[i] * row[columns[o]];
+        }
+    }
+    for (size_t i = 0; i < terms; i++) {
+        for (size_t j = 0; j < i; j++) gram[j * terms + i] = gram[i * terms + j];
+    }
+
+    // A whisker of ridge keeps fixed parameters (low == high, all-zero terms) solvable
+    for (size_t i = 0; i < terms; i++) gram[i * terms + i] += 1e-9 * static_cast<double>(rows);
+    if (!invertSymmetric(gram, terms)) {
+        error = "the sweep points do not determine a quadratic";
+        return false;
+    }
+    model.inverse = gram;
+
+    model.coefficients.assign(outputs * terms, 0.0);
+    for (size_t o = 0; o < outputs; o++) {
+        for (size_t i = 0; i < terms; i++) {
+            double sum = 0;
+            for (size_t j = 0; j < terms; j++) sum += model.inverse[i * terms + j] * moments[j * outputs + o];
+            model.coefficients[o * terms + i] = sum;
+        }
+    }
+
+    std::vector<double> sse(outputs, 0.0);
+    for (size_t r = 0; r < rows; r++) {
+        const double *row = table.row(r);
+        termsAt(model.parameters, row, t.data());
+        for (size_t o = 0; o < outputs; o++) {
+            double fitted = 0;
+            for (size_t i = 0; i < terms; i++) fitted += model.coefficients[o * terms + i] * t[i];
+            double residual = row[columns[o]] - fitted;
+            sse[o] += residual * residual;
+        }
+    }
+    for (size_t o = 0; o < outputs; o++) model.residual_sd.push_back(std::sqrt(sse[o] / (rows - terms)));
+    return true;
+}
+
+bool surrogateCovers(const SurrogateModel &model, const Scenario &scenario) {
+    return keyOf(scenario) == model.base_key;
+}
+
+bool estimateSurrogate(const SurrogateModel &model, const double *factors, SurrogateEstimate &estimate) {
+    for (size_t p = 0; p < model.parameters.size(); p++) {
+        // Negated so that NaN is out of range too
+        if (!(factors[p] >= model.parameters[p].low && factors[p] <= model.parameters[p].high)) return false;
+    }
+
+    size_t terms = model.terms();
+    std::vector<double> t(terms);
+    termsAt(model.parameters, factors, t.data());
+
+    // Leverage t' (X'X)^-1 t: how far the point sits from the mass of the training points
+    double leverage = 0;
+    for (size_t i = 0; i < terms; i++) {
+        double row = 0;
+        for (size_t j = 0; j < terms; j++) row += model.inverse[i * terms + j] * t[j];
+        leverage += t[i] * row;
+    }
+
+    size_t outputs = model.outputs.size();
+    estimate.value.assign(outputs, 0.0);
+    estimate.error.resize(outputs);
+    for (size_t o = 0; o < outputs; o++) {
+        for (size_t i = 0; i < terms; i++) estimate.value[o] += model.coefficients[o * terms + i] * t[i];
+        estimate.error[o] = model.residual_sd[o] * std::sqrt(1 + leverage);
+    }
+    return true;
+}
+
+void writeSurrogate(std::ostream &out, const SurrogateModel &model) {
+    out << kModelHeader << '\n' << model.base_key << '\n';
+    out << model.parameters.size() << '\n';
+    for (const SweepParameter &parameter : model.parameters) {
+        out << specFieldName(parameter.field) << ':';
+        writeExact(out, parameter.low);
+        out << ':';
+        writeExact(out, parameter.high);
+        if (parameter.spec >= 0) out << ':' << parameter.spec;
+        out << '\n';
+    }
+    out << model.outputs.size();
+    for (const std::string &name : model.outputs) out << ' ' << name;
+    out << '\n' << model.points << '\n';
+
+    for (const std::vector<double> *values : {&model.coefficients, &model.inverse, &model.residual_sd}) {
+        for (size_t i = 0; i < values->size(); i++) {
+            if (i) out << ' ';
+            writeExact(out, (*values)[i]);
+        }
+        out << '\n';
+    }
+}
+
+bool readSurrogate(std::istream &in, SurrogateModel &model, std::string &error) {
+    model = SurrogateModel();
+    std::string header;
+    if (!std::getline(in, header) || header != kModelHeader || !std::getline(in, model.base_key)) {
+        error = "not a surrogate model";
+        return false;
+    }
+
+    size_t dims, outputs;
+    if (!(in >> dims)) {
+        error = "truncated model";
+        return false;
+    }
+    for (size_t p = 0; p < dims; p++) {
+        std::string text;
+        SweepParameter parameter;
+        if (!(in >> text)) {
+            error = "truncated model";
+            return false;
+        }
+        if (!parseSweepParameter(text, parameter, error)) return false;
+        model.parameters.push_back(parameter);
+    }
+
+    bool ok = in >> outputs && outputs <= kMaxOutputs;
+    model.outputs.resize(ok ? outputs : 0);
+    for (std::string &name : model.outputs) ok = ok && in >> name;
+    ok = ok && in >> model.points;
+
+    size_t terms = model.terms();
+    model.coefficients.resize(model.outputs.size() * terms);
+    model.inverse.resize(terms * terms);
+    model.residual_sd.resize(model.outputs.size());
+    for (std::vector<double> *values : {&model.coefficients, &model.inverse, &model.residual_sd}) {
+        for (double &value : *values) ok = ok && readExact(in, value);
+    }
+    if (!ok) {
+        error = "truncated model";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+/**
+ * File: evtolsurrogate.h
+ * Quadratic response surfaces fitted to sweep results.
+ *
+ * A surrogate answers "what would this point of the sweep give" in
+ * microseconds instead of a simulation. Each metric's replica mean is fitted
+ * by least squares as a full quadratic in the sweep factors (scaled to
+ * [-1, 1] over each parameter's range), so curvature and pairwise
+ * interactions are kept while the model stays a few dozen coefficients.
+ *
+ * Every estimate comes with an error: the residual standard deviation of
+ * the fit, widened by the point's leverage, i.e. the expected difference
+ * between the estimate and a fresh simulation of the point with the sweep's
+ * replica count. It covers replica noise and lack of fit near the sweep's
+ * points, but not behaviour the sweep never saw, so a surrogate only answers
+ * inside the ranges it was trained on and for the scenario it was trained
+ * around; everything else goes back to the simulator.
+ */
+
+#ifndef EVTOLSURROGATE_H
+#define EVTOLSURROGATE_H
+
+#include "evtolsweep.h"
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Struct SurrogateModel : Fitted quadratic surfaces over a sweep's parameters.
+ */
+struct SurrogateModel {
+    std::string base_key;  // Canonical key of the swept scenario, seed cleared
+    std::vector<SweepParameter> parameters;
+    std::vector<std::string> outputs;  // Metric names, the sweep table's mean columns
+    size_t points = 0;  // Training points
+
+    std::vector<double> coefficients;  // Per output, one per term
+    std::vector<double> inverse;  // (X'X)^-1 over the terms, row-major
+    std::vector<double> residual_sd;  // Per output
+
+    // Terms of the quadratic: constant, linear, then squares and products.
+    size_t terms() const;
+};
+
+/**
+ * Struct SurrogateEstimate : Values and errors of every output at one point.
+ */
+struct SurrogateEstimate {
+    std::vector<double> value;
+    std::vector<double> error;
+};
+
+/**
+ * Fits a model to the table runSweep produced for base and plan.
+ * returns True on success, false with a message in error when the sweep has
+ * too few points for the number of terms.
+ */
+bool fitSurrogate(const Scenario &base, const SweepPlan &plan, const SweepTable &table, SurrogateModel &model,
+                  std::string &error);
+
+// Checks that the model was trained around scenario, seeds aside.
+bool surrogateCovers(const SurrogateModel &model, const Scenario &scenario);
+
+/**
+ * Estimates every output at one point, factors in parameter order.
+ * returns True, or false if a factor lies outside its trained range.
+ */
+bool estimateSurrogate(const SurrogateModel &model, const double *factors, SurrogateEstimate &estimate);
+
+// Writes the model as text that reads back bit-for-bit.
+void writeSurrogate(std::ostream &out, const SurrogateModel &model);
+
+/**
+ * Reads a model written by writeSurrogate.
+ * returns True on success, false with a message in error otherwise.
+ */
+bool readSurrogate(std::istream &in, SurrogateModel &model, std::string &error);
+
+#endif // EVTOLSURROGATE_H
@@ -0,0 +1,242 @@
+/**
+ * File: evtolsweep.cpp
+ * Sweep designs, point application and the blocked sweep runner.
+ */
+
+#include "evtolsweep.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+namespace {
+
+// Upper bound on the points of one sweep
+const size_t kMaxSweepPoints = 10000000;
+
+// Points handed to the pool at a time; bounds the per-replica totals held at once
+const size_t kSweepBlock = 256;
+
+const char *const kFieldNames[] = {"cruise_speed", "battery_capacity", "charge_time", "energy_use",
+                                   "fault_probability"};
+const size_t kFieldCount = sizeof(kFieldNames) / sizeof(kFieldNames[0]);
+
+bool parseNumber(const std::string &text, double &out) {
+    char *end = nullptr;
+    errno = 0;
+    out = std::strtod(text.c_str(), &end);
+    return errno == 0 && end != text.c_str() && *end == '\0';
+}
+
+double &fieldOf(EVTOL_Spec &spec, SpecField field) {
+    switch (field) {
+    case SpecField::CruiseSpeed:
+        return spec.cruise_speed;
+    case SpecField::BatteryCapacity:
+        return spec.battery_capacity;
+    case SpecField::ChargeTime:
+        return spec.charge_time;
+    case SpecField::EnergyUse:
+        return spec.energy_use;
+    case SpecField::FaultProbability:
+        break;
+    }
+    return spec.fault_probability;
+}
+
+void addStatColumns(std::vector<std::string> &columns, const std::string &name) {
+    columns.push_back(name + "_mean");
+    columns.push_back(name + "_sd");
+}
+
+void addStatCells(std::vector<double> &cells, const RunningStat &stat) {
+    cells.push_back(stat.mean());
+    cells.push_back(stat.stddev());
+}
+
+} // namespace
+
+bool parseSweepParameter(const std::string &text, SweepParameter &parameter, std::string &error) {
+    std::vector<std::string> parts;
+    std::istringstream in(text);
+    std::string part;
+    while (std::getline(in, part, ':')) parts.push_back(part);
+    if (parts.size() != 3 && parts.size() != 4) {
+        error = "expected field:low:high[:spec], got '" + text + "'";
+        return false;
+    }
+
+    const char *const *name = std::find(kFieldNames, kFieldNames + kFieldCount, parts[0]);
+    if (name == kFieldNames + kFieldCount) {
+        error = "unknown spec field '" + parts[0] + "'";
+        return false;
+    }
+    parameter.field = static_cast<SpecField>(name - kFieldNames);
+
+    // The spec index must be in int range before the cast
+    double spec = -1;
+    if (!parseNumber(parts[1], parameter.low) || !parseNumber(parts[2], parameter.high) ||
+        !std::isfinite(parameter.low) || !std::isfinite(parameter.high) ||
+        (parts.size() == 4 && (!parseNumber(parts[3], spec) || !std::isfinite(spec) || spec < 0 || spec > INT_MAX ||
+                               spec != std::floor(spec)))) {
+        error = "invalid range in '" + text + "'";
+        return false;
+    }
+    parameter.spec = static_cast<int>(spec);
+    return true;
+}
+
+bool validateSweep(const Scenario &base, const SweepPlan &plan, std::string &error) {
+    if (plan.parameters.empty()) {
+        error = "no parameters to sweep";
+        return false;
+    }
+    for (const SweepParameter &parameter : plan.parameters) {
+        if (!(parameter.low > 0) || !(parameter.high >= parameter.low)) {
+            error = "factor ranges must satisfy 0 < low <= high";
+            return false;
+        }
+        if (parameter.spec < -1 || parameter.spec >= static_cast<int>(base.specs.size())) {
+            error = "spec index out of range";
+            return false;
+        }
+    }
+    if (plan.replicas < 1) {
+        error = "replicas must be at least 1";
+        return false;
+    }
+    if ((plan.design == SweepDesign::LatinHypercube && plan.points < 1) ||
+        (plan.design == SweepDesign::Grid && plan.levels < 1)) {
+        error = "the design has no points";
+        return false;
+    }
+    if (sweepPointCount(plan) > kMaxSweepPoints) {
+        error = "too many points";
+        return false;
+    }
+    return true;
+}
+
+const char *specFieldName(SpecField field) {
+    return kFieldNames[static_cast<size_t>(field)];
+}
+
+size_t sweepPointCount(const SweepPlan &plan) {
+    if (plan.design == SweepDesign::LatinHypercube) return static_cast<size_t>(std::max(plan.points, 0));
+
+    // Saturates instead of overflowing, so oversized grids are rejected rather than wrapped
+    size_t count = 1;
+    size_t levels = static_cast<size_t>(std::max(plan.levels, 0));
+    for (size_t p = 0; p < plan.parameters.size(); p++) {
+        count = levels && count > (kMaxSweepPoints + 1) / levels ? kMaxSweepPoints + 1 : count * levels;
+    }
+    return count;
+}
+
+std::vector<double> sweepPoints(const SweepPlan &plan) {
+    size_t dims = plan.parameters.size();
+    size_t count = sweepPointCount(plan);
+    std::vector<double> factors(count * dims);
+
+    if (plan.design == SweepDesign::Grid) {
+        // Point i is i written in base levels, the first parameter varying slowest
+        size_t levels = static_cast<size_t>(plan.levels);
+        for (size_t i = 0; i < count; i++) {
+            size_t rest = i;
+            for (size_t p = dims; p-- > 0;) {
+                const SweepParameter &parameter = plan.parameters[p];
+                size_t level = rest % levels;
+                rest /= levels;
+                double x = levels > 1 ? static_cast<double>(level) / (levels - 1) : 0.5;
+                factors[i * dims + p] = parameter.low + x * (parameter.high - parameter.low);
+            }
+        }
+        return factors;
+    }
+
+    // Latin hypercube: a shuffled stratum per point and parameter, a uniform draw within it
+    std::mt19937 gen(plan.seed);
+    std::uniform_real_distribution<double> within(0.0, 1.0);
+    std::vector<size_t> strata(count);
+    for (size_t p = 0; p < dims; p++) {
+        const SweepParameter &parameter = plan.parameters[p];
+        std::iota(strata.begin(), strata.end(), 0);
+        std::shuffle(strata.begin(), strata.end(), gen);
+        for (size_t i = 0; i < count; i++) {
+            double x = (strata[i] + within(gen)) / count;
+            factors[i * dims + p] = parameter.low + x * (parameter.high - parameter.low);
+        }
+    }
+    return factors;
+}
+
+void applySweepPoint(const Scenario &base, const SweepPlan &plan, const double *factors, Scenario &out) {
+    out = base;
+    for (size_t p = 0; p < plan.parameters.size(); p++) {
+        const SweepParameter &parameter = plan.parameters[p];
+        for (size_t s = 0; s < out.specs.size(); s++) {
+            if (parameter.spec >= 0 && static_cast<size_t>(parameter.spec) != s) continue;
+            fieldOf(out.specs[s], parameter.field) *= factors[p];
+        }
+    }
+    for (EVTOL_Spec &spec : out.specs) spec.fault_probability = std::min(spec.fault_probability, 1.0);
+}
+
+bool runSweep(ReplicaPool &pool, const Scenario &base, const SweepPlan &plan, SweepTable &table, std::string &error,
+              const std::function<void(size_t, size_t)> &progress) {
+    if (!validateSweep(base, plan, error)) return false;
+
+    table.columns.clear();
+    table.cells.clear();
+    for (const SweepParameter &parameter : plan.parameters) {
+        std::string name = specFieldName(parameter.field);
+        if (parameter.spec >= 0) name += "@" + std::to_string(parameter.spec);
+        table.columns.push_back(name);
+    }
+    for (const char *metric : {"flight_time", "distance", "charge_time", "faults", "passenger_miles", "utilization"}) {
+        addStatColumns(table.columns, metric);
+    }
+
+    std::vector<double> factors = sweepPoints(plan);
+    size_t dims = plan.parameters.size();
+    size_t count = sweepPointCount(plan);
+    table.cells.reserve(count * table.columns.size());
+
+    std::vector<Scenario> block;
+    for (size_t first = 0; first < count; first += kSweepBlock) {
+        size_t last = std::min(first + kSweepBlock, count);
+        block.resize(last - first);
+        for (size_t i = first; i < last; i++) {
+            applySweepPoint(base, plan, factors.data() + i * dims, block[i - first]);
+        }
+
+        std::vector<ScenarioStats> stats = pool.runEach(block, plan.replicas);
+        for (size_t i = first; i < last; i++) {
+            const ScenarioStats &point = stats[i - first];
+            table.cells.insert(table.cells.end(), factors.begin() + i * dims, factors.begin() + (i + 1) * dims);
+            addStatCells(table.cells, point.fleet.flight_time);
+            addStatCells(table.cells, point.fleet.distance);
+            addStatCells(table.cells, point.fleet.charge_time);
+            addStatCells(table.cells, point.fleet.faults);
+            addStatCells(table.cells, point.fleet.passenger_miles);
+            addStatCells(table.cells, point.occupancy.utilization);
+        }
+        if (progress) progress(last, count);
+    }
+    return true;
+}
+
+void writeSweepTable(std::ostream &out, const SweepTable &table) {
+    for (size_t c = 0; c < table.columns.size(); c++) out << (c ? "\t" : "") << table.columns[c];
+    out << '\n';
+    for (size_t r = 0; r < table.rows(); r++) {
+        const double *row = table.row(r);
+        for (size_t c = 0; c < table.columns.size(); c++) out << (c ? "\t" : "") << row[c];
+        out << '\n';
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * File: evtolsweep.h
+ * Parameter sweeps over manufacturer specs on a warm replica pool.
+ *
+ * A sweep scales EVTOL_Spec fields of a base scenario by factors drawn from
+ * a Latin hypercube (every parameter's range cut into as many equal strata
+ * as there are points, each stratum sampled exactly once) or laid out on a
+ * full grid. Points are handed to the ReplicaPool in blocks, so every worker
+ * stays busy however few replicas a point has, and each point is reduced to
+ * one row of a results table: its factors, then the mean and standard
+ * deviation of the fleet totals over its replicas.
+ *
+ * With a non-zero seed every point runs the same replica seeds (common random
+ * numbers), so differences between rows come from the parameters rather than
+ * from the draws.
+ */
+
+#ifndef EVTOLSWEEP_H
+#define EVTOLSWEEP_H
+
+#include "evtolbatch.h"
+
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Spec fields a sweep can vary.
+enum class SpecField { CruiseSpeed, BatteryCapacity, ChargeTime, EnergyUse, FaultProbability };
+
+/**
+ * Struct SweepParameter : One swept spec field and the range of its factor.
+ *
+ * The field's value is multiplied by a factor in [low, high]. Parameters on
+ * the same field multiply together; fault probabilities are capped at 1.
+ */
+struct SweepParameter {
+    SpecField field = SpecField::CruiseSpeed;
+    double low = 1.0;
+    double high = 1.0;
+    int spec = -1;  // Index into Scenario::specs, -1 scales every spec
+};
+
+// How a sweep places its points.
+enum class SweepDesign { LatinHypercube, Grid };
+
+/**
+ * Struct SweepPlan : The parameters of a sweep, its design and its replicas.
+ */
+struct SweepPlan {
+    std::vector<SweepParameter> parameters;
+    SweepDesign design = SweepDesign::LatinHypercube;
+    int points = 100;  // Latin hypercube sample size
+    int levels = 5;  // Grid levels per parameter, ends included
+    unsigned int seed = 1;  // Latin hypercube draw
+    int replicas = 10;  // Per point
+};
+
+/**
+ * Struct SweepTable : One row per point: factors, then fleet total statistics.
+ */
+struct SweepTable {
+    std::vector<std::string> columns;
+    std::vector<double> cells;  // Row-major
+
+    size_t rows() const { return columns.empty() ? 0 : cells.size() / columns.size(); }
+    const double *row(size_t i) const { return cells.data() + i * columns.size(); }
+};
+
+/**
+ * Parses a parameter written as field:low:high[:spec], with field one of
+ * cruise_speed, battery_capacity, charge_time, energy_use or fault_probability.
+ * returns True on success, false with a message in error otherwise.
+ */
+bool parseSweepParameter(const std::string &text, SweepParameter &parameter, std::string &error);
+
+/**
+ * Checks a plan against the scenario it sweeps.
+ * returns True if it can run, false with a message in error otherwise.
+ */
+bool validateSweep(const Scenario &base, const SweepPlan &plan, std::string &error);
+
+// Name of a parameter's field as parseSweepParameter reads it.
+const char *specFieldName(SpecField field);
+
+// Number of points the plan runs.
+size_t sweepPointCount(const SweepPlan &plan);
+
+// Factors of every point, point by point, one per parameter.
+std::vector<double> sweepPoints(const SweepPlan &plan);
+
+// The base scenario with one point's factors applied.
+void applySweepPoint(const Scenario &base, const SweepPlan &plan, const double *factors, Scenario &out);
+
+/**
+ * Runs every point of the plan and fills the table. progress, if set, is
+ * called with the points done so far after every block.
+ * returns True on success, false with a message in error for an invalid plan.
+ */
+bool runSweep(ReplicaPool &pool, const Scenario &base, const SweepPlan &plan, SweepTable &table, std::string &error,
+              const std::function<void(size_t, size_t)> &progress = nullptr);
+
+// Writes the table as tab-separated values with a header line.
+void writeSweepTable(std::ostream &out, const SweepTable &table);
+
+#endif // EVTOLSWEEP_H
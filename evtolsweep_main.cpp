@@ -0,0 +1,112 @@
+/**
+ * File: evtolsweep_main.cpp
+ * Command-line parameter sweep over manufacturer specs.
+ *
+ * Usage: evtolsweep --param FIELD:LOW:HIGH[:SPEC] [--param ...] [--design lhs|grid]
+ *                   [--points N] [--levels N] [--replicas N] [--design-seed N]
+ *                   [--workers N] [--fit FILE] [KEY=VALUE ...]
+ *
+ * Sweeps factors on the given spec fields around the scenario described by
+ * the KEY=VALUE pairs (the evtold query keys; replicas come from --replicas)
+ * and writes one tab-separated row per point to standard output. The
+ * scenario seed defaults to 1 so every point runs the same replica seeds.
+ * --fit also fits a quadratic surrogate to the rows and writes it to FILE,
+ * for evtold --surrogate.
+ */
+
+#include "evtolserver.h"
+#include "evtolsurrogate.h"
+#include "evtolsweep.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+void usage(const char *program) {
+    std::cerr << "Usage: " << program
+              << " --param FIELD:LOW:HIGH[:SPEC] [--param ...] [--design lhs|grid] [--points N] [--levels N]"
+                 " [--replicas N] [--design-seed N] [--workers N] [--fit FILE] [KEY=VALUE ...]\n";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    SweepPlan plan;
+    int workers = 0;
+    std::string keys;
+    std::string fit_path;
+    std::string error;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--param") == 0 && has_value) {
+            SweepParameter parameter;
+            if (!parseSweepParameter(argv[++i], parameter, error)) {
+                std::cerr << "evtolsweep: " << error << "\n";
+                return 1;
+            }
+            plan.parameters.push_back(parameter);
+        } else if (std::strcmp(argv[i], "--design") == 0 && has_value) {
+            std::string design = argv[++i];
+            if (design != "lhs" && design != "grid") {
+                usage(argv[0]);
+                return 1;
+            }
+            plan.design = design == "grid" ? SweepDesign::Grid : SweepDesign::LatinHypercube;
+        } else if (std::strcmp(argv[i], "--points") == 0 && has_value) {
+            plan.points = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--levels") == 0 && has_value) {
+            plan.levels = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--replicas") == 0 && has_value) {
+            plan.replicas = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--design-seed") == 0 && has_value) {
+            plan.seed = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--workers") == 0 && has_value) {
+            workers = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--fit") == 0 && has_value) {
+            fit_path = argv[++i];
+        } else if (std::strchr(argv[i], '=') && argv[i][0] != '-') {
+            keys += std::string(keys.empty() ? "" : " ") + argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    ScenarioQuery query;
+    query.scenario.seed = 1;
+    if (!parseQuery(keys, query, error) || !validateSweep(query.scenario, plan, error)) {
+        std::cerr << "evtolsweep: " << error << "\n";
+        return 1;
+    }
+
+    ReplicaPool pool(workers);
+    SweepTable table;
+    bool ok = runSweep(pool, query.scenario, plan, table, error, [](size_t done, size_t total) {
+        std::cerr << "evtolsweep: " << done << "/" << total << " points\r" << std::flush;
+    });
+    std::cerr << "\n";
+    if (!ok) {
+        std::cerr << "evtolsweep: " << error << "\n";
+        return 1;
+    }
+    writeSweepTable(std::cout, table);
+
+    if (!fit_path.empty()) {
+        SurrogateModel model;
+        if (!fitSurrogate(query.scenario, plan, table, model, error)) {
+            std::cerr << "evtolsweep: " << error << "\n";
+            return 1;
+        }
+        std::ofstream out(fit_path);
+        writeSurrogate(out, model);
+        if (!out) {
+            std::cerr << "evtolsweep: cannot write " << fit_path << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
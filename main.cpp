@@ -0,0 +1,17 @@
+/**
+ * File: main.cpp
+ * Command-line entry point of the eVTOL simulation.
+ *
+ * Runs the default scenario (20 vehicles, 3 chargers, 3 hours) against the
+ * wall clock and prints per-vehicle statistics.
+ */
+
+#include "evtolsimulation.h"
+
+int main() {
+    SimulationManager sim;
+    sim.deployVehicles();
+    sim.startSimulation();
+    sim.printResults();
+    return 0;
+}
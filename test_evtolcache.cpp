@@ -0,0 +1,130 @@
+/**
+ * File : test_evtolcache.cpp
+ * Unit tests for the scenario result cache.
+ *
+ * Covers canonical keys, full and partial hits, eviction and the disk tier.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolcache.h"
+ 
+ #include <cstdlib>
+ #include <string>
+ #include <unistd.h>
+ 
+ // Test that equivalent scenarios share a key and different ones do not.
+ TEST(CacheTests, CanonicalKey) {
+     Scenario a;
+     a.seed = 1;
+     a.fleet_mix = {2, 3};
+     Scenario b = a;
+     b.fleet_mix = {2, 3, 0, 0};
+     b.vehicle_count = 99; // Ignored under a fixed mix
+     EXPECT_EQ(canonicalScenarioKey(a), canonicalScenarioKey(b));
+ 
+     Scenario c = a;
+     c.specs[0].charge_time += 1e-12;
+     EXPECT_NE(canonicalScenarioKey(a), canonicalScenarioKey(c));
+     c = a;
+     c.shifts.fade_per_cycle = 0.01; // Unused with a single shift
+     EXPECT_EQ(canonicalScenarioKey(a), canonicalScenarioKey(c));
+     c.shifts.count = 2;
+     EXPECT_NE(canonicalScenarioKey(a), canonicalScenarioKey(c));
+     c = a;
+     c.occupancy_slot_hours = 0.25;
+     EXPECT_NE(canonicalScenarioKey(a), canonicalScenarioKey(c));
+     c = a;
+     c.sensitivities = true;
+     EXPECT_NE(canonicalScenarioKey(a), canonicalScenarioKey(c));
+     c = a;
+     c.seed = 2;
+     EXPECT_NE(hashKey(canonicalScenarioKey(a)), hashKey(canonicalScenarioKey(c)));
+ }
+ 
+ // Test full hits and partial hits that run only the missing replicas.
+ TEST(CacheTests, FullAndPartialHits) {
+     Scenario scenario;
+     scenario.seed = 8;
+     ReplicaPool pool(1);
+     ResultCache cache;
+ 
+     ScenarioStats first = cache.run(pool, scenario, 4);
+     ScenarioStats again = cache.run(pool, scenario, 4);
+     EXPECT_EQ(cache.misses(), 1u);
+     EXPECT_EQ(cache.hits(), 1u);
+     EXPECT_EQ(again.fleet.passenger_miles.sum, first.fleet.passenger_miles.sum);
+ 
+     ScenarioStats more = cache.run(pool, scenario, 10);
+     ScenarioStats direct = pool.run(scenario, 10);
+     EXPECT_EQ(cache.partialHits(), 1u);
+     EXPECT_EQ(more.replicas, 10u);
+     EXPECT_NEAR(more.fleet.passenger_miles.mean(), direct.fleet.passenger_miles.mean(), 1e-6);
+     EXPECT_EQ(more.events, direct.events);
+ }
+ 
+ // Test that random-seed scenarios bypass the cache and the LRU bound holds.
+ TEST(CacheTests, UnseededAndEviction) {
+     ReplicaPool pool(1);
+     ResultCache cache(2);
+ 
+     Scenario unseeded;
+     cache.run(pool, unseeded, 1);
+     EXPECT_EQ(cache.size(), 0u);
+ 
+     for (unsigned int seed = 1; seed <= 3; seed++) {
+         Scenario scenario;
+         scenario.seed = seed;
+         cache.run(pool, scenario, 1);
+     }
+     EXPECT_EQ(cache.size(), 2u);
+     ScenarioStats stats;
+     Scenario oldest;
+     oldest.seed = 1;
+     EXPECT_FALSE(cache.lookup(oldest, stats));
+ }
+ 
+ // Test that entries written to disk are found by a fresh cache.
+ TEST(CacheTests, DiskTier) {
+     char dir[] = "/tmp/evtolcacheXXXXXX";
+     ASSERT_NE(::mkdtemp(dir), nullptr);
+     Scenario scenario;
+     scenario.seed = 5;
+     scenario.maintenance.enabled = true;
+     scenario.energy.enabled = true;
+     scenario.demand.enabled = true;
+     scenario.demand.vertiports = {{0, 0, 2, 1.0}, {15, 0, 2, 1.0}};
+     scenario.demand.hourly_rate = {10.0};
+     scenario.shifts.count = 2;
+     scenario.shifts.fade_per_cycle = 0.01;
+     ReplicaPool pool(1);
+ 
+     ScenarioStats written;
+     {
+         ResultCache cache(16, dir);
+         written = cache.run(pool, scenario, 3);
+     }
+ 
+     ResultCache cold(16, dir);
+     ScenarioStats read;
+     ASSERT_TRUE(cold.lookup(scenario, read));
+     EXPECT_EQ(read.replicas, 3u);
+     EXPECT_EQ(read.fleet.passenger_miles.sum, written.fleet.passenger_miles.sum);
+     EXPECT_EQ(read.companies.size(), written.companies.size());
+     EXPECT_EQ(read.companies[2].faults.sum_sq, written.companies[2].faults.sum_sq);
+     EXPECT_EQ(read.maintenance.repairs.count, 3u);
+     EXPECT_EQ(read.maintenance.wait_hours.sum, written.maintenance.wait_hours.sum);
+     EXPECT_EQ(read.energy.peak_kw.sum_sq, written.energy.peak_kw.sum_sq);
+     EXPECT_EQ(read.demand.requests.count, 3u);
+     EXPECT_EQ(read.demand.mean_wait.sum, written.demand.mean_wait.sum);
+     EXPECT_EQ(read.shifts.passenger_miles.count, 3u);
+     EXPECT_EQ(read.shifts.min_capacity.sum_sq, written.shifts.min_capacity.sum_sq);
+ 
+     std::system((std::string("rm -rf ") + dir).c_str());
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
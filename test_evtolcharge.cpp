@@ -0,0 +1,48 @@
+/**
+ * File : test_evtolcharge.cpp
+ * Unit tests for the CC-CV charge curve tables.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolcharge.h"
+ 
+ // Test that a full charge takes exactly the spec's charge time.
+ TEST(ChargeCurveTests, FullChargeMatchesSpec) {
+     for (const EVTOL_Spec &spec : manufacturers) {
+         ChargeCurve curve(spec);
+         EXPECT_NEAR(curve.timeToCharge(0.0, 1.0), spec.charge_time, 1e-12) << spec.company;
+         EXPECT_DOUBLE_EQ(curve.socAfter(0.0, spec.charge_time), 1.0);
+     }
+ }
+ 
+ // Test that a spec without a taper charges at a constant rate.
+ TEST(ChargeCurveTests, ConstantRateWithoutTaper) {
+     EVTOL_Spec spec = manufacturers[0];
+     spec.cv_soc = 1.0;
+     ChargeCurve curve(spec);
+     EXPECT_NEAR(curve.timeToCharge(0.25, 0.75), 0.5 * spec.charge_time, 1e-9);
+     EXPECT_NEAR(curve.socAfter(0.1, 0.3 * spec.charge_time), 0.4, 1e-9);
+ }
+ 
+ // Test that the taper makes the last 20% slower than the first 20%.
+ TEST(ChargeCurveTests, TaperSlowsTopOfCharge) {
+     ChargeCurve curve(manufacturers[2]); // Charlie: taper from 75% down to 10% power
+     EXPECT_GT(curve.timeToCharge(0.8, 1.0), 2.0 * curve.timeToCharge(0.0, 0.2));
+ }
+ 
+ // Test that the forward and inverse tables agree.
+ TEST(ChargeCurveTests, InverseRoundTrip) {
+     ChargeCurve curve(manufacturers[4]);
+     for (double soc = 0.05; soc < 1.0; soc += 0.1) {
+         double t = curve.timeToCharge(0.0, soc);
+         EXPECT_NEAR(curve.socAfter(0.0, t), soc, 1e-4);
+         EXPECT_NEAR(curve.socAfter(soc, curve.timeToCharge(soc, 0.99)), 0.99, 1e-4);
+     }
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,80 @@
+/**
+ * File : test_evtolchargers.cpp
+ * Unit tests for charger assignment across power and compatibility classes.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+ 
+ // Test that vehicles get the most powerful compatible charger that is free.
+ TEST(ChargerPoolTests, AcquiresBestCompatibleCharger) {
+     // Class 0: slow, any spec; class 1: fast, spec 1 only; class 2: medium, any spec
+     std::vector<ChargerClass> classes = {{2, 0.5, {}}, {1, 3.0, {1}}, {1, 1.5, {}}};
+     ChargerPool pool;
+     pool.reset(classes, 2, {2, 1, 1});
+ 
+     EXPECT_EQ(pool.acquire(0, 0), 2);
+     EXPECT_EQ(pool.acquire(0, 0), 0);
+     EXPECT_EQ(pool.acquire(0, 1), 1);
+     EXPECT_EQ(pool.acquire(0, 1), 0);
+     EXPECT_EQ(pool.acquire(0, 0), -1);
+     EXPECT_EQ(pool.freeChargers(0, 0), 0);
+ 
+     pool.release(0, 1);
+     EXPECT_EQ(pool.acquire(0, 0), -1); // The fast charger does not fit spec 0
+     EXPECT_EQ(pool.acquire(0, 1), 1);
+ }
+ 
+ // Test that a released charger goes to the longest-waiting vehicle it fits.
+ TEST(ChargerPoolTests, ReleaseServesLongestCompatibleWait) {
+     std::vector<ChargerClass> classes = {{1, 1.0, {0}}, {1, 2.0, {}}};
+     ChargerPool pool;
+     pool.reset(classes, 2, {1, 1, 1, 1}); // Two sites
+ 
+     EXPECT_EQ(pool.acquire(0, 0), 1);
+     EXPECT_EQ(pool.acquire(0, 0), 0);
+     pool.wait(0, 1, 10);
+     pool.wait(0, 0, 11);
+     pool.wait(0, 1, 12);
+     EXPECT_EQ(pool.acquire(1, 1), 1); // Sites are independent
+ 
+     EXPECT_EQ(pool.release(0, 0), 11); // Spec 1 cannot use class 0
+     EXPECT_EQ(pool.release(0, 1), 10);
+     EXPECT_EQ(pool.release(0, 1), 12);
+     EXPECT_EQ(pool.release(0, 1), -1);
+     EXPECT_EQ(pool.freeChargers(0, 1), 1);
+ }
+ 
+ // Test that faster chargers shorten charging and that incompatible specs never charge.
+ TEST(ChargerPoolTests, EnginePowerAndCompatibility) {
+     Scenario scenario;
+     scenario.seed = 41;
+     scenario.fleet_mix = {4, 4};
+     SimulationContext plain;
+     plain.run(scenario);
+ 
+     // Same count, twice the power, and only spec 0 may charge
+     scenario.charger_classes = {{3, 2.0, {0}}};
+     SimulationContext fast;
+     fast.run(scenario);
+ 
+     VehicleColumns a = plain.vehicles(), b = fast.vehicles();
+     double plain_alpha = 0, fast_alpha = 0;
+     for (size_t v = 0; v < b.size(); v++) {
+         if (b.spec_index[v] == 1) {
+             EXPECT_EQ(b.charge_time[v], 0.0);
+         } else {
+             plain_alpha += a.charge_time[v];
+             fast_alpha += b.charge_time[v];
+         }
+     }
+     EXPECT_GT(fast_alpha, 0.0);
+     EXPECT_LT(fast_alpha, plain_alpha);
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,104 @@
+/**
+ * File : test_evtoldemand.cpp
+ * Unit tests for demand generation, idle-vehicle matching and demand mode.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+ 
+ namespace {
+ 
+ // Three vertiports on a 20-mile triangle, one charger each.
+ Scenario demandScenario(double rate) {
+     Scenario scenario;
+     scenario.seed = 31;
+     scenario.fleet_mix = {3, 3, 3, 3, 0};
+     scenario.demand.enabled = true;
+     scenario.demand.vertiports = {{0, 0, 1, 1.0}, {20, 0, 1, 1.0}, {10, 17, 1, 1.0}};
+     scenario.demand.hourly_rate = {rate};
+     return scenario;
+ }
+ 
+ } // namespace
+ 
+ // Test that arrivals follow the hourly rates and stay in time order.
+ TEST(DemandTests, GeneratorFollowsRates) {
+     DemandProfile profile;
+     profile.vertiports = {{0, 0, 1, 1.0}, {10, 0, 1, 3.0}};
+     profile.hourly_rate = {100.0, 0.0};
+     DemandGenerator generator;
+     generator.reset(profile);
+ 
+     std::mt19937 gen(1);
+     TripRequest request;
+     int in_busy_hours = 0;
+     double last = 0;
+     while (generator.next(gen, 10.0, request)) {
+         EXPECT_GE(request.time, last);
+         EXPECT_NE(request.origin, request.destination);
+         last = request.time;
+         // Odd hours have rate 0
+         EXPECT_EQ(static_cast<int>(request.time) % 2, 0);
+         in_busy_hours++;
+     }
+     EXPECT_NEAR(in_busy_hours, 500, 100); // 5 busy hours at 100/hour
+ }
+ 
+ // Test that the idle index picks the least sufficient range at the site.
+ TEST(DemandTests, IdleIndexBestFit) {
+     IdleVehicleIndex index;
+     index.reset(2, 4);
+     index.insert(0, 50.0, 0);
+     index.insert(0, 20.0, 1);
+     index.insert(0, 35.0, 2);
+     index.insert(1, 80.0, 3);
+ 
+     int vehicle;
+     ASSERT_TRUE(index.take(0, 30.0, vehicle));
+     EXPECT_EQ(vehicle, 2);
+     EXPECT_FALSE(index.take(0, 60.0, vehicle));
+     index.erase(0);
+     EXPECT_EQ(index.idleAt(0), 1u);
+     EXPECT_TRUE(index.take(1, 60.0, vehicle));
+     EXPECT_EQ(vehicle, 3);
+ }
+ 
+ // Test that light demand is fully served and every request is accounted for.
+ TEST(DemandTests, LightDemandIsServed) {
+     Scenario scenario = demandScenario(6.0);
+     // Vehicles pile up at destinations; flying empty across the triangle keeps every origin served
+     scenario.demand.max_deadhead_miles = 25;
+     SimulationContext context;
+     context.run(scenario);
+ 
+     const DemandStats &stats = context.demandStats();
+     EXPECT_GT(stats.requests, 5u);
+     EXPECT_EQ(stats.served + stats.dropped, stats.requests);
+     EXPECT_EQ(stats.dropped, 0u);
+ 
+     int trips = 0;
+     for (int t : context.vehicles().trips) trips += t;
+     EXPECT_EQ(static_cast<uint64_t>(trips), stats.served);
+ }
+ 
+ // Test that heavy demand saturates the fleet and drops requests.
+ TEST(DemandTests, HeavyDemandDrops) {
+     Scenario scenario = demandScenario(400.0);
+     SimulationContext context;
+     context.run(scenario);
+ 
+     const DemandStats &stats = context.demandStats();
+     EXPECT_GT(stats.dropped, 0u);
+     EXPECT_EQ(stats.served + stats.dropped, stats.requests);
+     VehicleColumns vehicles = context.vehicles();
+     for (size_t v = 0; v < vehicles.size(); v++) {
+         EXPECT_LE(vehicles.flight_time[v] + vehicles.charge_time[v], 3.0 + 1e-9);
+     }
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
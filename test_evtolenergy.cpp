@@ -0,0 +1,114 @@
+/**
+ * File : test_evtolenergy.cpp
+ * Unit tests for energy prices, load profiles and the site power cap.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+
+ #include <algorithm>
+ #include <random>
+ #include <tuple>
+ #include <vector>
+
+ // Test price lookups and window integrals against a fine numerical sum.
+ TEST(EnergyTests, PriceIntegrals) {
+     PriceSchedule prices;
+     prices.reset({0.1, 0.3, 0.2});
+     EXPECT_DOUBLE_EQ(prices.price(0.5), 0.1);
+     EXPECT_DOUBLE_EQ(prices.price(2.0), 0.2);
+     EXPECT_DOUBLE_EQ(prices.price(4.5), 0.3); // Repeats every 3 hours
+
+     double from = 0.4, to = 7.3, step = 1e-4, sum = 0;
+     for (double t = from + step / 2; t < to; t += step) sum += prices.price(t) * step;
+     EXPECT_NEAR(prices.integral(from, to), sum, 1e-6);
+     EXPECT_NEAR(prices.averagePrice(from, to), sum / (to - from), 1e-6);
+     EXPECT_NEAR(prices.cost(1.0, 2.5, 100.0), 100.0 * (0.3 + 0.5 * 0.2), 1e-9);
+     EXPECT_DOUBLE_EQ(prices.integral(2.0, 1.0), 0.0);
+
+     PriceSchedule free;
+     free.reset({});
+     EXPECT_DOUBLE_EQ(free.cost(0.0, 5.0, 300.0), 0.0);
+ }
+
+ // Test random draws, some taken back, against the overlap of each draw with each bucket.
+ TEST(EnergyTests, LoadProfileMatchesOverlap) {
+     std::mt19937 gen(5);
+     std::uniform_real_distribution<double> time(-0.2, 3.3);
+     std::uniform_real_distribution<double> power(10.0, 500.0);
+     const double horizon = 3.1, bucket = 0.25;
+     LoadProfile profile;
+     profile.reset(horizon, bucket);
+     std::vector<std::tuple<double, double, double>> draws;
+     for (int i = 0; i < 300; i++) {
+         double a = time(gen), b = time(gen);
+         double kw = i % 5 == 0 && !draws.empty() ? -std::get<2>(draws.back()) : power(gen);
+         if (kw < 0) {
+             a = std::get<0>(draws.back());
+             b = std::get<1>(draws.back());
+         }
+         profile.add(std::min(a, b), std::max(a, b), kw);
+         draws.emplace_back(std::min(a, b), std::max(a, b), kw);
+     }
+     profile.finish();
+
+     ASSERT_EQ(profile.load().size(), 13u); // The last bucket is 0.1 h long
+     double peak = 0;
+     for (size_t i = 0; i < profile.load().size(); i++) {
+         double lo = i * bucket, hi = std::min(lo + bucket, horizon), energy = 0;
+         for (const auto &draw : draws) {
+             double overlap = std::min(hi, std::get<1>(draw)) - std::max(lo, std::get<0>(draw));
+             if (overlap > 0) energy += std::get<2>(draw) * overlap;
+         }
+         EXPECT_NEAR(profile.load()[i], energy / (hi - lo), 1e-6);
+         peak = std::max(peak, energy / (hi - lo));
+     }
+     EXPECT_NEAR(profile.peak(), peak, 1e-6);
+ }
+
+ // Test that metering leaves the run unchanged and that the cap holds the site load.
+ TEST(EnergyTests, MeteringAndSiteCap) {
+     Scenario scenario;
+     scenario.seed = 11;
+     scenario.fleet_mix = {2, 2, 2, 2, 2};
+     SimulationContext plain;
+     plain.run(scenario);
+
+     scenario.energy.enabled = true;
+     scenario.energy.hourly_price = {0.1, 0.4, 0.2};
+     SimulationContext metered;
+     metered.run(scenario);
+     for (size_t v = 0; v < 10; v++) {
+         EXPECT_EQ(metered.vehicles().passenger_miles[v], plain.vehicles().passenger_miles[v]);
+     }
+
+     const EnergyStats &stats = metered.energyStats();
+     ColumnView<double> load = metered.siteLoad(0);
+     double energy = 0;
+     for (size_t i = 0; i < load.size(); i++) energy += load[i] * 0.25;
+     EXPECT_NEAR(stats.energy_kwh, energy, 1e-6);
+     EXPECT_GT(stats.cost, 0.1 * stats.energy_kwh);
+     EXPECT_LT(stats.cost, 0.4 * stats.energy_kwh);
+     EXPECT_GT(stats.peak_kw, 0.0);
+     EXPECT_DOUBLE_EQ(stats.power_wait_hours, 0.0);
+
+     // Two of the largest chargers at most; preempted sessions are re-metered
+     scenario.energy.site_power_kw = 1100;
+     scenario.preemption = true;
+     SimulationContext capped;
+     capped.run(scenario);
+     const EnergyStats &limited = capped.energyStats();
+     EXPECT_GT(limited.power_wait_hours, 0.0);
+     EXPECT_LE(limited.peak_kw, 1100 + 1e-6);
+     EXPECT_LT(limited.energy_kwh, stats.energy_kwh);
+     energy = 0;
+     for (double kw : capped.siteLoad(0)) energy += kw * 0.25;
+     EXPECT_NEAR(limited.energy_kwh, energy, 1e-6);
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
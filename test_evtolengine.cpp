@@ -0,0 +1,264 @@
+/**
+ * File : test_evtolengine.cpp
+ * Unit tests for the discrete-event SimulationContext.
+ *
+ * Validates the charging constraints of the event engine, determinism under a
+ * fixed seed, per-company aggregation and the lifetime of result views.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+ 
+ // Test that no vehicle exceeds the horizon and totals are consistent.
+ TEST(EngineTests, RespectsHorizon) {
+     Scenario scenario;
+     scenario.seed = 7;
+     SimulationContext context;
+     context.run(scenario);
+ 
+     VehicleColumns vehicles = context.vehicles();
+     ASSERT_EQ(vehicles.size(), 20u);
+     for (size_t v = 0; v < vehicles.size(); v++) {
+         EXPECT_LE(vehicles.flight_time[v] + vehicles.charge_time[v], 3.0 + 1e-9);
+         const EVTOL_Spec &spec = scenario.specs[vehicles.spec_index[v]];
+         EXPECT_NEAR(vehicles.distance[v], vehicles.flight_time[v] * spec.cruise_speed, 1e-9);
+     }
+ }
+ 
+ // Test that a fixed seed reproduces the same results.
+ TEST(EngineTests, DeterministicWithSeed) {
+     Scenario scenario;
+     scenario.seed = 99;
+     SimulationContext a, b;
+     a.run(scenario);
+     b.run(scenario);
+ 
+     VehicleColumns va = a.vehicles(), vb = b.vehicles();
+     ASSERT_EQ(va.size(), vb.size());
+     for (size_t v = 0; v < va.size(); v++) {
+         EXPECT_EQ(va.spec_index[v], vb.spec_index[v]);
+         EXPECT_EQ(va.faults[v], vb.faults[v]);
+         EXPECT_DOUBLE_EQ(va.passenger_miles[v], vb.passenger_miles[v]);
+     }
+ }
+ 
+ // Test that company rows are the sums of their vehicles.
+ TEST(EngineTests, CompanyTotals) {
+     Scenario scenario;
+     scenario.seed = 3;
+     scenario.vehicle_count = 50;
+     SimulationContext context;
+     context.run(scenario);
+ 
+     VehicleColumns vehicles = context.vehicles();
+     CompanyColumns companies = context.companies();
+     ASSERT_EQ(companies.size(), scenario.specs.size());
+ 
+     int count = 0;
+     double miles = 0, company_miles = 0;
+     for (size_t c = 0; c < companies.size(); c++) {
+         count += companies.vehicle_count[c];
+         company_miles += companies.passenger_miles[c];
+     }
+     for (double m : vehicles.passenger_miles) miles += m;
+     EXPECT_EQ(count, 50);
+     EXPECT_NEAR(company_miles, miles, 1e-6);
+ }
+ 
+ // Test that a single charger serializes charging.
+ TEST(EngineTests, SingleChargerQueues) {
+     Scenario scenario;
+     scenario.seed = 5;
+     scenario.chargers = 1;
+     scenario.specs = {manufacturers[1]}; // Bravo: short range, short charge
+     scenario.vehicle_count = 4;
+     SimulationContext context;
+     context.run(scenario);
+ 
+     // Charging is serialized, so total charge time fits in one charger's window
+     double total_charge = 0;
+     for (double t : context.vehicles().charge_time) total_charge += t;
+     EXPECT_GT(total_charge, 0.0);
+     EXPECT_LE(total_charge, 3.0 + 1e-9);
+ }
+ 
+ // Test that storage is reused, so a warm context does not reallocate.
+ TEST(EngineTests, ViewsReuseStorage) {
+     Scenario scenario;
+     scenario.seed = 11;
+     SimulationContext context;
+     context.run(scenario);
+     const double *before = context.vehicles().passenger_miles.data();
+     context.run(scenario);
+     EXPECT_EQ(context.vehicles().passenger_miles.data(), before);
+     EXPECT_GT(context.eventsProcessed(), 0u);
+ }
+ 
+ // Test that charging to need never charges more than full charging.
+ TEST(EngineTests, ChargeToNeedShortensCharging) {
+     Scenario scenario;
+     scenario.seed = 13;
+     scenario.fleet_mix = {4, 4, 4, 4, 4};
+     SimulationContext full, partial;
+     full.run(scenario);
+     scenario.charge_to_need = true;
+     partial.run(scenario);
+ 
+     double full_charge = 0, partial_charge = 0;
+     for (double t : full.vehicles().charge_time) full_charge += t;
+     for (double t : partial.vehicles().charge_time) partial_charge += t;
+     EXPECT_LT(partial_charge, full_charge);
+ 
+     VehicleColumns vehicles = partial.vehicles();
+     for (size_t v = 0; v < vehicles.size(); v++) {
+         EXPECT_LE(vehicles.flight_time[v] + vehicles.charge_time[v], 3.0 + 1e-6);
+     }
+ }
+ 
+ // Test that preemption hands chargers to depleted vehicles without breaking the window.
+ TEST(EngineTests, PreemptionFreesChargers) {
+     Scenario scenario;
+     scenario.seed = 17;
+     scenario.chargers = 1;
+     scenario.specs = {manufacturers[2]}; // Charlie: long charge, so arrivals overlap
+     scenario.vehicle_count = 6;
+     scenario.preemption = true;
+     scenario.preempt_soc = 0.3;
+     SimulationContext context;
+     context.run(scenario);
+ 
+     EXPECT_GT(context.preemptions(), 0u);
+     VehicleColumns vehicles = context.vehicles();
+     for (size_t v = 0; v < vehicles.size(); v++) {
+         EXPECT_GE(vehicles.charge_time[v], 0.0);
+         EXPECT_LE(vehicles.flight_time[v] + vehicles.charge_time[v], 3.0 + 1e-9);
+     }
+ }
+ 
+ // Test that mission mode flies sampled trips and respects the reserve.
+ TEST(EngineTests, MissionTrips) {
+     Scenario scenario;
+     scenario.seed = 23;
+     scenario.fleet_mix = {2, 2, 2, 2, 2};
+     scenario.missions.enabled = true;
+     scenario.missions.distribution = TripDistribution::Uniform;
+     scenario.missions.mean_miles = 20;
+     scenario.missions.turnaround_hours = 0.05;
+     SimulationContext context;
+     context.run(scenario);
+ 
+     VehicleColumns vehicles = context.vehicles();
+     int total_trips = 0;
+     for (size_t v = 0; v < vehicles.size(); v++) {
+         const EVTOL_Spec &spec = scenario.specs[vehicles.spec_index[v]];
+         total_trips += vehicles.trips[v];
+         EXPECT_LE(vehicles.flight_time[v] + vehicles.charge_time[v], 3.0 + 1e-9);
+         // Every trip is at most 30 miles (mean 20, spread 50%), apart from range clamping
+         double max_trip = std::min(30.0, 0.8 * spec.battery_capacity / spec.energy_use);
+         EXPECT_LE(vehicles.distance[v], vehicles.trips[v] * max_trip + 1e-9);
+     }
+     EXPECT_GT(total_trips, 50);
+ }
+ 
+ // Test that fixed trips on one charger force a vehicle through the charge cycle.
+ TEST(EngineTests, MissionReserveForcesCharging) {
+     Scenario scenario;
+     scenario.seed = 29;
+     scenario.specs = {manufacturers[1]}; // Bravo: 66 mile range
+     scenario.vehicle_count = 1;
+     scenario.missions.enabled = true;
+     scenario.missions.distribution = TripDistribution::Fixed;
+     scenario.missions.mean_miles = 25;
+     scenario.missions.turnaround_hours = 0;
+     SimulationContext context;
+     context.run(scenario);
+ 
+     // 2 trips use 75% of the battery; a third would breach the 20% reserve
+     VehicleColumns vehicles = context.vehicles();
+     EXPECT_GT(vehicles.charge_time[0], 0.0);
+     EXPECT_GT(vehicles.trips[0], 2);
+ }
+ 
+ // Test that faults ground vehicles and that a single bay makes them queue.
+ TEST(EngineTests, FaultsOccupyMaintenanceBays) {
+     Scenario scenario;
+     scenario.seed = 31;
+     scenario.specs = {manufacturers[4]}; // Echo: 0.61 faults per hour
+     scenario.vehicle_count = 20;
+     scenario.horizon_hours = 6.0;
+     scenario.missions.enabled = true;
+     scenario.missions.mean_miles = 15;
+     SimulationContext free_flying;
+     free_flying.run(scenario);
+ 
+     scenario.maintenance.enabled = true;
+     scenario.maintenance.bays = 1;
+     scenario.maintenance.repair_hours = 0.5;
+     SimulationContext grounded;
+     grounded.run(scenario);
+ 
+     const MaintenanceStats &stats = grounded.maintenanceStats();
+     EXPECT_GT(stats.repairs, 0u);
+     EXPECT_GT(stats.total_wait_hours, 0.0);
+     // One bay is busy at most the whole window
+     EXPECT_LE(stats.bay_hours, scenario.horizon_hours + 1e-9);
+     EXPECT_EQ(free_flying.maintenanceStats().repairs, 0u);
+ 
+     double flown = 0, flown_grounded = 0;
+     for (size_t v = 0; v < 20; v++) {
+         flown += free_flying.vehicles().flight_time[v];
+         flown_grounded += grounded.vehicles().flight_time[v];
+         EXPECT_LE(grounded.vehicles().flight_time[v] + grounded.vehicles().charge_time[v], 6.0 + 1e-9);
+     }
+     EXPECT_LT(flown_grounded, flown);
+ }
+ 
+ // Test that shifts accumulate into the columns and that charging fades batteries.
+ TEST(EngineTests, ShiftsFadeBatteries) {
+     Scenario scenario;
+     scenario.seed = 17;
+     scenario.fleet_mix = {2, 2, 2, 2, 2};
+     SimulationContext single;
+     single.run(scenario);
+     scenario.shifts.fade_per_cycle = 0.05; // Applied after the shift: the flying is unchanged, the end capacity fades
+     SimulationContext configured;
+     configured.run(scenario);
+     EXPECT_EQ(configured.vehicles().passenger_miles[3], single.vehicles().passenger_miles[3]);
+     EXPECT_EQ(configured.shiftStats().shifts, 1);
+     EXPECT_LT(configured.shiftStats().mean_capacity, 1.0);
+
+     scenario.shifts.count = 8;
+     scenario.shifts.overnight_charge = true;
+     scenario.shifts.fade_per_cycle = 0;
+     SimulationContext fresh;
+     fresh.run(scenario);
+     scenario.shifts.fade_per_cycle = 0.02;
+     scenario.shifts.min_capacity = 0.8;
+     SimulationContext worn;
+     worn.run(scenario);
+
+     const ShiftStats &stats = worn.shiftStats();
+     double total = 0;
+     for (double miles : worn.vehicles().passenger_miles) total += miles;
+     EXPECT_EQ(stats.shifts, 8);
+     EXPECT_NEAR(stats.total_passenger_miles, total, 1e-6);
+     EXPECT_LE(stats.min_passenger_miles, stats.last_passenger_miles);
+     EXPECT_LE(stats.last_passenger_miles, stats.max_passenger_miles);
+     EXPECT_LT(stats.mean_capacity, 1.0);
+     EXPECT_GE(stats.min_capacity, 0.8);
+     for (double left : worn.vehicles().capacity) EXPECT_GE(left, 0.8);
+
+     // Identical shifts without wear; faded batteries fly less
+     EXPECT_DOUBLE_EQ(fresh.shiftStats().mean_capacity, 1.0);
+     EXPECT_LT(stats.total_passenger_miles, fresh.shiftStats().total_passenger_miles);
+     for (size_t v = 0; v < 10; v++) {
+         EXPECT_LE(worn.vehicles().flight_time[v] + worn.vehicles().charge_time[v], 8 * 3.0 + 1e-9);
+     }
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,78 @@
+/**
+ * File : test_evtolevents.cpp
+ * Unit tests for the cancellable event queue.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolevents.h"
+ 
+ #include <algorithm>
+ #include <random>
+ #include <vector>
+ 
+ // Test time ordering with insertion order breaking ties.
+ TEST(EventQueueTests, OrdersByTimeThenInsertion) {
+     EventQueue queue;
+     queue.push(2.0, 1, EventType::Depleted);
+     queue.push(1.0, 2, EventType::ChargeDone);
+     queue.push(1.0, 3, EventType::Depleted);
+ 
+     EXPECT_EQ(queue.pop().vehicle, 2);
+     EXPECT_EQ(queue.pop().vehicle, 3);
+     EXPECT_EQ(queue.pop().vehicle, 1);
+     EXPECT_TRUE(queue.empty());
+ }
+ 
+ // Test cancelling and rescheduling pending events.
+ TEST(EventQueueTests, CancelAndReschedule) {
+     EventQueue queue;
+     EventHandle a = queue.push(1.0, 1, EventType::ChargeDone);
+     EventHandle b = queue.push(2.0, 2, EventType::ChargeDone);
+     queue.push(3.0, 3, EventType::ChargeDone);
+ 
+     EXPECT_TRUE(queue.cancel(a));
+     EXPECT_FALSE(queue.cancel(a));
+     EXPECT_TRUE(queue.reschedule(b, 4.0));
+ 
+     EXPECT_EQ(queue.pop().vehicle, 3);
+     Event last = queue.pop();
+     EXPECT_EQ(last.vehicle, 2);
+     EXPECT_DOUBLE_EQ(last.time, 4.0);
+     EXPECT_FALSE(queue.pending(b));
+ }
+ 
+ // Test the heap against a sorted reference under random cancellations.
+ TEST(EventQueueTests, RandomizedAgainstReference) {
+     std::mt19937 gen(3);
+     std::uniform_real_distribution<double> time(0.0, 100.0);
+     EventQueue queue;
+     std::vector<EventHandle> handles;
+     std::vector<std::pair<double, int>> expected;
+ 
+     for (int i = 0; i < 500; i++) {
+         double t = time(gen);
+         handles.push_back(queue.push(t, i, EventType::Depleted));
+         expected.push_back({t, i});
+     }
+     for (int i = 0; i < 500; i += 3) {
+         ASSERT_TRUE(queue.cancel(handles[i]));
+     }
+     std::vector<std::pair<double, int>> kept;
+     for (const auto &e : expected) {
+         if (e.second % 3 != 0) kept.push_back(e);
+     }
+     std::sort(kept.begin(), kept.end());
+ 
+     ASSERT_EQ(queue.size(), kept.size());
+     for (const auto &e : kept) {
+         Event event = queue.pop();
+         EXPECT_EQ(event.vehicle, e.second);
+     }
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,139 @@
+/**
+ * File : test_evtolfidelity.cpp
+ * Unit tests for the analytic bound, the cohort simulation and the
+ * multi-fidelity pipeline.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolfidelity.h"
+
+ #include <vector>
+
+ // Fleet passenger miles of one engine run.
+ double engineMiles(const Scenario &scenario) {
+     SimulationContext context;
+     context.run(scenario);
+     double miles = 0;
+     for (double m : context.vehicles().passenger_miles) miles += m;
+     return miles;
+ }
+
+ // Test that the bound holds and the cohort run matches the engine on fixed fleets.
+ TEST(FidelityTests, CheapModelsAgainstEngine) {
+     for (int chargers : {0, 1, 3, 7, 40}) {
+         for (double horizon : {1.0, 3.0, 9.5}) {
+             Scenario scenario;
+             scenario.seed = 11;
+             scenario.chargers = chargers;
+             scenario.horizon_hours = horizon;
+             scenario.fleet_mix = {3, 5, 2, 6, 4};
+             double bound = 0, cohort = 0, engine = engineMiles(scenario);
+             ASSERT_TRUE(analyticPassengerMiles(scenario, bound));
+             ASSERT_TRUE(cohortPassengerMiles(scenario, cohort));
+             EXPECT_GE(bound, engine - 1e-6) << chargers << " chargers, " << horizon << " h";
+             EXPECT_NEAR(cohort, engine, 1e-6 * (1 + engine)) << chargers << " chargers, " << horizon << " h";
+         }
+     }
+
+     // With a charger for everyone the bound is exact
+     Scenario scenario;
+     scenario.chargers = 20;
+     scenario.horizon_hours = 6;
+     scenario.fleet_mix = {4, 4, 4, 4, 4};
+     double bound = 0;
+     ASSERT_TRUE(analyticPassengerMiles(scenario, bound));
+     EXPECT_NEAR(bound, engineMiles(scenario), 1e-6 * bound);
+
+     scenario.preemption = true;
+     EXPECT_FALSE(fidelityCovers(scenario));
+     EXPECT_FALSE(cohortPassengerMiles(scenario, bound));
+ }
+
+ // Test that the pipeline spends its budgets on the contenders and labels every answer.
+ TEST(FidelityTests, PipelineScreens) {
+     std::vector<Scenario> candidates;
+     for (int chargers = 0; chargers <= 8; chargers++) {
+         for (int specs = 1; specs <= 5; specs++) {
+             Scenario scenario;
+             scenario.seed = 3;
+             scenario.chargers = chargers;
+             scenario.fleet_mix.assign(5, 0);
+             scenario.fleet_mix[specs - 1] = 10; // Single-spec fleets, from slow to fast
+             candidates.push_back(scenario);
+         }
+     }
+     Scenario uncovered = candidates.back();
+     uncovered.missions.enabled = true;
+     candidates.push_back(uncovered);
+
+     FidelityBudget budget;
+     budget.simulations = 4;
+     budget.replicas = 3;
+     ReplicaPool pool(2);
+     PipelineReport report = evaluateCandidates(pool, candidates, budget);
+
+     EXPECT_EQ(report.analytic, candidates.size() - 1);
+     EXPECT_LE(report.simulated, 4u);
+     EXPECT_LT(report.cohort, candidates.size() - 1); // Hopeless fleets never leave the analytic stage
+     EXPECT_EQ(report.candidates.back().fidelity, Fidelity::Simulation);
+     EXPECT_EQ(report.candidates[0].fidelity, Fidelity::Analytic); // No chargers, slowest spec
+
+     // The winner is the best fleet any single engine run finds
+     ASSERT_GE(report.best, 0);
+     double best = 0;
+     int best_index = -1;
+     for (size_t i = 0; i + 1 < candidates.size(); i++) {
+         double miles = pool.run(candidates[i], 3).fleet.passenger_miles.mean();
+         if (miles > best) {
+             best = miles;
+             best_index = static_cast<int>(i);
+         }
+     }
+     EXPECT_NEAR(report.candidates[best_index].passenger_miles, best, 1e-6 * best);
+     EXPECT_EQ(report.candidates[best_index].fidelity, Fidelity::Simulation);
+     size_t simulated = 0;
+     for (const CandidateEvaluation &evaluation : report.candidates) {
+         simulated += evaluation.fidelity == Fidelity::Simulation;
+         EXPECT_NE(evaluation.fidelity, Fidelity::None);
+     }
+     EXPECT_EQ(simulated, report.simulated);
+ }
+
+ // Test that candidates past the cohort budget are still simulated when their bounds compete.
+ TEST(FidelityTests, CohortBudgetLeavesContenders) {
+     std::vector<Scenario> candidates;
+     for (int chargers = 1; chargers <= 6; chargers++) {
+         Scenario scenario;
+         scenario.seed = 4;
+         scenario.chargers = chargers;
+         scenario.fleet_mix = {0, 0, 0, 0, 10};
+         candidates.push_back(scenario);
+     }
+
+     FidelityBudget budget;
+     budget.cohort_runs = 2;
+     budget.simulations = candidates.size();
+     budget.replicas = 3;
+     ReplicaPool pool(2);
+     PipelineReport report = evaluateCandidates(pool, candidates, budget);
+
+     EXPECT_EQ(report.cohort, 2u);
+     ASSERT_GE(report.best, 0);
+     double best = report.candidates[report.best].passenger_miles;
+     for (size_t i = 0; i < candidates.size(); i++) {
+         const CandidateEvaluation &evaluation = report.candidates[i];
+         EXPECT_NE(evaluation.fidelity, Fidelity::None);
+         if (evaluation.fidelity != Fidelity::Simulation) {
+             // Only candidates whose cohort answer or bound cannot reach the winner go unsimulated
+             EXPECT_LT(evaluation.passenger_miles, (1 - budget.tolerance) * best);
+         }
+         EXPECT_LE(pool.run(candidates[i], 3).fleet.passenger_miles.mean(), best + 1e-6 * best);
+     }
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,148 @@
+/**
+ * File : test_evtoloccupancy.cpp
+ * Unit tests for charger occupancy timelines and their replica statistics.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolbatch.h"
+ #include "evtolengine.h"
+
+ #include <algorithm>
+ #include <cmath>
+ #include <random>
+ #include <vector>
+
+ // Test bitmap queries against one bool per slot, across word boundaries.
+ TEST(OccupancyTests, MatchesPerSlotReference) {
+     const size_t chargers = 3;
+     const double slot = 1.0 / 60;
+     OccupancyTimeline timeline;
+     timeline.reset(chargers, 3.0, slot);
+     ASSERT_EQ(timeline.slots(), 180u);
+     std::vector<std::vector<bool>> busy(chargers, std::vector<bool>(180, false));
+
+     std::mt19937 gen(3);
+     std::uniform_real_distribution<double> time(-0.1, 3.1);
+     for (int i = 0; i < 60; i++) {
+         size_t c = i % chargers;
+         double a = time(gen), b = time(gen);
+         double start = std::min(a, b), end = std::max(a, b);
+         bool mark = i % 4 != 3;
+         if (mark) {
+             timeline.mark(c, start, end);
+         } else {
+             timeline.clear(c, start, end);
+         }
+         for (size_t s = 0; s < 180; s++) {
+             double mid = (s + 0.5) * slot;
+             if (mid >= start && mid < end) busy[c][s] = mark;
+         }
+     }
+
+     uint64_t all = 0;
+     for (size_t s = 0; s < 180; s++) all += busy[0][s] && busy[1][s] && busy[2][s];
+     EXPECT_EQ(timeline.allBusySlots(0, chargers), all);
+     for (size_t c = 0; c < chargers; c++) {
+         EXPECT_EQ(timeline.busySlots(c), static_cast<uint64_t>(std::count(busy[c].begin(), busy[c].end(), true)));
+
+         IdleGaps expected;
+         for (size_t s = 0; s < 180;) {
+             if (busy[c][s]) {
+                 s++;
+                 continue;
+             }
+             size_t end = s;
+             while (end < 180 && !busy[c][end]) end++;
+             expected.count++;
+             expected.longest_hours = std::max(expected.longest_hours, (end - s) * slot);
+             s = end;
+         }
+         IdleGaps gaps = timeline.idleGaps(c);
+         EXPECT_EQ(gaps.count, expected.count);
+         EXPECT_NEAR(gaps.longest_hours, expected.longest_hours, 1e-12);
+     }
+ }
+
+ // Test that the timelines account for the engine's charging time, with and without preemption.
+ TEST(OccupancyTests, EngineBusyTimeMatchesChargeTime) {
+     Scenario scenario;
+     scenario.seed = 21;
+     scenario.fleet_mix = {3, 3, 3, 3, 3};
+     scenario.occupancy_slot_hours = 1e-4;
+     for (bool preempt : {false, true}) {
+         scenario.preemption = preempt;
+         SimulationContext context;
+         context.run(scenario);
+         double charging = 0;
+         for (double hours : context.vehicles().charge_time) charging += hours;
+
+         const OccupancyStats &stats = context.occupancyStats();
+         EXPECT_EQ(stats.chargers, 3u);
+         EXPECT_NEAR(stats.busy_hours, charging, 0.01);
+         EXPECT_NEAR(stats.charger_hours, 9.0, 1e-6);
+         EXPECT_GT(stats.allBusyFraction(), 0.0);
+         EXPECT_LE(stats.allBusyFraction(), stats.utilization());
+         EXPECT_GE(stats.idle_gaps, 3u); // Every charger is idle until the first depletion
+     }
+
+     scenario.occupancy_slot_hours = 0;
+     SimulationContext off;
+     off.run(scenario);
+     EXPECT_EQ(off.occupancyStats().chargers, 0u);
+ }
+
+ // Test that long horizons widen the slot instead of growing the bitmap past its cap.
+ TEST(OccupancyTests, LongHorizonsWidenSlots) {
+     OccupancyTimeline timeline;
+     double minute = 1.0 / 60;
+     ASSERT_TRUE(timeline.reset(100000, 24 * 366, minute));
+     EXPECT_EQ(timeline.chargers(), 100000u);
+     EXPECT_LE(timeline.chargers() * ((timeline.slots() + 63) / 64), OccupancyTimeline::kMaxWords);
+     EXPECT_GT(timeline.slotHours(), minute);
+     double factor = timeline.slotHours() / minute;
+     EXPECT_NEAR(factor, std::round(factor), 1e-9);
+     EXPECT_GE(timeline.slots() * timeline.slotHours(), 24 * 366 - 1e-9);
+     timeline.mark(99999, 100, 200);
+     EXPECT_NEAR(timeline.busySlots(99999) * timeline.slotHours(), 100, timeline.slotHours());
+
+     ASSERT_TRUE(timeline.reset(4, 3, minute));
+     EXPECT_DOUBLE_EQ(timeline.slotHours(), minute); // Short runs keep the requested slot
+     EXPECT_EQ(timeline.slots(), 180u);
+
+     EXPECT_FALSE(timeline.reset(OccupancyTimeline::kMaxWords + 1, 1, minute));
+     EXPECT_EQ(timeline.chargers(), 0u);
+
+     Scenario scenario;
+     scenario.seed = 3;
+     scenario.horizon_hours = 24 * 366;
+     scenario.chargers = 20000;
+     SimulationContext context;
+     context.run(scenario);
+     EXPECT_EQ(context.occupancyStats().chargers, 20000u);
+     EXPECT_GT(context.occupancy().slotHours(), minute);
+     EXPECT_GT(context.occupancyStats().busy_hours, 0.0);
+ }
+
+ // Test that occupancy statistics of two batches merge into those of one.
+ TEST(OccupancyTests, ReplicaStatsMerge) {
+     Scenario scenario;
+     scenario.seed = 9;
+     ReplicaPool pool(2);
+     ScenarioStats whole = pool.run(scenario, 6);
+     ScenarioStats part = pool.run(scenario, 2);
+     part.merge(pool.run(scenario, 4, 2));
+
+     EXPECT_EQ(whole.occupancy.utilization.count, 6u);
+     EXPECT_EQ(part.occupancy.utilization.count, 6u);
+     EXPECT_NEAR(part.occupancy.utilization.mean(), whole.occupancy.utilization.mean(), 1e-12);
+     EXPECT_NEAR(part.occupancy.all_busy.stddev(), whole.occupancy.all_busy.stddev(), 1e-9);
+     EXPECT_GT(whole.occupancy.utilization.mean(), 0.0);
+     EXPECT_LE(whole.occupancy.utilization.mean(), 1.0);
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,89 @@
+/**
+ * File : test_evtoloptimal.cpp
+ * Unit tests for the offline optimal charging schedule.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+ #include "evtoloptimal.h"
+ 
+ #include <vector>
+ 
+ namespace {
+ 
+ std::vector<int> fleetOf(const SimulationContext &context) {
+     VehicleColumns vehicles = context.vehicles();
+     return std::vector<int>(vehicles.spec_index.begin(), vehicles.spec_index.end());
+ }
+ 
+ double passengerMiles(const SimulationContext &context) {
+     double total = 0;
+     for (double miles : context.vehicles().passenger_miles) total += miles;
+     return total;
+ }
+ 
+ } // namespace
+ 
+ // Test that the optimum bounds the first-come and charge-to-need policies.
+ TEST(OptimalScheduleTests, BoundsOnlinePolicies) {
+     Scenario scenario;
+     scenario.seed = 47;
+     scenario.fleet_mix = {2, 2, 2, 2, 2};
+     SimulationContext fifo;
+     fifo.run(scenario);
+     scenario.charge_to_need = true;
+     SimulationContext to_need;
+     to_need.run(scenario);
+ 
+     OptimalSchedule optimal = solveChargingSchedule(scenario, fleetOf(fifo));
+     EXPECT_TRUE(optimal.exact);
+     EXPECT_DOUBLE_EQ(optimal.upper_bound, optimal.passenger_miles);
+     EXPECT_GE(optimal.passenger_miles, passengerMiles(fifo) - 1e-6);
+     EXPECT_GE(optimal.passenger_miles, passengerMiles(to_need) - 1e-6);
+ }
+ 
+ // Test that the schedule never uses a charger twice at once and matches its total.
+ TEST(OptimalScheduleTests, ScheduleIsFeasible) {
+     Scenario scenario;
+     scenario.chargers = 2;
+     std::vector<int> fleet = {0, 1, 1, 3, 4, 4};
+     OptimalSchedule optimal = solveChargingSchedule(scenario, fleet);
+     ASSERT_FALSE(optimal.charges.empty());
+ 
+     std::vector<double> charger_free(2, 0.0);
+     for (const ChargeAssignment &charge : optimal.charges) {
+         EXPECT_GE(charge.start, charger_free[charge.charger] - 1e-9);
+         EXPECT_LT(charge.end, scenario.horizon_hours);
+         charger_free[charge.charger] = charge.end;
+     }
+ }
+ 
+ // Test that thread count does not change the optimum and that a node limit still returns a bound.
+ TEST(OptimalScheduleTests, ThreadsAndNodeLimit) {
+     Scenario scenario;
+     scenario.chargers = 3;
+     scenario.horizon_hours = 3.0;
+     std::vector<int> fleet = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4};
+     ScheduleOptions serial;
+     serial.threads = 1;
+     ScheduleOptions parallel;
+     parallel.threads = 4;
+     OptimalSchedule a = solveChargingSchedule(scenario, fleet, serial);
+     OptimalSchedule b = solveChargingSchedule(scenario, fleet, parallel);
+     ASSERT_TRUE(a.exact && b.exact);
+     EXPECT_NEAR(a.passenger_miles, b.passenger_miles, 1e-6);
+ 
+     ScheduleOptions limited;
+     limited.threads = 2;
+     limited.max_nodes = 500;
+     OptimalSchedule c = solveChargingSchedule(scenario, fleet, limited);
+     EXPECT_LE(c.passenger_miles, a.passenger_miles + 1e-6);
+     EXPECT_GE(c.upper_bound, a.passenger_miles - 1e-6);
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,84 @@
+/**
+ * File : test_evtolrandom.cpp
+ * Unit tests for the batched xoshiro256+ generator.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolrandom.h"
+
+ #include <cmath>
+ #include <vector>
+
+ // Test that the first uniform is lane 0's first xoshiro256+ output, seeded through splitmix64.
+ TEST(RandomTests, MatchesReference) {
+     uint64_t x = 42, words[4];
+     for (uint64_t &word : words) {
+         uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+         z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+         z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+         word = z ^ (z >> 31);
+     }
+     BatchRandom random(SimdLevel::Scalar);
+     random.seed(42);
+     EXPECT_EQ(random.uniform(), std::ldexp(static_cast<double>((words[0] + words[3]) >> 12), -52));
+ }
+
+ // Test that every kernel the CPU has produces the scalar stream bit for bit.
+ TEST(RandomTests, KernelsAgree) {
+     const size_t count = 3 * BatchRandom::kBlock + 17;
+     BatchRandom scalar(SimdLevel::Scalar);
+     ASSERT_EQ(scalar.kernel(), SimdLevel::Scalar);
+     scalar.seed(7);
+     std::vector<double> expected(count);
+     scalar.fill(expected.data(), count);
+
+     for (SimdLevel kernel : {SimdLevel::Avx2, SimdLevel::Avx512, SimdLevel::Auto}) {
+         BatchRandom random(kernel);
+         random.seed(7);
+         std::vector<double> values(count);
+         random.fill(values.data(), count);
+         EXPECT_EQ(values, expected);
+     }
+ }
+
+ // Test that fill and single draws read the same stream across block boundaries, and seeding restarts it.
+ TEST(RandomTests, FillMatchesDraws) {
+     BatchRandom random;
+     random.seed(11);
+     std::vector<double> filled(BatchRandom::kBlock + 100);
+     random.uniform();
+     random.fill(filled.data(), filled.size());
+
+     random.seed(11);
+     random.uniform();
+     for (double value : filled) EXPECT_EQ(random.uniform(), value);
+ }
+
+ // Test that uniforms cover [0, 1) with the right mean and variance, and indices are even.
+ TEST(RandomTests, Uniform) {
+     const int count = 1000000;
+     BatchRandom random;
+     random.seed(3);
+     double sum = 0, squares = 0;
+     for (int i = 0; i < count; i++) {
+         double u = random.uniform();
+         ASSERT_GE(u, 0.0);
+         ASSERT_LT(u, 1.0);
+         sum += u;
+         squares += u * u;
+     }
+     double mean = sum / count;
+     EXPECT_NEAR(mean, 0.5, 0.002);
+     EXPECT_NEAR(squares / count - mean * mean, 1.0 / 12, 0.001);
+
+     std::vector<int> hits(5, 0);
+     for (int i = 0; i < count; i++) hits[random.index(5)]++;
+     for (int h : hits) EXPECT_NEAR(h, count / 5, 0.01 * count / 5);
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
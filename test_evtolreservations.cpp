@@ -0,0 +1,100 @@
+/**
+ * File : test_evtolreservations.cpp
+ * Unit tests for charger booking calendars and reservation-based charging.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+ 
+ #include <algorithm>
+ #include <map>
+ #include <random>
+ 
+ // Test earliest-fit queries on a small calendar.
+ TEST(ReservationTests, EarliestFit) {
+     ReservationCalendar calendar;
+     EXPECT_DOUBLE_EQ(calendar.earliestFit(1.0, 2.0), 1.0);
+     calendar.book(1.0, 2.0);
+     calendar.book(3.0, 4.0);
+     calendar.book(4.5, 6.0);
+ 
+     EXPECT_DOUBLE_EQ(calendar.earliestFit(0.0, 1.0), 0.0);
+     EXPECT_DOUBLE_EQ(calendar.earliestFit(0.5, 1.0), 2.0);
+     EXPECT_DOUBLE_EQ(calendar.earliestFit(1.5, 0.5), 2.0);
+     EXPECT_DOUBLE_EQ(calendar.earliestFit(1.5, 1.5), 6.0);
+     EXPECT_DOUBLE_EQ(calendar.earliestFit(3.5, 0.5), 4.0);
+ 
+     EXPECT_TRUE(calendar.cancel(3.0));
+     EXPECT_FALSE(calendar.cancel(3.0));
+     EXPECT_DOUBLE_EQ(calendar.earliestFit(1.5, 1.5), 2.0);
+     EXPECT_EQ(calendar.size(), 2u);
+ }
+ 
+ // Test random bookings and cancellations against a linear scan of a sorted map.
+ TEST(ReservationTests, RandomizedAgainstReference) {
+     std::mt19937 gen(17);
+     std::uniform_real_distribution<double> time(0.0, 100.0);
+     std::uniform_real_distribution<double> length(0.1, 3.0);
+     ReservationCalendar calendar;
+     std::map<double, double> reference;
+ 
+     auto expected = [&](double from, double len) {
+         double slot = from;
+         for (const auto &booking : reference) {
+             if (booking.second <= slot) continue;
+             if (booking.first >= slot + len) break;
+             slot = booking.second;
+         }
+         return slot;
+     };
+ 
+     for (int step = 0; step < 4000; step++) {
+         double from = time(gen), len = length(gen);
+         double slot = calendar.earliestFit(from, len);
+         ASSERT_DOUBLE_EQ(slot, expected(from, len));
+         if (gen() % 3 != 0 || reference.empty()) {
+             calendar.book(slot, slot + len);
+             reference[slot] = slot + len;
+         } else {
+             auto victim = reference.begin();
+             std::advance(victim, gen() % reference.size());
+             EXPECT_TRUE(calendar.cancel(victim->first));
+             reference.erase(victim);
+         }
+         ASSERT_EQ(calendar.size(), reference.size());
+     }
+ }
+ 
+ // Test that reserved charging stays within the chargers and keeps vehicles charging.
+ TEST(ReservationTests, EngineChargesAtBookedSlots) {
+     Scenario scenario;
+     scenario.seed = 43;
+     scenario.vehicle_count = 30;
+     scenario.chargers = 2;
+     scenario.horizon_hours = 8.0;
+     SimulationContext queued;
+     queued.run(scenario);
+ 
+     scenario.reservations = true;
+     SimulationContext reserved;
+     reserved.run(scenario);
+ 
+     VehicleColumns a = queued.vehicles(), b = reserved.vehicles();
+     double queued_charge = 0, reserved_charge = 0;
+     for (size_t v = 0; v < b.size(); v++) {
+         queued_charge += a.charge_time[v];
+         reserved_charge += b.charge_time[v];
+         EXPECT_LE(b.flight_time[v] + b.charge_time[v], 8.0 + 1e-9);
+     }
+     EXPECT_GT(reserved_charge, 0.0);
+     EXPECT_LE(reserved_charge, 2 * 8.0 + 1e-9);
+     // Both keep the two chargers busy most of the window
+     EXPECT_GT(reserved_charge, 0.8 * queued_charge);
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,156 @@
+/**
+ * File : test_evtolroutes.cpp
+ * Unit tests for the vertiport route table.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+ 
+ #include <algorithm>
+ #include <cmath>
+ #include <limits>
+ #include <random>
+ 
+ // Test that without links every pair is a direct flight.
+ TEST(RouteTests, DirectRoutesWithoutLinks) {
+     DemandProfile profile;
+     profile.vertiports = {{0, 0, 1, 1}, {3, 4, 1, 1}, {-6, 8, 1, 1}};
+     RouteTable routes;
+     routes.build(profile, manufacturers);
+ 
+     ASSERT_EQ(routes.sites(), 3u);
+     EXPECT_DOUBLE_EQ(routes.miles(0, 1), 5.0);
+     EXPECT_DOUBLE_EQ(routes.miles(2, 0), 10.0);
+     EXPECT_DOUBLE_EQ(routes.miles(1, 1), 0.0);
+     for (size_t s = 0; s < manufacturers.size(); s++) {
+         EXPECT_FLOAT_EQ(routes.hours(s, 0, 1), 5.0 / manufacturers[s].cruise_speed);
+         EXPECT_FLOAT_EQ(routes.kwh(s, 0, 1), 5.0 * manufacturers[s].energy_use);
+     }
+ }
+ 
+ // Test shortest paths over random links against Floyd-Warshall, single- and multi-threaded.
+ TEST(RouteTests, ShortestPathsMatchFloydWarshall) {
+     std::mt19937 gen(21);
+     std::uniform_real_distribution<double> coord(0.0, 50.0);
+     const int n = 60;
+     DemandProfile profile;
+     for (int i = 0; i < n; i++) profile.vertiports.push_back({coord(gen), coord(gen), 1, 1.0});
+     std::uniform_int_distribution<int> site(0, n - 1);
+     for (int l = 0; l < 150; l++) {
+         RouteLink link{site(gen), site(gen)};
+         if (l % 3 == 0) link.miles = 100.0; // Some corridors longer than the straight line
+         profile.links.push_back(link);
+     }
+ 
+     const double inf = std::numeric_limits<double>::infinity();
+     std::vector<double> expected(n * n, inf);
+     for (int i = 0; i < n; i++) expected[i * n + i] = 0;
+     for (const RouteLink &link : profile.links) {
+         const Vertiport &a = profile.vertiports[link.from];
+         const Vertiport &b = profile.vertiports[link.to];
+         double miles = link.miles > 0 ? link.miles : std::hypot(a.x - b.x, a.y - b.y);
+         expected[link.from * n + link.to] = std::min(expected[link.from * n + link.to], miles);
+         expected[link.to * n + link.from] = std::min(expected[link.to * n + link.from], miles);
+     }
+     for (int k = 0; k < n; k++)
+         for (int i = 0; i < n; i++)
+             for (int j = 0; j < n; j++)
+                 expected[i * n + j] = std::min(expected[i * n + j], expected[i * n + k] + expected[k * n + j]);
+ 
+     for (int threads : {1, 4}) {
+         RouteTable routes;
+         routes.build(profile, manufacturers, threads);
+         for (int i = 0; i < n; i++) {
+             for (int j = 0; j < n; j++) {
+                 if (expected[i * n + j] == inf) {
+                     EXPECT_FALSE(routes.reachable(i, j));
+                 } else {
+                     EXPECT_NEAR(routes.miles(i, j), expected[i * n + j], 1e-9);
+                 }
+             }
+         }
+     }
+ }
+ 
+ // Test that requests between disconnected parts of the network are dropped.
+ TEST(RouteTests, UnreachableRequestsAreDropped) {
+     Scenario scenario;
+     scenario.seed = 13;
+     scenario.vehicle_count = 8;
+     scenario.demand.enabled = true;
+     scenario.demand.vertiports = {{0, 0, 2, 1.0}, {10, 0, 2, 1.0}, {50, 0, 2, 1.0}, {60, 0, 2, 1.0}};
+     scenario.demand.links = {{0, 1}, {2, 3}};
+     scenario.demand.hourly_rate = {20.0};
+ 
+     SimulationContext context;
+     context.run(scenario);
+     const DemandStats &stats = context.demandStats();
+     EXPECT_GT(stats.served, 0u);
+     EXPECT_GT(stats.dropped, 0u);
+     // Every served trip is a 10-mile hop inside one part
+     double miles = 0;
+     int trips = 0;
+     for (size_t v = 0; v < context.vehicles().distance.size(); v++) {
+         miles += context.vehicles().distance[v];
+         trips += context.vehicles().trips[v];
+     }
+     EXPECT_LE(miles, trips * 10.0 + 1e-6);
+ }
+ 
+ // Test that corridors longer than the straight line lengthen the flights.
+ TEST(RouteTests, LinksLengthenFlights) {
+     Scenario scenario;
+     scenario.seed = 5;
+     scenario.vehicle_count = 6;
+     scenario.demand.enabled = true;
+     scenario.demand.vertiports = {{0, 0, 3, 1.0}, {10, 0, 3, 1.0}};
+     scenario.demand.hourly_rate = {6.0};
+ 
+     SimulationContext direct;
+     direct.run(scenario);
+     scenario.demand.links = {{0, 1, 20.0}};
+     SimulationContext detour;
+     detour.run(scenario);
+ 
+     ASSERT_GT(direct.demandStats().served, 0u);
+     ASSERT_GT(detour.demandStats().served, 0u);
+     double direct_time = 0, detour_time = 0;
+     int direct_trips = 0, detour_trips = 0;
+     for (size_t v = 0; v < 6; v++) {
+         direct_time += direct.vehicles().flight_time[v];
+         detour_time += detour.vehicles().flight_time[v];
+         direct_trips += direct.vehicles().trips[v];
+         detour_trips += detour.vehicles().trips[v];
+     }
+     EXPECT_GT(detour_time / detour_trips, 1.5 * direct_time / direct_trips);
+ }
+ 
+ // Test that contexts building routes inline match those using every core.
+ TEST(RouteTests, InlineRouteBuildMatches) {
+     Scenario scenario;
+     scenario.seed = 13;
+     scenario.vehicle_count = 8;
+     scenario.demand.enabled = true;
+     scenario.demand.vertiports = {{0, 0, 2, 1.0}, {10, 0, 2, 1.0}, {20, 5, 2, 1.0}, {30, 0, 2, 1.0}};
+     scenario.demand.links = {{0, 1}, {1, 2}, {2, 3}, {0, 3, 40.0}};
+     scenario.demand.hourly_rate = {20.0};
+
+     SimulationContext inline_routes(1);
+     inline_routes.run(scenario);
+     SimulationContext threaded_routes(4);
+     threaded_routes.run(scenario);
+
+     ASSERT_GT(inline_routes.demandStats().served, 0u);
+     EXPECT_EQ(inline_routes.demandStats().served, threaded_routes.demandStats().served);
+     EXPECT_EQ(inline_routes.demandStats().dropped, threaded_routes.demandStats().dropped);
+     for (size_t v = 0; v < 8; v++) {
+         EXPECT_EQ(inline_routes.vehicles().distance[v], threaded_routes.vehicles().distance[v]);
+     }
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,120 @@
+/**
+ * File : test_evtolsensitivity.cpp
+ * Unit tests for the engine's pathwise sensitivity estimates.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolbatch.h"
+ #include "evtolengine.h"
+
+ #include <cmath>
+ #include <functional>
+
+ // Fleet passenger miles and charge hours of one run.
+ void fleetTotals(const Scenario &scenario, double &miles, double &charging) {
+     SimulationContext context;
+     context.run(scenario);
+     miles = charging = 0;
+     for (double m : context.vehicles().passenger_miles) miles += m;
+     for (double hours : context.vehicles().charge_time) charging += hours;
+ }
+
+ // Central difference of the fleet totals under the same seed, against the pathwise estimate.
+ void expectMatchesDifference(const Scenario &scenario, size_t param, double step,
+                              const std::function<void(Scenario &, double)> &perturb) {
+     SimulationContext context;
+     context.run(scenario);
+     const SensitivityStats &stats = context.sensitivities();
+     ASSERT_TRUE(stats.valid);
+
+     Scenario up = scenario, down = scenario;
+     perturb(up, step);
+     perturb(down, -step);
+     double miles_up, charging_up, miles_down, charging_down;
+     fleetTotals(up, miles_up, charging_up);
+     fleetTotals(down, miles_down, charging_down);
+     double d_miles = (miles_up - miles_down) / (2 * step);
+     double d_charging = (charging_up - charging_down) / (2 * step);
+     EXPECT_NEAR(stats.passenger_miles[param], d_miles, 1e-4 * (1 + std::fabs(d_miles))) << "parameter " << param;
+     EXPECT_NEAR(stats.charge_time[param], d_charging, 1e-4 * (1 + std::fabs(d_charging))) << "parameter " << param;
+ }
+
+ // Test every parameter kind against finite differences on a congested scenario. The specs
+ // are nudged off the table's round values, where events of different vehicles tie and
+ // the totals have kinks that a central difference averages over.
+ TEST(SensitivityTests, MatchesFiniteDifferences) {
+     Scenario scenario;
+     scenario.seed = 17;
+     scenario.fleet_mix = {4, 4, 4, 4, 4};
+     scenario.horizon_hours = 6.3;
+     scenario.sensitivities = true;
+     const size_t specs = scenario.specs.size();
+     for (size_t s = 0; s < specs; s++) {
+         scenario.specs[s].charge_time *= 1 + 0.0713 * (s + 1);
+         scenario.specs[s].battery_capacity *= 1 + 0.0291 * (s + 1);
+     }
+
+     for (size_t s = 0; s < specs; s++) {
+         expectMatchesDifference(scenario, s, 1e-6, [s](Scenario &x, double h) { x.specs[s].charge_time += h; });
+         expectMatchesDifference(scenario, specs + s, 1e-4,
+                                 [s](Scenario &x, double h) { x.specs[s].battery_capacity += h; });
+     }
+     expectMatchesDifference(scenario, 2 * specs, 1e-7,
+                             [](Scenario &x, double h) { x.charger_classes = {{x.chargers, 1.0 + h, {}}}; });
+
+     // Charging is the bottleneck: stronger chargers buy passenger miles, slower charging costs them
+     SimulationContext context;
+     context.run(scenario);
+     EXPECT_GT(context.sensitivities().passenger_miles[2 * specs], 0.0);
+     EXPECT_LT(context.sensitivities().passenger_miles[0], 0.0);
+ }
+
+ // Test that unsupported policies and the default leave the estimates off.
+ TEST(SensitivityTests, OnlyWhereCovered) {
+     Scenario scenario;
+     scenario.seed = 2;
+     SimulationContext context;
+     context.run(scenario);
+     EXPECT_FALSE(context.sensitivities().valid);
+
+     scenario.sensitivities = true;
+     scenario.preemption = true;
+     context.run(scenario);
+     EXPECT_FALSE(context.sensitivities().valid);
+
+     scenario.preemption = false;
+     context.run(scenario);
+     EXPECT_TRUE(context.sensitivities().valid);
+     EXPECT_EQ(context.sensitivities().passenger_miles.size(), 2 * scenario.specs.size() + 1);
+ }
+
+ // Test that replica statistics of the derivatives merge like the other metrics.
+ TEST(SensitivityTests, ReplicaStats) {
+     Scenario scenario;
+     scenario.seed = 5;
+     scenario.sensitivities = true;
+     ReplicaPool pool(2);
+     ScenarioStats whole = pool.run(scenario, 4);
+     ScenarioStats part = pool.run(scenario, 1);
+     part.merge(pool.run(scenario, 3, 1));
+     ASSERT_EQ(whole.sensitivities.passenger_miles.size(), 2 * scenario.specs.size() + 1);
+
+     double sum = 0;
+     for (unsigned int r = 0; r < 4; r++) {
+         Scenario replica = scenario;
+         replica.seed = scenario.seed + r;
+         SimulationContext context;
+         context.run(replica);
+         sum += context.sensitivities().charge_time.back();
+     }
+     EXPECT_NEAR(whole.sensitivities.charge_time.back().mean(), sum / 4, 1e-9);
+     EXPECT_EQ(part.sensitivities.charge_time.back().count, 4u);
+     EXPECT_NEAR(part.sensitivities.passenger_miles[0].mean(), whole.sensitivities.passenger_miles[0].mean(), 1e-9);
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
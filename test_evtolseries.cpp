@@ -0,0 +1,118 @@
+/**
+ * File : test_evtolseries.cpp
+ * Unit tests for LTTB downsampling and the engine's fleet time series.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolbatch.h"
+ #include "evtolengine.h"
+
+ #include <cmath>
+ #include <vector>
+
+ // Integral of a series held constant from each point to the next, and from the last to end.
+ double stepIntegral(const TimeSeries &series, double end) {
+     double sum = 0;
+     for (size_t i = 0; i < series.size(); i++) {
+         double next = i + 1 < series.size() ? series.time[i + 1] : end;
+         sum += series.value[i] * (next - series.time[i]);
+     }
+     return sum;
+ }
+
+ // Test that downsampling keeps the ends and a lone spike, in time order and within the bound.
+ TEST(SeriesTests, DownsampleKeepsShape) {
+     std::vector<double> time, value;
+     for (int i = 0; i < 1000; i++) {
+         time.push_back(i * 0.01);
+         value.push_back(std::sin(i * 0.02) + (i == 537 ? 25.0 : 0.0));
+     }
+     TimeSeries out;
+     downsampleLTTB(time.data(), value.data(), time.size(), 50, out);
+     ASSERT_EQ(out.size(), 50u);
+     EXPECT_DOUBLE_EQ(out.time.front(), 0.0);
+     EXPECT_DOUBLE_EQ(out.time.back(), 9.99);
+     bool spike = false;
+     for (size_t i = 0; i < out.size(); i++) {
+         if (i > 0) {
+             EXPECT_LT(out.time[i - 1], out.time[i]);
+         }
+         spike = spike || out.value[i] > 20;
+     }
+     EXPECT_TRUE(spike);
+
+     downsampleLTTB(time.data(), value.data(), 30, 50, out);
+     EXPECT_EQ(out.size(), 30u); // Short series are kept as they are
+     downsampleLTTB(time.data(), value.data(), 30, 1, out);
+     EXPECT_EQ(out.size(), 2u);
+ }
+
+ // Test that full-resolution series integrate to the per-vehicle totals.
+ TEST(SeriesTests, EngineSeriesMatchTotals) {
+     Scenario scenario;
+     scenario.seed = 13;
+     scenario.series_points = 1000000;
+     for (int mode = 0; mode < 3; mode++) {
+         scenario.preemption = mode == 1;
+         scenario.missions.enabled = mode == 2;
+         SimulationContext context;
+         context.run(scenario);
+         const FleetSeries &series = context.series();
+         VehicleColumns vehicles = context.vehicles();
+         double flight = 0, charging = 0, miles = 0;
+         for (size_t v = 0; v < vehicles.size(); v++) {
+             flight += vehicles.flight_time[v];
+             charging += vehicles.charge_time[v];
+             miles += vehicles.passenger_miles[v];
+         }
+
+         ASSERT_FALSE(series.empty());
+         EXPECT_DOUBLE_EQ(series.airborne.value.front(), 20.0); // Everyone takes off at 0
+         EXPECT_NEAR(stepIntegral(series.airborne, 3.0), flight, 1e-9);
+         EXPECT_NEAR(stepIntegral(series.chargers_busy, 3.0), charging, 1e-9);
+         EXPECT_NEAR(series.passenger_miles.value.back(), miles, 1e-6);
+         for (size_t i = 0; i < series.queue.size(); i++) {
+             EXPECT_GE(series.queue.value[i], 0.0);
+             EXPECT_LE(series.chargers_busy.value[i], 3.0);
+         }
+     }
+
+     scenario.series_points = 0;
+     SimulationContext off;
+     off.run(scenario);
+     EXPECT_TRUE(off.series().empty());
+ }
+
+ // Test that many shifts stay within the point budget and span every shift.
+ TEST(SeriesTests, ShiftsStayBounded) {
+     Scenario scenario;
+     scenario.seed = 4;
+     scenario.series_points = 64;
+     scenario.shifts.count = 12;
+     SimulationContext context;
+     context.run(scenario);
+
+     double miles = 0;
+     for (double m : context.vehicles().passenger_miles) miles += m;
+     for (size_t m = 0; m < kSeriesMetrics; m++) {
+         const TimeSeries &series = context.series().metric(m);
+         EXPECT_EQ(series.size(), 64u);
+         EXPECT_DOUBLE_EQ(series.time.front(), 0.0);
+         EXPECT_DOUBLE_EQ(series.time.back(), 36.0);
+         for (size_t i = 1; i < series.size(); i++) EXPECT_LE(series.time[i - 1], series.time[i]);
+     }
+     EXPECT_NEAR(context.series().passenger_miles.value.back(), miles, 1e-6);
+
+     // The pool reports the series of the batch's first replica
+     ReplicaPool pool(2);
+     ScenarioStats stats = pool.run(scenario, 3);
+     EXPECT_EQ(stats.series.airborne.value, context.series().airborne.value);
+     EXPECT_EQ(stats.series.queue.time, context.series().queue.time);
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
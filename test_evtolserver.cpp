@@ -0,0 +1,244 @@
+/**
+ * File : test_evtolserver.cpp
+ * Unit tests for the replica pool and the what-if query daemon.
+ *
+ * Covers replica aggregation, query parsing, response formatting and a
+ * round trip over a Unix domain socket.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolserver.h"
+ 
+ #include <cstring>
+ #include <string>
+ #include <thread>
+ #include <sys/socket.h>
+ #include <sys/un.h>
+ #include <unistd.h>
+ 
+ // Test that the pool gives the same statistics as running replicas by hand.
+ TEST(ServerTests, PoolMatchesSequentialRuns) {
+     Scenario scenario;
+     scenario.seed = 21;
+     ReplicaPool pool(2);
+     ScenarioStats stats = pool.run(scenario, 8);
+ 
+     RunningStat miles;
+     SimulationContext context;
+     for (int r = 0; r < 8; r++) {
+         Scenario replica = scenario;
+         replica.seed = scenario.seed + r;
+         context.run(replica);
+         double total = 0;
+         for (double m : context.vehicles().passenger_miles) total += m;
+         miles.add(total);
+     }
+ 
+     EXPECT_EQ(stats.replicas, 8u);
+     EXPECT_NEAR(stats.fleet.passenger_miles.mean(), miles.mean(), 1e-6);
+     EXPECT_NEAR(stats.fleet.passenger_miles.stddev(), miles.stddev(), 1e-6);
+     EXPECT_DOUBLE_EQ(stats.fleet.vehicles.mean(), 20.0);
+ }
+ 
+ // Test that split batches merge into the full batch.
+ TEST(ServerTests, BatchesMerge) {
+     Scenario scenario;
+     scenario.seed = 4;
+     ReplicaPool pool(2);
+     ScenarioStats full = pool.run(scenario, 6);
+     ScenarioStats part = pool.run(scenario, 2);
+     part.merge(pool.run(scenario, 4, 2));
+ 
+     EXPECT_EQ(part.replicas, full.replicas);
+     EXPECT_NEAR(part.fleet.passenger_miles.mean(), full.fleet.passenger_miles.mean(), 1e-6);
+     EXPECT_NEAR(part.companies[0].faults.sum, full.companies[0].faults.sum, 1e-9);
+ }
+ 
+ // Test query parsing and validation.
+ TEST(ServerTests, ParseQuery) {
+     ScenarioQuery query, bad;
+     std::string error;
+     ASSERT_TRUE(parseQuery("chargers=5 horizon=2.5 replicas=10 seed=3 mix=1,2,0,0,4", query, error)) << error;
+     EXPECT_EQ(query.scenario.chargers, 5);
+     EXPECT_DOUBLE_EQ(query.scenario.horizon_hours, 2.5);
+     EXPECT_EQ(query.replicas, 10);
+     EXPECT_EQ(query.scenario.fleetSize(), 7);
+ 
+     ASSERT_TRUE(parseQuery("charge=need preempt=0.75", query, error)) << error;
+     EXPECT_TRUE(query.scenario.charge_to_need);
+     EXPECT_TRUE(query.scenario.preemption);
+     EXPECT_DOUBLE_EQ(query.scenario.preempt_soc, 0.75);
+     ASSERT_TRUE(parseQuery("charge=reserve", query, error)) << error;
+     EXPECT_TRUE(query.scenario.reservations);
+     EXPECT_FALSE(query.scenario.charge_to_need);
+ 
+     ASSERT_TRUE(parseQuery("trip=lognormal:12.5 turnaround=0.2 reserve=0.3", query, error)) << error;
+     EXPECT_TRUE(query.scenario.missions.enabled);
+     EXPECT_EQ(query.scenario.missions.distribution, TripDistribution::Lognormal);
+     EXPECT_DOUBLE_EQ(query.scenario.missions.mean_miles, 12.5);
+     EXPECT_FALSE(parseQuery("trip=gamma:3", bad, error));
+ 
+     ASSERT_TRUE(parseQuery("repair=2:0.75", query, error)) << error;
+     EXPECT_TRUE(query.scenario.maintenance.enabled);
+     EXPECT_EQ(query.scenario.maintenance.bays, 2);
+     EXPECT_DOUBLE_EQ(query.scenario.maintenance.repair_hours, 0.75);
+     EXPECT_FALSE(parseQuery("repair=2", bad, error));
+
+     ASSERT_TRUE(parseQuery("shifts=30:0.002", query, error)) << error;
+     EXPECT_EQ(query.scenario.shifts.count, 30);
+     EXPECT_DOUBLE_EQ(query.scenario.shifts.fade_per_cycle, 0.002);
+     EXPECT_FALSE(parseQuery("shifts=0", bad, error));
+
+     ASSERT_TRUE(parseQuery("price=0.1,0.3 sitecap=900", query, error)) << error;
+     EXPECT_TRUE(query.scenario.energy.enabled);
+     EXPECT_EQ(query.scenario.energy.hourly_price.size(), 2u);
+     EXPECT_DOUBLE_EQ(query.scenario.energy.site_power_kw, 900);
+     EXPECT_FALSE(parseQuery("price=0.1,-1", bad, error));
+
+     ASSERT_TRUE(parseQuery("series=200", query, error)) << error;
+     EXPECT_EQ(query.scenario.series_points, 200);
+     EXPECT_FALSE(parseQuery("series=1", bad, error));
+     ASSERT_TRUE(parseQuery("sensitivity=on", query, error)) << error;
+     EXPECT_TRUE(query.scenario.sensitivities);
+     EXPECT_FALSE(parseQuery("sensitivity=yes", bad, error));
+     ASSERT_TRUE(parseQuery("estimate=1.1,0.95", query, error)) << error;
+     EXPECT_EQ(query.estimate, (std::vector<double>{1.1, 0.95}));
+     EXPECT_FALSE(parseQuery("estimate=1,0", bad, error));
+ 
+     EXPECT_FALSE(parseQuery("replicas=0", bad, error));
+     EXPECT_FALSE(parseQuery("colour=red", bad, error));
+     EXPECT_FALSE(parseQuery("mix=1,x", bad, error));
+     EXPECT_FALSE(parseQuery("preempt=1.5", bad, error));
+     EXPECT_FALSE(parseQuery("seed=1 horizon=1e12", bad, error));
+     EXPECT_FALSE(parseQuery("seed=1 horizon=inf", bad, error));
+     EXPECT_FALSE(parseQuery("horizon=nan", bad, error));
+ }
+ 
+ // Test that repair queries report the bay totals over the replicas, and other queries do not.
+ TEST(ServerTests, ReportsMaintenance) {
+     ScenarioQuery query, plain;
+     std::string error;
+     ASSERT_TRUE(parseQuery("seed=2 replicas=4 repair=1:0.5", query, error)) << error;
+     ReplicaPool pool(2);
+     ScenarioStats stats = pool.run(query.scenario, query.replicas);
+     EXPECT_EQ(stats.maintenance.repairs.count, 4u);
+     EXPECT_GT(stats.maintenance.repairs.sum, 0.0);
+     EXPECT_LE(stats.maintenance.repairs.sum, stats.fleet.faults.sum); // Late faults may never reach a bay
+     EXPECT_GT(stats.maintenance.bay_hours.mean(), 0.0);
+     EXPECT_NE(formatStats(stats).find("\nmaintenance repairs="), std::string::npos);
+
+     ASSERT_TRUE(parseQuery("seed=2 replicas=4", plain, error)) << error;
+     EXPECT_EQ(formatStats(pool.run(plain.scenario, plain.replicas)).find("maintenance"), std::string::npos);
+ }
+
+ // Test that demand-mode batches report every request as served or dropped.
+ TEST(ServerTests, ReportsDemand) {
+     Scenario scenario;
+     scenario.seed = 8;
+     scenario.fleet_mix = {3, 3, 3, 3, 0};
+     scenario.demand.enabled = true;
+     scenario.demand.vertiports = {{0, 0, 1, 1.0}, {20, 0, 1, 1.0}, {10, 17, 1, 1.0}};
+     scenario.demand.hourly_rate = {40.0};
+     ReplicaPool pool(2);
+     ScenarioStats stats = pool.run(scenario, 4);
+
+     EXPECT_EQ(stats.demand.requests.count, 4u);
+     EXPECT_GT(stats.demand.requests.mean(), 0.0);
+     EXPECT_DOUBLE_EQ(stats.demand.served.sum + stats.demand.dropped.sum, stats.demand.requests.sum);
+     EXPECT_GT(stats.demand.dropped.sum, 0.0);
+     EXPECT_NE(formatStats(stats).find("\ndemand requests="), std::string::npos);
+ }
+
+ // Test that metered queries report energy, cost and peak site demand over the replicas.
+ TEST(ServerTests, ReportsEnergy) {
+     ScenarioQuery capped, uncapped;
+     std::string error;
+     ASSERT_TRUE(parseQuery("seed=6 replicas=3 chargers=6 price=0.1,0.4 sitecap=1000", capped, error)) << error;
+     ASSERT_TRUE(parseQuery("seed=6 replicas=3 chargers=6 price=0.1,0.4", uncapped, error)) << error;
+     ReplicaPool pool(2);
+     ScenarioStats stats = pool.run(capped.scenario, capped.replicas);
+     ScenarioStats free = pool.run(uncapped.scenario, uncapped.replicas);
+
+     EXPECT_EQ(stats.energy.energy_kwh.count, 3u);
+     EXPECT_GT(stats.energy.cost.mean(), 0.1 * stats.energy.energy_kwh.mean() - 1e-9);
+     EXPECT_LE(stats.energy.cost.mean(), 0.4 * stats.energy.energy_kwh.mean() + 1e-9);
+     EXPECT_LE(stats.energy.peak_kw.mean(), 1000 + 1e-6); // Above any one session's draw, so the cap holds
+     EXPECT_GT(free.energy.peak_kw.mean(), 1000);
+     EXPECT_GT(stats.energy.power_wait_hours.mean(), 0.0);
+     EXPECT_NE(formatStats(stats).find("\nenergy kwh="), std::string::npos);
+ }
+
+ // Test that multi-shift queries report per-shift totals and battery wear.
+ TEST(ServerTests, ReportsShifts) {
+     ScenarioQuery single, faded;
+     std::string error;
+     ASSERT_TRUE(parseQuery("seed=4 replicas=3 shifts=3:0.01", faded, error)) << error;
+     ASSERT_TRUE(parseQuery("seed=4 replicas=3", single, error)) << error;
+     ReplicaPool pool(2);
+     ScenarioStats stats = pool.run(faded.scenario, faded.replicas);
+
+     EXPECT_EQ(stats.shifts.passenger_miles.count, 3u);
+     EXPECT_NEAR(3 * stats.shifts.passenger_miles.mean(), stats.fleet.passenger_miles.mean(), 1e-6);
+     EXPECT_LE(stats.shifts.min_passenger_miles.mean(), stats.shifts.passenger_miles.mean());
+     EXPECT_LT(stats.shifts.mean_capacity.mean(), 1.0);
+     EXPECT_LE(stats.shifts.min_capacity.mean(), stats.shifts.mean_capacity.mean());
+     EXPECT_NE(formatStats(stats).find("\nshifts passenger_miles="), std::string::npos);
+     EXPECT_EQ(formatStats(pool.run(single.scenario, single.replicas)).find("\nshifts "), std::string::npos);
+ }
+
+ // Test that a year-long query with many chargers runs on a capped occupancy bitmap.
+ TEST(ServerTests, AnswersLongHorizons) {
+     ReplicaPool pool(1);
+     QueryServer server(pool);
+     std::string reply = server.handle("seed=2 horizon=8784 chargers=100000 replicas=1");
+     EXPECT_EQ(reply.compare(0, 3, "ok "), 0) << reply;
+     EXPECT_NE(reply.find("\nchargers utilization="), std::string::npos);
+ }
+
+ // Test that horizons too long to simulate are answered with an error instead of running.
+ TEST(ServerTests, RejectsUnboundedHorizons) {
+     ReplicaPool pool(1);
+     QueryServer server(pool);
+     EXPECT_EQ(server.handle("seed=1 horizon=1e12").compare(0, 6, "error "), 0);
+     EXPECT_EQ(server.handle("seed=1 horizon=inf").compare(0, 6, "error "), 0);
+     EXPECT_EQ(server.handle("seed=1 horizon=2").compare(0, 3, "ok "), 0);
+ }
+
+ // Test a request/response round trip over the socket.
+ TEST(ServerTests, SocketRoundTrip) {
+     std::string path = "/tmp/evtold_test_" + std::to_string(::getpid()) + ".sock";
+     ReplicaPool pool(1);
+     QueryServer server(pool);
+     std::string error;
+     ASSERT_TRUE(server.listen(path, error)) << error;
+     std::thread serving([&server] { server.serve(); });
+ 
+     int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+     sockaddr_un addr{};
+     addr.sun_family = AF_UNIX;
+     std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+     ASSERT_EQ(::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+ 
+     std::string request = "ping\nseed=1 replicas=3 mix=2,2,2,2,2\n";
+     ASSERT_EQ(::write(fd, request.data(), request.size()), static_cast<ssize_t>(request.size()));
+     ::shutdown(fd, SHUT_WR);
+ 
+     std::string response;
+     char chunk[1024];
+     ssize_t n;
+     while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) response.append(chunk, n);
+     ::close(fd);
+     server.stop();
+     serving.join();
+ 
+     EXPECT_EQ(response.find("pong\nend\n"), 0u);
+     EXPECT_NE(response.find("ok replicas=3"), std::string::npos);
+     EXPECT_NE(response.find("company 4 vehicles=2,0"), std::string::npos);
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
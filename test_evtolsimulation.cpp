@@ -6,11 +6,14 @@
  * simulation, including flight time calculations, charging queue behavior,
  * and simulation constraints.
  *
+ * Every test builds its own ChargingScheduler and VirtualClock, so tests do
+ * not sleep and can run in any order (--gtest_shuffle).
+ *
  * Uses Google Test Framework.
  */
 
  #include "gtest/gtest.h"
- #include "evtolsimulation.cpp"
+ #include "evtolsimulation.h"
  #include <unordered_set>
  
  /**
@@ -20,8 +23,10 @@
   * and energy usage, ensuring no vehicle flies longer than 3 hours.
   */
  TEST(EVTOLTests, FlightTimeCalculation) {
+     ChargingScheduler scheduler;
+     VirtualClock clock;
      EVTOL_Spec spec = manufacturers[0]; // Alpha Company
-     EVTOL vehicle(spec, 1);
+     EVTOL vehicle(spec, 1, scheduler, clock);
      
      vehicle.runFlightCycle();
      
@@ -35,13 +40,15 @@
   * Ensures that vehicles enter the charging queue properly.
   */
  TEST(EVTOLTests, ChargingQueueBehavior) {
-     EVTOL vehicle1(manufacturers[1], 1);
-     EVTOL vehicle2(manufacturers[2], 2);
+     ChargingScheduler scheduler;
+     VirtualClock clock;
+     EVTOL vehicle1(manufacturers[1], 1, scheduler, clock);
+     EVTOL vehicle2(manufacturers[2], 2, scheduler, clock);
  
      vehicle1.queueForCharging();
      vehicle2.queueForCharging();
      
-     EXPECT_EQ(chargingQueue.size(), 2);
+     EXPECT_EQ(scheduler.queueSize(), 2u);
  }
  
  /**
@@ -51,10 +58,12 @@
   * available charger limit.
   */
  TEST(EVTOLTests, ChargerAllocation) {
-     EVTOL vehicle1(manufacturers[0], 1);
-     EVTOL vehicle2(manufacturers[1], 2);
-     EVTOL vehicle3(manufacturers[2], 3);
-     EVTOL vehicle4(manufacturers[3], 4); // This should wait
+     ChargingScheduler scheduler;
+     VirtualClock clock;
+     EVTOL vehicle1(manufacturers[0], 1, scheduler, clock);
+     EVTOL vehicle2(manufacturers[1], 2, scheduler, clock);
+     EVTOL vehicle3(manufacturers[2], 3, scheduler, clock);
+     EVTOL vehicle4(manufacturers[3], 4, scheduler, clock); // This should wait
  
      vehicle1.queueForCharging();
      vehicle2.queueForCharging();
@@ -62,9 +71,9 @@
      vehicle4.queueForCharging();
  
      std::unordered_set<int> uniqueVehicles;
-     while (!chargingQueue.empty()) {
-         uniqueVehicles.insert(chargingQueue.top().second);
-         chargingQueue.pop();
+     int vehicle_id;
+     while (scheduler.popNext(vehicle_id)) {
+         uniqueVehicles.insert(vehicle_id);
      }
      EXPECT_EQ(uniqueVehicles.size(), 4); // Ensure unique vehicles are counted
  }
@@ -72,11 +81,58 @@
  
 // Test that flight time does not exceed 3 hours due to charging delays.
  TEST(EVTOLTests, MaxSimulationTime) {
-     EVTOL vehicle(manufacturers[2], 1);
+     ChargingScheduler scheduler;
+     VirtualClock clock;
+     EVTOL vehicle(manufacturers[2], 1, scheduler, clock);
      vehicle.runFlightCycle();
      EXPECT_LE(vehicle.total_flight_time + vehicle.total_charge_time, 3.0);
  }
  
+// Test that charging advances the injected clock instead of sleeping.
+ TEST(EVTOLTests, ChargingAdvancesVirtualClock) {
+     ChargingScheduler scheduler;
+     VirtualClock clock;
+     EVTOL vehicle(manufacturers[1], 1, scheduler, clock); // Bravo Company
+     vehicle.runFlightCycle();
+ 
+     EXPECT_GT(vehicle.total_charge_time, 0.0);
+     EXPECT_DOUBLE_EQ(clock.elapsed(), vehicle.total_charge_time);
+     EXPECT_EQ(scheduler.availableChargers(), 3); // Every charger was returned
+ }
+ 
+// Test that a full fleet runs against a virtual clock without sharing state.
+ TEST(EVTOLTests, FleetRunsOnVirtualClock) {
+     VirtualClock clock;
+     SimulationManager sim(clock);
+     sim.deployVehicles();
+     sim.startSimulation();
+ 
+     ASSERT_EQ(sim.vehicles.size(), 20u);
+     for (const auto &vehicle : sim.vehicles) {
+         EXPECT_LE(vehicle.total_flight_time + vehicle.total_charge_time, 3.0 + 1e-9);
+     }
+ }
+ 
+// Test that a custom scenario controls fleet size, window and results.
+ TEST(EVTOLTests, ScenarioResults) {
+     Scenario scenario;
+     scenario.vehicle_count = 5;
+     scenario.horizon_hours = 1.0;
+     scenario.seed = 42;
+     VirtualClock clock;
+     SimulationManager sim(scenario, clock);
+     sim.deployVehicles();
+     sim.startSimulation();
+ 
+     std::vector<VehicleStats> results = sim.results();
+     ASSERT_EQ(results.size(), 5u);
+     for (size_t i = 0; i < results.size(); i++) {
+         EXPECT_EQ(results[i].vehicle_id, static_cast<int>(i) + 1);
+         EXPECT_LE(results[i].flight_time + results[i].charge_time, 1.0 + 1e-9);
+         EXPECT_GT(results[i].distance, 0.0);
+     }
+ }
+ 
  int main(int argc, char **argv) {
      ::testing::InitGoogleTest(&argc, argv);
      return RUN_ALL_TESTS();
@@ -0,0 +1,78 @@
+/**
+ * File : test_evtolspatial.cpp
+ * Unit tests for the vertiport grid and deadhead dispatch.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+ 
+ #include <cmath>
+ #include <random>
+ 
+ // Test nearest-vertiport lookups against a linear scan.
+ TEST(SpatialTests, NearestMatchesLinearScan) {
+     std::mt19937 gen(9);
+     std::uniform_real_distribution<double> coord(-50.0, 50.0);
+     std::vector<Vertiport> ports;
+     for (int i = 0; i < 200; i++) ports.push_back({coord(gen), coord(gen), 1, 1.0});
+     VertiportGrid grid;
+     grid.build(ports);
+ 
+     for (int q = 0; q < 200; q++) {
+         double x = coord(gen) * 1.2, y = coord(gen) * 1.2;
+         int expected = 0;
+         for (int i = 1; i < 200; i++) {
+             if (std::hypot(ports[i].x - x, ports[i].y - y) < std::hypot(ports[expected].x - x, ports[expected].y - y)) {
+                 expected = i;
+             }
+         }
+         EXPECT_EQ(grid.nearest(x, y), expected);
+     }
+ }
+ 
+ // Test that idle searches only consider sites with idle vehicles that pass the filter.
+ TEST(SpatialTests, NearestIdleRespectsCountsAndFilter) {
+     std::vector<Vertiport> ports = {{0, 0, 1, 1}, {5, 0, 1, 1}, {10, 0, 1, 1}, {40, 0, 1, 1}};
+     VertiportGrid grid;
+     grid.build(ports, 4.0);
+     auto any = [](int, double) { return true; };
+ 
+     EXPECT_EQ(grid.nearestIdle(0, 0, 100, any), -1);
+     grid.addIdle(2, 1);
+     grid.addIdle(3, 1);
+     EXPECT_EQ(grid.nearestIdle(0, 0, 100, any), 2);
+     EXPECT_EQ(grid.nearestIdle(0, 0, 100, [](int site, double) { return site != 2; }), 3);
+     EXPECT_EQ(grid.nearestIdle(0, 0, 20, [](int site, double) { return site != 2; }), -1);
+     grid.addIdle(2, -1);
+     EXPECT_EQ(grid.nearestIdle(12, 0, 100, any), 3);
+ }
+ 
+ // Test that deadheading serves requests at vertiports without vehicles.
+ TEST(SpatialTests, DeadheadServesEmptyVertiports) {
+     Scenario scenario;
+     scenario.seed = 37;
+     scenario.fleet_mix = {0, 0, 3}; // Charlie: long range
+     scenario.demand.enabled = true;
+     // Vehicles start at the first three vertiports; the last two never have one at first
+     scenario.demand.vertiports = {{0, 0, 2, 0.1}, {10, 0, 2, 0.1}, {0, 10, 2, 0.1}, {10, 10, 2, 1.0}, {5, 20, 2, 1.0}};
+     scenario.demand.hourly_rate = {4.0};
+     scenario.demand.max_wait_hours = 0.05;
+ 
+     SimulationContext without;
+     without.run(scenario);
+     scenario.demand.max_deadhead_miles = 30;
+     SimulationContext with;
+     with.run(scenario);
+ 
+     EXPECT_GT(with.demandStats().deadheads, 0u);
+     EXPECT_GT(with.demandStats().deadhead_miles, 0.0);
+     EXPECT_EQ(without.demandStats().deadheads, 0u);
+     EXPECT_GT(with.demandStats().served, without.demandStats().served);
+ }
+ 
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,82 @@
+/**
+ * File : test_evtolstepper.cpp
+ * Unit tests for the fixed-step engine and its SIMD kernels.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolengine.h"
+ #include "evtolfidelity.h"
+ #include "evtolstepper.h"
+
+ #include <string>
+
+ // Test that every kernel the CPU has evolves the fleet exactly as the scalar loop does.
+ TEST(StepperTests, KernelsAgree) {
+     Scenario scenario;
+     scenario.seed = 5;
+     scenario.vehicle_count = 1003; // Not a whole number of registers
+     scenario.chargers = 90;
+     scenario.horizon_hours = 7.3;
+     std::string error;
+
+     SteppedContext scalar(SimdLevel::Scalar);
+     ASSERT_EQ(scalar.kernel(), SimdLevel::Scalar);
+     ASSERT_TRUE(scalar.run(scenario, 0.01, error)) << error;
+     const SteppedStats &expected = scalar.stats();
+     EXPECT_EQ(expected.vehicles, 1003);
+     EXPECT_EQ(expected.steps, 730u);
+
+     for (SimdLevel kernel : {SimdLevel::Avx2, SimdLevel::Avx512, SimdLevel::Auto}) {
+         SteppedContext context(kernel);
+         ASSERT_TRUE(context.run(scenario, 0.01, error)) << error;
+         const SteppedStats &stats = context.stats();
+         EXPECT_EQ(stats.charges, expected.charges);
+         EXPECT_NEAR(stats.flight_time, expected.flight_time, 1e-9 * expected.flight_time);
+         EXPECT_NEAR(stats.distance, expected.distance, 1e-9 * expected.distance);
+         EXPECT_NEAR(stats.charge_time, expected.charge_time, 1e-9 * expected.charge_time);
+         EXPECT_NEAR(stats.passenger_miles, expected.passenger_miles, 1e-9 * expected.passenger_miles);
+     }
+ }
+
+ // Test that fine steps converge to the event engine, and coarse ones lose at most a step per cycle.
+ TEST(StepperTests, ConvergesToEngine) {
+     Scenario scenario;
+     scenario.seed = 9;
+     scenario.fleet_mix = {40, 25, 30, 15, 20};
+     scenario.chargers = 12;
+     scenario.horizon_hours = 5;
+     SimulationContext engine;
+     engine.run(scenario);
+     double miles = 0, charging = 0;
+     for (double m : engine.vehicles().passenger_miles) miles += m;
+     for (double hours : engine.vehicles().charge_time) charging += hours;
+
+     SteppedContext context;
+     std::string error;
+     ASSERT_TRUE(context.run(scenario, 1e-4, error)) << error;
+     EXPECT_NEAR(context.stats().passenger_miles, miles, 0.005 * miles);
+     EXPECT_NEAR(context.stats().charge_time, charging, 0.01 * charging);
+
+     ASSERT_TRUE(context.run(scenario, 0.05, error)) << error;
+     EXPECT_LE(context.stats().passenger_miles, miles * 1.001);
+     EXPECT_GT(context.stats().passenger_miles, miles * 0.9);
+ }
+
+ // Test the scenarios and steps the stepper refuses.
+ TEST(StepperTests, Rejects) {
+     Scenario scenario;
+     SteppedContext context;
+     std::string error;
+     EXPECT_FALSE(context.run(scenario, 0.0, error));
+     EXPECT_FALSE(context.run(scenario, 1e-12, error));
+     scenario.missions.enabled = true;
+     EXPECT_FALSE(context.run(scenario, 0.01, error));
+     EXPECT_FALSE(error.empty());
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
@@ -0,0 +1,136 @@
+/**
+ * File : test_evtolsurrogate.cpp
+ * Unit tests for sweep surrogates and the daemon's estimate queries.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolserver.h"
+ #include "evtolsurrogate.h"
+
+ #include <sstream>
+ #include <string>
+ #include <vector>
+
+ // Exact quadratic in two factors, with an interaction.
+ double quadratic(double a, double b) {
+     return 3 + 2 * a - b + 0.5 * a * b + a * a;
+ }
+
+ // Test that an exact quadratic is recovered with no error, and only inside its ranges.
+ TEST(SurrogateTests, RecoversQuadratic) {
+     SweepPlan plan;
+     plan.parameters = {{SpecField::CruiseSpeed, 0.5, 1.5}, {SpecField::ChargeTime, 1.0, 3.0}};
+     plan.points = 30;
+     std::vector<double> factors = sweepPoints(plan);
+     SweepTable table;
+     table.columns = {"cruise_speed", "charge_time", "y_mean", "y_sd"};
+     for (size_t i = 0; i < 30; i++) {
+         double a = factors[i * 2], b = factors[i * 2 + 1];
+         table.cells.insert(table.cells.end(), {a, b, quadratic(a, b), 0.0});
+     }
+
+     Scenario base;
+     SurrogateModel model;
+     std::string error;
+     ASSERT_TRUE(fitSurrogate(base, plan, table, model, error)) << error;
+     EXPECT_EQ(model.terms(), 6u);
+     EXPECT_EQ(model.outputs, (std::vector<std::string>{"y"}));
+
+     SurrogateEstimate estimate;
+     double point[] = {0.73, 2.41};
+     ASSERT_TRUE(estimateSurrogate(model, point, estimate));
+     EXPECT_NEAR(estimate.value[0], quadratic(0.73, 2.41), 1e-6);
+     EXPECT_NEAR(estimate.error[0], 0.0, 1e-6);
+
+     double outside[] = {1.6, 2.0};
+     EXPECT_FALSE(estimateSurrogate(model, outside, estimate));
+
+     table.cells.resize(6 * 4); // Six points cannot pin down six terms and a residual
+     EXPECT_FALSE(fitSurrogate(base, plan, table, model, error));
+ }
+
+ // Test that a written model reads back to the same estimates.
+ TEST(SurrogateTests, RoundTrip) {
+     Scenario base;
+     base.seed = 2;
+     base.fleet_mix = {2, 2, 2, 2, 2};
+     SweepPlan plan;
+     plan.parameters = {{SpecField::BatteryCapacity, 0.8, 1.2, 1}, {SpecField::EnergyUse, 0.9, 1.1}};
+     plan.points = 20;
+     plan.replicas = 2;
+     ReplicaPool pool(2);
+     SweepTable table;
+     SurrogateModel model, read;
+     std::string error;
+     ASSERT_TRUE(runSweep(pool, base, plan, table, error)) << error;
+     ASSERT_TRUE(fitSurrogate(base, plan, table, model, error)) << error;
+
+     std::stringstream file;
+     writeSurrogate(file, model);
+     ASSERT_TRUE(readSurrogate(file, read, error)) << error;
+     EXPECT_EQ(read.base_key, model.base_key);
+     EXPECT_EQ(read.parameters[0].spec, 1);
+     EXPECT_EQ(read.outputs, model.outputs);
+     EXPECT_EQ(read.points, 20u);
+
+     SurrogateEstimate a, b;
+     double point[] = {1.05, 0.93};
+     ASSERT_TRUE(estimateSurrogate(model, point, a));
+     ASSERT_TRUE(estimateSurrogate(read, point, b));
+     EXPECT_EQ(a.value, b.value);
+     EXPECT_EQ(a.error, b.error);
+
+     std::istringstream truncated(file.str().substr(0, file.str().size() / 2));
+     EXPECT_FALSE(readSurrogate(truncated, read, error));
+     std::istringstream other("evtolsweep 1\n");
+     EXPECT_FALSE(readSurrogate(other, read, error));
+ }
+
+ // Test that the daemon answers covered estimates from the model and simulates the rest.
+ TEST(SurrogateTests, ServerFallsBack) {
+     ScenarioQuery base;
+     std::string error;
+     ASSERT_TRUE(parseQuery("seed=1 chargers=3 mix=2,2,2,2,2", base, error)) << error;
+     SweepPlan plan;
+     plan.parameters = {{SpecField::CruiseSpeed, 0.8, 1.2}, {SpecField::ChargeTime, 0.8, 1.2}};
+     plan.points = 60;
+     plan.replicas = 4;
+     ReplicaPool pool(2);
+     SweepTable table;
+     SurrogateModel model;
+     ASSERT_TRUE(runSweep(pool, base.scenario, plan, table, error)) << error;
+     ASSERT_TRUE(fitSurrogate(base.scenario, plan, table, model, error)) << error;
+
+     // The estimate should be within a few of its errors of a fresh simulation
+     SurrogateEstimate estimate;
+     double factors[] = {1.1, 0.9};
+     ASSERT_TRUE(estimateSurrogate(model, factors, estimate));
+     Scenario point;
+     applySweepPoint(base.scenario, plan, factors, point);
+     ScenarioStats simulated = pool.run(point, 4);
+     EXPECT_EQ(model.outputs[4], "passenger_miles");
+     EXPECT_GT(estimate.error[4], 0.0);
+     EXPECT_NEAR(estimate.value[4], simulated.fleet.passenger_miles.mean(), 4 * estimate.error[4]);
+
+     QueryServer server(pool, nullptr, &model);
+     std::string response = server.handle("seed=7 chargers=3 mix=2,2,2,2,2 estimate=1.1,0.9");
+     EXPECT_EQ(response.substr(0, 32), "ok surrogate points=60\nestimate ");
+     EXPECT_NE(response.find(" passenger_miles="), std::string::npos);
+
+     // Outside the ranges, or around another scenario, the point is simulated
+     response = server.handle("seed=1 replicas=4 chargers=3 mix=2,2,2,2,2 estimate=1.3,0.9");
+     EXPECT_EQ(response.substr(0, 13), "ok replicas=4");
+     response = server.handle("seed=1 chargers=4 mix=2,2,2,2,2 estimate=1.1,0.9");
+     EXPECT_EQ(response.substr(0, 13), "ok replicas=1");
+     EXPECT_EQ(server.handle("estimate=1.1").substr(0, 5), "error");
+
+     QueryServer plain(pool);
+     EXPECT_EQ(plain.handle("estimate=1.1,0.9"), "error no surrogate loaded\nend\n");
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }
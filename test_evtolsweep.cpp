@@ -0,0 +1,121 @@
+/**
+ * File : test_evtolsweep.cpp
+ * Unit tests for sweep designs and the sweep runner.
+ *
+ * Uses Google Test Framework.
+ */
+
+ #include "gtest/gtest.h"
+ #include "evtolsweep.h"
+
+ #include <set>
+ #include <sstream>
+ #include <string>
+ #include <vector>
+
+ // Test that a Latin hypercube hits every stratum of every parameter exactly once.
+ TEST(SweepTests, LatinHypercubeStrata) {
+     SweepPlan plan;
+     plan.parameters = {{SpecField::CruiseSpeed, 0.5, 1.5}, {SpecField::ChargeTime, 1.0, 3.0, 2}};
+     plan.points = 40;
+     plan.seed = 7;
+     std::vector<double> factors = sweepPoints(plan);
+     ASSERT_EQ(factors.size(), 80u);
+
+     for (size_t p = 0; p < 2; p++) {
+         const SweepParameter &parameter = plan.parameters[p];
+         std::set<int> strata;
+         for (size_t i = 0; i < 40; i++) {
+             double x = (factors[i * 2 + p] - parameter.low) / (parameter.high - parameter.low);
+             ASSERT_GE(x, 0.0);
+             ASSERT_LT(x, 1.0);
+             strata.insert(static_cast<int>(x * 40));
+         }
+         EXPECT_EQ(strata.size(), 40u);
+     }
+     EXPECT_EQ(sweepPoints(plan), factors); // Same seed, same design
+ }
+
+ // Test grid layout, point application and parameter parsing.
+ TEST(SweepTests, GridAndApply) {
+     SweepPlan plan;
+     plan.design = SweepDesign::Grid;
+     plan.levels = 3;
+     plan.parameters = {{SpecField::BatteryCapacity, 0.5, 1.5}, {SpecField::FaultProbability, 1.0, 100.0, 1}};
+     ASSERT_EQ(sweepPointCount(plan), 9u);
+     std::vector<double> factors = sweepPoints(plan);
+     EXPECT_DOUBLE_EQ(factors[0], 0.5);
+     EXPECT_DOUBLE_EQ(factors[1], 1.0);
+     EXPECT_DOUBLE_EQ(factors[5 * 2], 1.0); // Level 1 of the first parameter
+     EXPECT_DOUBLE_EQ(factors[5 * 2 + 1], 100.0);
+
+     Scenario base, point;
+     applySweepPoint(base, plan, factors.data() + 8 * 2, point);
+     EXPECT_DOUBLE_EQ(point.specs[0].battery_capacity, 1.5 * base.specs[0].battery_capacity);
+     EXPECT_DOUBLE_EQ(point.specs[0].fault_probability, base.specs[0].fault_probability);
+     EXPECT_DOUBLE_EQ(point.specs[1].fault_probability, 1.0); // Capped
+
+     SweepParameter parameter;
+     std::string error;
+     ASSERT_TRUE(parseSweepParameter("energy_use:0.9:1.1:3", parameter, error)) << error;
+     EXPECT_EQ(parameter.field, SpecField::EnergyUse);
+     EXPECT_DOUBLE_EQ(parameter.high, 1.1);
+     EXPECT_EQ(parameter.spec, 3);
+     EXPECT_FALSE(parseSweepParameter("wingspan:1:2", parameter, error));
+     EXPECT_FALSE(parseSweepParameter("charge_time:1", parameter, error));
+     EXPECT_FALSE(parseSweepParameter("cruise_speed:0.8:1.2:1e20", parameter, error));
+     EXPECT_FALSE(parseSweepParameter("cruise_speed:0.8:1.2:nan", parameter, error));
+     EXPECT_FALSE(parseSweepParameter("cruise_speed:0.8:1.2:1.5", parameter, error));
+     EXPECT_FALSE(parseSweepParameter("cruise_speed:0.8:inf", parameter, error));
+     EXPECT_FALSE(parseSweepParameter("cruise_speed:nan:1.2", parameter, error));
+
+     plan.parameters[1].spec = 9;
+     EXPECT_FALSE(validateSweep(base, plan, error));
+     plan.parameters[1].spec = -1;
+     plan.levels = 10000;
+     EXPECT_FALSE(validateSweep(base, plan, error)); // 10^8 points
+ }
+
+ // Test that each row matches its point run on its own, over several pool blocks.
+ TEST(SweepTests, RowsMatchPointRuns) {
+     Scenario base;
+     base.seed = 3;
+     base.fleet_mix = {2, 2, 2, 2, 2};
+     SweepPlan plan;
+     plan.parameters = {{SpecField::CruiseSpeed, 0.8, 1.2}, {SpecField::EnergyUse, 0.9, 1.1, 0}};
+     plan.points = 300;
+     plan.replicas = 3;
+     ReplicaPool pool(3);
+     SweepTable table;
+     std::string error;
+     size_t reported = 0;
+     ASSERT_TRUE(runSweep(pool, base, plan, table, error, [&](size_t done, size_t) { reported = done; })) << error;
+     ASSERT_EQ(table.rows(), 300u);
+     ASSERT_EQ(table.columns.size(), 2u + 12u);
+     EXPECT_EQ(table.columns[1], "energy_use@0");
+     EXPECT_EQ(reported, 300u);
+
+     std::vector<double> factors = sweepPoints(plan);
+     for (size_t i : {0u, 255u, 299u}) {
+         Scenario point;
+         applySweepPoint(base, plan, factors.data() + i * 2, point);
+         ScenarioStats alone = pool.run(point, 3);
+         const double *row = table.row(i);
+         EXPECT_DOUBLE_EQ(row[0], factors[i * 2]);
+         EXPECT_DOUBLE_EQ(row[2], alone.fleet.flight_time.mean());
+         EXPECT_DOUBLE_EQ(row[10], alone.fleet.passenger_miles.mean());
+         EXPECT_DOUBLE_EQ(row[11], alone.fleet.passenger_miles.stddev());
+     }
+
+     std::ostringstream out;
+     writeSweepTable(out, table);
+     std::istringstream lines(out.str());
+     std::string header;
+     std::getline(lines, header);
+     EXPECT_EQ(header.substr(0, 25), "cruise_speed\tenergy_use@0");
+ }
+
+ int main(int argc, char **argv) {
+     ::testing::InitGoogleTest(&argc, argv);
+     return RUN_ALL_TESTS();
+ }